@@ -0,0 +1,91 @@
+#ifndef _TL_CHECKPOINT_
+#define _TL_CHECKPOINT_
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstdio>
+#include <thread>
+#include "../spectral/message.h"
+
+namespace file{
+
+/*! @brief Write checkpoints of a solver in the background
+ *
+ * The state of the solver is serialised into memory by the calling thread
+ * and written to disk by a background thread while the solver continues.
+ * The file is first written to name.tmp and then renamed, so a job that is 
+ * killed during the write keeps the last complete checkpoint.
+ */
+class Checkpoint
+{
+  public:
+    /*! @brief Prepare checkpoints
+     *
+     * @param name The name of the checkpoint file
+     */
+    Checkpoint( const std::string& name): name_( name){}
+    /*! @brief Wait for the last write to finish
+     */
+    ~Checkpoint( ){ wait();}
+    /*! @brief Write a checkpoint
+     *
+     * Returns as soon as the state is copied, i.e. waits only 
+     * if the write of the last checkpoint is not yet finished.
+     * @tparam Solver A class with a checkpoint( std::ostream&, double) const method
+     * @param solver The solver 
+     * @param time The time of the current fields
+     */
+    template< class Solver>
+    void write( const Solver& solver, const double time)
+    {
+        std::ostringstream os( std::ios::binary);
+        solver.checkpoint( os, time);
+        wait();
+        buffer_ = os.str();
+        writer_ = std::thread( [this]()
+        {
+            const std::string tmp = name_ + ".tmp";
+            std::ofstream file( tmp.c_str(), std::ios::binary);
+            file.write( buffer_.data(), buffer_.size());
+            file.close();
+            if( !file || std::rename( tmp.c_str(), name_.c_str()) != 0)
+                std::cerr << "WARNING: Checkpoint "<<name_<<" could not be written!\n";
+        });
+    }
+    /*! @brief Wait until the last checkpoint is on disk
+     */
+    void wait( )
+    {
+        if( writer_.joinable())
+            writer_.join();
+    }
+  private:
+    Checkpoint( const Checkpoint&); //not copyable
+    Checkpoint& operator=( const Checkpoint&);
+    const std::string name_;
+    std::string buffer_;
+    std::thread writer_;
+};
+
+/*! @brief Restore a solver from a checkpoint file
+ *
+ * @tparam Solver A class with a double restart( std::istream&) method
+ * @param name The name of the checkpoint file
+ * @param solver The solver 
+ * @return The time of the stored fields
+ * @throw Message If the file cannot be opened or does not fit the solver
+ */
+template< class Solver>
+double restart( const std::string& name, Solver& solver)
+{
+    std::ifstream is( name.c_str(), std::ios::binary);
+    if( !is.is_open())
+        throw spectral::Message( "Checkpoint file could not be opened!", _ping_);
+    return solver.restart( is);
+}
+
+} //namespace file
+
+#endif //_TL_CHECKPOINT_
@@ -8,15 +8,54 @@
 #ifndef _TL_ARAKAWA_
 #define _TL_ARAKAWA_
 
+#include <algorithm>
+#include <array>
+#include <vector>
 #include "quadmat.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__)) && !defined(TL_NO_SIMD)
+#define TL_ARAKAWA_X86
+#include <immintrin.h>
+#endif
 
 namespace spectral{
 
+/*! @brief Instruction sets for the interior sweep of the arakawa scheme
+ *
+ * @ingroup algorithms
+ */
+enum simd{ TL_SCALAR, //!< Portable scalar kernel
+           TL_AVX2,   //!< 256 bit kernel (4 doubles per instruction)
+           TL_AVX512  //!< 512 bit kernel (8 doubles per instruction)
+};
+
+/*! @brief Detect the widest instruction set usable for the arakawa scheme 
+ *
+ * @ingroup algorithms
+ * The detection is done at runtime, i.e. the same executable 
+ * runs on every x86 processor.
+ * @return TL_AVX512, TL_AVX2 or TL_SCALAR
+ */
+inline enum simd simd_support();
 
 template< class M>
 static double interior( const size_t i0, const size_t j0, const M& lhs, const M& rhs);
 template< class M>
 static double boundary( const size_t i0, const size_t j0, const M& lhs, const M& rhs);
+static inline void interior_row( const double* lm, const double* l0, const double* lp, 
+                                 const double* rm, const double* r0, const double* rp, 
+                                 double* jac, const size_t cols, const double c, const enum simd s);
+static inline void interior_row( const double* lm, const double* l0, const double* lp, 
+                                 const double* rm, const double* r0, const double* rp, 
+                                 double* jac, const size_t j0, const size_t j1, const double c, const enum simd s);
+static void interior_rows( const double* const* l, 
+                           const double* rm, const double* r0, const double* rp, 
+                           double* const* jac, const size_t m, 
+                           const size_t j0, const size_t j1, const double c, const enum simd s, 
+                           const bool buffered = false);
 
 /*! @brief Implements the arakawa scheme 
  *
@@ -36,19 +75,44 @@ class Arakawa
 {
   private:
     const double c;
+    const enum simd s;
+    const bool buffered;
+    static int team();
+    struct NoTile{ void operator()( size_t, size_t) const{} };
+    template< size_t n, class GhostM, class M, class Tile>
+    void sweep( const std::array<const GhostM*, n>& lhs, const std::array<const GhostM*, n>& rhs, const std::array<M*, n>& jac, const Tile& tile, 
+                const size_t i_first, const size_t i_last, const bool shared = false);
   public:
+    /*! @brief Cache sizes in bytes the tiles of the sweep are tuned for
+     *
+     * A column strip is chosen such that three lines of both operands 
+     * fit into l1 and a tile (strip times tile rows) of both operands 
+     * fits into l2. (In the multi-species version all operands count.)
+     */
+    static const size_t l1 = 32768, l2 = 262144;
     /*! @brief constructor
      *
      * @param h the physical grid constant
+     * @param s the instruction set for the interior points 
+     *  (the widest one available on the processor by default)
+     * @param buffered carry the row differences in a buffer 
+     *  (cf. Row differences of interior_rows; slower on the tested machines)
      */
-    Arakawa( const double h): c(1.0/(12.0*h*h)){}
+    Arakawa( const double h, const enum simd s = simd_support(), const bool buffered = false): 
+        c(1.0/(12.0*h*h)), s(s), buffered( buffered){}
     /*! @brief Arakawa scheme working with ghostcells
      *
      * This function takes less than 0.03s for 1e6 elements
      * and is of O(N).
-     * But could be twice as fast if only the interior function 
-     * and no GhostMatrix were used! (At least on some processors, 
-     *  with older compilers...)
+     * The interior points are computed linewise on the raw memory 
+     * (vectorised if the processor supports it), only the 
+     * edges use the at() access of the GhostMatrix.
+     * The lines are split into tiles of rows and columns that 
+     * are distributed among the threads of a new parallel region. 
+     * When called inside a parallel region (e.g. a loop over species) 
+     * the function runs serially unless nested parallelism is 
+     * enabled, in which case each outer thread 
+     * gets an equal share of the processors.
      * @tparam GhostM the type of the GhostMatrix
      * @tparam M    the type of the Matrix
      * @param lhs the left function in the Poisson bracket
@@ -57,6 +121,84 @@ class Arakawa
      */
     template< class GhostM, class M>
     void operator()( const GhostM& lhs, const GhostM& rhs, M& jac);
+    /*! @brief Arakawa scheme for several species in one sweep
+     *
+     * Computes jac[k] = {lhs[k], rhs[k]} for all k in one parallel sweep.
+     * Species whose right functions are the same object (e.g. 
+     * the potentials for tau = 0) are computed together, i.e. the 
+     * stencil of the common right function is loaded only once for all of them.
+     * The result equals n calls of the single version.
+     * @tparam n the number of species
+     * @tparam GhostM the type of the GhostMatrix
+     * @tparam M    the type of the Matrix
+     * @param lhs the left functions in the Poisson bracket (ghostcells initialized)
+     * @param rhs the right functions in the Poisson bracket (ghostcells initialized, 
+     *  pointers may coincide)
+     * @param jac the Poisson brackets contain solution on output
+     */
+    template< size_t n, class GhostM, class M>
+    void operator()( const std::array<const GhostM*, n>& lhs, const std::array<const GhostM*, n>& rhs, std::array<M, n>& jac);
+    /*! @brief Arakawa scheme for several species with a callback for finished tiles
+     *
+     * Same as above, but tile( i_begin, i_end) is called as soon as the 
+     * lines i_begin <= i < i_end of all brackets are computed. 
+     * This allows to process the result (e.g. the explicit part of 
+     * a timestep) while it is still in cache. The callback is called 
+     * concurrently for disjoint sets of lines. 
+     * @tparam Tile a functor with operator()( size_t, size_t) const
+     * @param lhs the left functions in the Poisson bracket (ghostcells initialized)
+     * @param rhs the right functions in the Poisson bracket (ghostcells initialized, 
+     *  pointers may coincide)
+     * @param jac the Poisson brackets contain solution on output
+     * @param tile the callback
+     */
+    template< size_t n, class GhostM, class M, class Tile>
+    void operator()( const std::array<const GhostM*, n>& lhs, const std::array<const GhostM*, n>& rhs, std::array<M, n>& jac, const Tile& tile);
+    /*! @brief Arakawa scheme for several species inside a parallel region
+     *
+     * Same as above, but no new parallel region is opened. Instead the 
+     * tiles are shared among the threads of the enclosing team (orphaned 
+     * omp for), i.e. all threads of the team have to call this function with 
+     * the same arguments. The function returns when all tiles are 
+     * computed (implicit barrier). Outside a parallel region it runs serially.
+     * @tparam Tile a functor with operator()( size_t, size_t) const
+     * @param lhs the left functions in the Poisson bracket (ghostcells initialized)
+     * @param rhs the right functions in the Poisson bracket (ghostcells initialized, 
+     *  pointers may coincide)
+     * @param jac the Poisson brackets contain solution on output
+     * @param tile the callback
+     */
+    template< size_t n, class GhostM, class M, class Tile>
+    void shared( const std::array<const GhostM*, n>& lhs, const std::array<const GhostM*, n>& rhs, std::array<M, n>& jac, const Tile& tile);
+    /*! @brief Arakawa scheme for the lines i_first <= i < i_last only
+     *
+     * The lines 1,...,rows-2 only need the ghostcells of the columns.
+     * This allows to compute them while the ghost lines are still 
+     * being communicated (cf. DistArakawa).
+     * @tparam GhostM the type of the GhostMatrix
+     * @tparam M    the type of the Matrix
+     * @param lhs the left function in the Poisson bracket
+     * @param rhs the right function in the Poisson bracket
+     * @param jac the Poisson bracket contains solution in the given lines on output
+     * @param i_first first line to compute
+     * @param i_last one past the last line to compute
+     */
+    template< class GhostM, class M>
+    void lines( const GhostM& lhs, const GhostM& rhs, M& jac, const size_t i_first, const size_t i_last);
+    /*! @brief Arakawa scheme for the lines i_first <= i < i_last with a callback for finished tiles
+     *
+     * Same as above, but tile( i_begin, i_end) is called as soon as the 
+     * lines i_begin <= i < i_end are computed (cf. the multi-species version).
+     * @tparam Tile a functor with operator()( size_t, size_t) const
+     * @param lhs the left function in the Poisson bracket
+     * @param rhs the right function in the Poisson bracket
+     * @param jac the Poisson bracket contains solution in the given lines on output
+     * @param i_first first line to compute
+     * @param i_last one past the last line to compute
+     * @param tile the callback
+     */
+    template< class GhostM, class M, class Tile>
+    void lines( const GhostM& lhs, const GhostM& rhs, M& jac, const size_t i_first, const size_t i_last, const Tile& tile);
 };
 
 
@@ -65,25 +207,170 @@ void Arakawa::operator()(const GhostM& lhs,
                          const GhostM& rhs, 
                          M& jac)
 {
-    const size_t rows = jac.rows(), cols = jac.cols();
+    const std::array<const GhostM*, 1> l{{ &lhs}}, r{{ &rhs}};
+    const std::array<M*, 1> j{{ &jac}};
+    sweep( l, r, j, NoTile(), 0, jac.rows());
+}
+
+template< class GhostM, class M>
+void Arakawa::lines(const GhostM& lhs, 
+                    const GhostM& rhs, 
+                    M& jac, 
+                    const size_t i_first, const size_t i_last)
+{
+    const std::array<const GhostM*, 1> l{{ &lhs}}, r{{ &rhs}};
+    const std::array<M*, 1> j{{ &jac}};
+    sweep( l, r, j, NoTile(), i_first, i_last);
+}
+
+template< class GhostM, class M, class Tile>
+void Arakawa::lines(const GhostM& lhs, 
+                    const GhostM& rhs, 
+                    M& jac, 
+                    const size_t i_first, const size_t i_last, 
+                    const Tile& tile)
+{
+    const std::array<const GhostM*, 1> l{{ &lhs}}, r{{ &rhs}};
+    const std::array<M*, 1> j{{ &jac}};
+    sweep( l, r, j, tile, i_first, i_last);
+}
 
-    for( size_t j0 = 0; j0 < cols; j0++)
-        jac(0,j0)       = c*boundary( 0, j0, lhs, rhs);
-    for( size_t i0 = 1; i0 < rows-1; i0++)
+template< size_t n, class GhostM, class M>
+void Arakawa::operator()( const std::array<const GhostM*, n>& lhs, 
+                          const std::array<const GhostM*, n>& rhs, 
+                          std::array<M, n>& jac)
+{
+    (*this)( lhs, rhs, jac, NoTile());
+}
+
+template< size_t n, class GhostM, class M, class Tile>
+void Arakawa::operator()( const std::array<const GhostM*, n>& lhs, 
+                          const std::array<const GhostM*, n>& rhs, 
+                          std::array<M, n>& jac, 
+                          const Tile& tile)
+{
+    std::array<M*, n> j;
+    for( size_t k = 0; k < n; k++)
+        j[k] = &jac[k];
+    sweep( lhs, rhs, j, tile, 0, jac[0].rows());
+}
+
+template< size_t n, class GhostM, class M, class Tile>
+void Arakawa::shared( const std::array<const GhostM*, n>& lhs, 
+                      const std::array<const GhostM*, n>& rhs, 
+                      std::array<M, n>& jac, 
+                      const Tile& tile)
+{
+    std::array<M*, n> j;
+    for( size_t k = 0; k < n; k++)
+        j[k] = &jac[k];
+    sweep( lhs, rhs, j, tile, 0, jac[0].rows(), true);
+}
+
+template< size_t n, class GhostM, class M, class Tile>
+void Arakawa::sweep( const std::array<const GhostM*, n>& lhs, 
+                     const std::array<const GhostM*, n>& rhs, 
+                     const std::array<M*, n>& jac, 
+                     const Tile& tile, 
+                     const size_t i_first, const size_t i_last, 
+                     const bool shared)
+{
+    const size_t rows = jac[0]->rows(), cols = jac[0]->cols();
+#ifdef TL_DEBUG
+    for( size_t k = 0; k < n; k++)
+        if( jac[k]->rows() != rows || jac[k]->cols() != cols || 
+            lhs[k]->rows() != rows || lhs[k]->cols() != cols || 
+            rhs[k]->rows() != rows || rhs[k]->cols() != cols)
+            throw Message( "Matrix sizes in Arakawa don't match!", _ping_);
+    if( i_first > i_last || i_last > rows)
+        throw Message( "Lines out of range in Arakawa!", _ping_);
+#endif
+    //sort species into groups with the same rhs
+    std::array<size_t, n> order; 
+    std::array<size_t, n+1> first; 
+    std::array<bool, n> sorted; 
+    sorted.fill( false);
+    size_t groups = 0, idx = 0;
+    for( size_t k = 0; k < n; k++)
     {
-        jac(i0,0)       = c*boundary( i0, 0, lhs, rhs);
-        for( size_t j0 = 1; j0 < cols-1; j0++)
-            jac(i0,j0)  = c*interior( i0, j0, lhs, rhs);
-        jac(i0,cols-1)  = c*boundary( i0, cols-1, lhs, rhs);
+        if( sorted[k]) continue;
+        first[groups++] = idx;
+        for( size_t q = k; q < n; q++)
+            if( !sorted[q] && rhs[q] == rhs[k])
+                order[idx++] = q, sorted[q] = true;
     }
-    for( size_t i0 = 1; i0 < rows-1; i0++)
+    first[groups] = n;
+    //three lines of all operands in l1, a tile of all operands in l2
+    const size_t operands = n + groups;
+    const size_t strip = std::max<size_t>( 8, l1/(3*operands*sizeof(double))/8*8);
+    const size_t tile_rows = std::max<size_t>( 4, l2/(operands*sizeof(double)*std::min( strip, cols)));
+    const size_t tiles = (i_last - i_first + tile_rows - 1)/tile_rows;
+    auto compute = [&]( const size_t t)
+    {
+        const size_t i_begin = i_first + t*tile_rows, i_end = std::min( i_last, i_begin + tile_rows);
+        const size_t k_begin = std::max<size_t>( 1, i_begin), k_end = std::min( rows - 1, i_end);
+        const double* l[3*n];
+        double* jc[n];
+        for( size_t j0 = 1; j0 + 1 < cols; j0 += strip)
+        {
+            const size_t j1 = std::min( cols - 1, j0 + strip);
+            for( size_t i0 = k_begin; i0 < k_end; i0++)
+                for( size_t g = 0; g < groups; g++)
+                {
+                    const size_t m = first[g+1] - first[g];
+                    for( size_t q = 0; q < m; q++)
+                    {
+                        const GhostM& lk = *lhs[order[first[g] + q]];
+                        l[3*q]   = &lk(i0-1,0);
+                        l[3*q+1] = &lk(i0,0);
+                        l[3*q+2] = &lk(i0+1,0);
+                        jc[q]    = &(*jac[order[first[g] + q]])(i0,0);
+                    }
+                    const GhostM& r = *rhs[order[first[g]]];
+                    interior_rows( l, &r(i0-1,0), &r(i0,0), &r(i0+1,0), 
+                                   jc, m, j0, j1, c, s, buffered);
+                }
+        }
+        for( size_t k = 0; k < n; k++)
+        {
+            const GhostM& lk = *lhs[k], & rk = *rhs[k];
+            M& jk = *jac[k];
+            for( size_t i0 = i_begin; i0 < i_end; i0++)
+                if( i0 == 0 || i0 == rows - 1)
+                    for( size_t j0 = 0; j0 < cols; j0++)
+                        jk(i0,j0) = c*boundary( i0, j0, lk, rk);
+                else
+                {
+                    jk(i0,0)       = c*boundary( i0, 0, lk, rk);
+                    jk(i0,cols-1)  = c*boundary( i0, cols-1, lk, rk);
+                }
+        }
+        tile( i_begin, i_end);
+    };
+    if( shared)
     {
-        jac(i0,0)       = c*boundary( i0, 0, lhs, rhs);
-        jac(i0,cols-1)  = c*boundary( i0, cols-1, lhs, rhs);
+#pragma omp for schedule( static)
+        for( size_t t = 0; t < tiles; t++)
+            compute( t);
+        return;
     }
-    
-    for( size_t j0 = 0; j0 < cols; j0++)
-        jac(rows-1,j0)  = c*boundary( rows-1, j0, lhs, rhs);
+    const int threads = team();
+#pragma omp parallel for schedule( static) num_threads( threads) if( threads > 1 && tiles > 1)
+    for( size_t t = 0; t < tiles; t++)
+        compute( t);
+}
+
+int Arakawa::team()
+{
+#ifdef _OPENMP
+    if( !omp_in_parallel()) 
+        return omp_get_max_threads();
+    if( omp_get_active_level() >= omp_get_max_active_levels())
+        return 1;
+    return std::max( 1, omp_get_num_procs()/omp_get_num_threads());
+#else
+    return 1;
+#endif
 }
 
 
@@ -149,6 +436,274 @@ double boundary( const size_t i0, const size_t j0, const M& lhs, const M& rhs)
         }
     return interior( 1, 1, l, r);
 }
+
+/******************Row differences of interior_rows******************
+ * The brackets of the four edge neighbours in interior are grouped 
+ * into differences of the left function:
+ * dv(j) = lp[j] - lm[j] for the columns j-1, j and j+1, 
+ * dh(j) = l[j+1] - l[j-1] for the lines i0-1, i0 and i0+1.
+ * dv(j) is used by the points j-1, j and j+1. In the buffered mode it 
+ * is computed once per column into a row buffer (one line per left 
+ * function) that the kernels read with unaligned loads at j-1, j and j+1. 
+ * Otherwise (dv == 0) each point forms its dv from its own loads.
+ * The buffer saves two subtractions per point but not a single load 
+ * (the eight values of the left function are still needed for dh and 
+ * the diagonal neighbours) and adds a store and three loads per point, 
+ * so arakawa_b measures it slower than the direct kernels, which 
+ * remain the default.
+ * The three dh belong to different lines, i.e. they are reused only 
+ * by the neighbouring lines, and are formed from the loaded values.
+ * The eight values of the right function are loaded once per point 
+ * and used for all m left functions.
+ */
+/*! @brief scalar kernel for the interior points j0 <= j < j1 of one line
+ *
+ * @param l lines i0-1, i0, i0+1 of the m left functions (3*m pointers)
+ * @param dv row differences, dv[k*stride + j-j0+1] = dv(j) of function k for j0-1 <= j <= j1
+ *  (0 to compute them from the lines)
+ * @param stride distance of the lines of dv
+ * @param rm line i0-1 of the common right function
+ * @param r0 line i0 of the common right function
+ * @param rp line i0+1 of the common right function
+ * @param jac lines i0 of the m Poisson brackets (contain solution on output)
+ * @param m number of left functions
+ * @param j0 first column to compute (>=1)
+ * @param j1 one past the last column to compute (<= cols-1)
+ * @param c the normalisation of the bracket
+ */
+static inline void interior_rows_scalar( const double* const* l, const double* dv, const size_t stride, 
+                                         const double* rm, const double* r0, const double* rp, 
+                                         double* const* jac, const size_t m, 
+                                         const size_t j0, const size_t j1, const double c)
+{
+    for( size_t j = j0; j < j1; j++)
+    {
+        const double r0_m = r0[j-1], r0_p = r0[j+1], rp_0 = rp[j], rm_0 = rm[j];
+        const double rp_m = rp[j-1], rp_p = rp[j+1], rm_m = rm[j-1], rm_p = rm[j+1];
+        for( size_t k = 0; k < m; k++)
+        {
+            const double* lm = l[3*k], *l0 = l[3*k+1], *lp = l[3*k+2];
+            double dv_m, dv_0, dv_p;
+            if( dv)
+            {
+                const double* d = dv + k*stride + j - j0;
+                dv_m = d[0], dv_0 = d[1], dv_p = d[2];
+            }
+            else
+                dv_m = lp[j-1] - lm[j-1], dv_0 = lp[j] - lm[j], dv_p = lp[j+1] - lm[j+1];
+            const double dh_m = lm[j+1] - lm[j-1], dh_0 = l0[j+1] - l0[j-1], dh_p = lp[j+1] - lp[j-1];
+            double jacob;
+            jacob  = r0_m*( dv_0 + dv_m);
+            jacob -= r0_p*( dv_0 + dv_p);
+            jacob += rp_0*( dh_0 + dh_p);
+            jacob -= rm_0*( dh_0 + dh_m);
+            jacob += rp_m*( lp[j] - l0[j-1]);
+            jacob += rp_p*( l0[j+1] - lp[j]);
+            jacob += rm_m*( l0[j-1] - lm[j]);
+            jacob += rm_p*( lm[j] - l0[j+1]);
+            jac[k][j] = c*jacob;
+        }
+    }
+}
+
+#ifdef TL_ARAKAWA_X86
+///@cond
+__attribute__((target("avx2")))
+static void interior_rows_avx2( const double* const* l, const double* dv, const size_t stride, 
+                                const double* rm, const double* r0, const double* rp, 
+                                double* const* jac, const size_t m, 
+                                const size_t j0, const size_t j1, const double c)
+{
+    const __m256d cc = _mm256_set1_pd( c);
+    size_t j = j0;
+    for( ; j + 4 <= j1; j+=4)
+    {
+        const __m256d r0_m = _mm256_loadu_pd( r0+j-1), r0_p = _mm256_loadu_pd( r0+j+1);
+        const __m256d rp_0 = _mm256_loadu_pd( rp+j),   rm_0 = _mm256_loadu_pd( rm+j);
+        const __m256d rp_m = _mm256_loadu_pd( rp+j-1), rp_p = _mm256_loadu_pd( rp+j+1);
+        const __m256d rm_m = _mm256_loadu_pd( rm+j-1), rm_p = _mm256_loadu_pd( rm+j+1);
+        for( size_t k = 0; k < m; k++)
+        {
+            const double* lm = l[3*k], *l0 = l[3*k+1], *lp = l[3*k+2];
+            const __m256d lm_m = _mm256_loadu_pd( lm+j-1), lm_0 = _mm256_loadu_pd( lm+j), lm_p = _mm256_loadu_pd( lm+j+1);
+            const __m256d l0_m = _mm256_loadu_pd( l0+j-1),                                 l0_p = _mm256_loadu_pd( l0+j+1);
+            const __m256d lp_m = _mm256_loadu_pd( lp+j-1), lp_0 = _mm256_loadu_pd( lp+j), lp_p = _mm256_loadu_pd( lp+j+1);
+            __m256d dv_m, dv_0, dv_p;
+            if( dv)
+            {
+                const double* d = dv + k*stride + j - j0;
+                dv_m = _mm256_loadu_pd( d), dv_0 = _mm256_loadu_pd( d+1), dv_p = _mm256_loadu_pd( d+2);
+            }
+            else
+                dv_m = _mm256_sub_pd( lp_m, lm_m), dv_0 = _mm256_sub_pd( lp_0, lm_0), dv_p = _mm256_sub_pd( lp_p, lm_p);
+            const __m256d dh_m = _mm256_sub_pd( lm_p, lm_m), dh_0 = _mm256_sub_pd( l0_p, l0_m), dh_p = _mm256_sub_pd( lp_p, lp_m);
+            __m256d jacob;
+            jacob = _mm256_mul_pd( r0_m, _mm256_add_pd( dv_0, dv_m));
+            jacob = _mm256_sub_pd( jacob, _mm256_mul_pd( r0_p, _mm256_add_pd( dv_0, dv_p)));
+            jacob = _mm256_add_pd( jacob, _mm256_mul_pd( rp_0, _mm256_add_pd( dh_0, dh_p)));
+            jacob = _mm256_sub_pd( jacob, _mm256_mul_pd( rm_0, _mm256_add_pd( dh_0, dh_m)));
+            jacob = _mm256_add_pd( jacob, _mm256_mul_pd( rp_m, _mm256_sub_pd( lp_0, l0_m)));
+            jacob = _mm256_add_pd( jacob, _mm256_mul_pd( rp_p, _mm256_sub_pd( l0_p, lp_0)));
+            jacob = _mm256_add_pd( jacob, _mm256_mul_pd( rm_m, _mm256_sub_pd( l0_m, lm_0)));
+            jacob = _mm256_add_pd( jacob, _mm256_mul_pd( rm_p, _mm256_sub_pd( lm_0, l0_p)));
+            _mm256_storeu_pd( jac[k]+j, _mm256_mul_pd( cc, jacob));
+        }
+    }
+    interior_rows_scalar( l, dv ? dv + j - j0 : 0, stride, rm, r0, rp, jac, m, j, j1, c);
+}
+
+__attribute__((target("avx512f")))
+static void interior_rows_avx512( const double* const* l, const double* dv, const size_t stride, 
+                                  const double* rm, const double* r0, const double* rp, 
+                                  double* const* jac, const size_t m, 
+                                  const size_t j0, const size_t j1, const double c)
+{
+    const __m512d cc = _mm512_set1_pd( c);
+    size_t j = j0;
+    for( ; j + 8 <= j1; j+=8)
+    {
+        const __m512d r0_m = _mm512_loadu_pd( r0+j-1), r0_p = _mm512_loadu_pd( r0+j+1);
+        const __m512d rp_0 = _mm512_loadu_pd( rp+j),   rm_0 = _mm512_loadu_pd( rm+j);
+        const __m512d rp_m = _mm512_loadu_pd( rp+j-1), rp_p = _mm512_loadu_pd( rp+j+1);
+        const __m512d rm_m = _mm512_loadu_pd( rm+j-1), rm_p = _mm512_loadu_pd( rm+j+1);
+        for( size_t k = 0; k < m; k++)
+        {
+            const double* lm = l[3*k], *l0 = l[3*k+1], *lp = l[3*k+2];
+            const __m512d lm_m = _mm512_loadu_pd( lm+j-1), lm_0 = _mm512_loadu_pd( lm+j), lm_p = _mm512_loadu_pd( lm+j+1);
+            const __m512d l0_m = _mm512_loadu_pd( l0+j-1),                                 l0_p = _mm512_loadu_pd( l0+j+1);
+            const __m512d lp_m = _mm512_loadu_pd( lp+j-1), lp_0 = _mm512_loadu_pd( lp+j), lp_p = _mm512_loadu_pd( lp+j+1);
+            __m512d dv_m, dv_0, dv_p;
+            if( dv)
+            {
+                const double* d = dv + k*stride + j - j0;
+                dv_m = _mm512_loadu_pd( d), dv_0 = _mm512_loadu_pd( d+1), dv_p = _mm512_loadu_pd( d+2);
+            }
+            else
+                dv_m = _mm512_sub_pd( lp_m, lm_m), dv_0 = _mm512_sub_pd( lp_0, lm_0), dv_p = _mm512_sub_pd( lp_p, lm_p);
+            const __m512d dh_m = _mm512_sub_pd( lm_p, lm_m), dh_0 = _mm512_sub_pd( l0_p, l0_m), dh_p = _mm512_sub_pd( lp_p, lp_m);
+            __m512d jacob;
+            jacob = _mm512_mul_pd( r0_m, _mm512_add_pd( dv_0, dv_m));
+            jacob = _mm512_sub_pd( jacob, _mm512_mul_pd( r0_p, _mm512_add_pd( dv_0, dv_p)));
+            jacob = _mm512_add_pd( jacob, _mm512_mul_pd( rp_0, _mm512_add_pd( dh_0, dh_p)));
+            jacob = _mm512_sub_pd( jacob, _mm512_mul_pd( rm_0, _mm512_add_pd( dh_0, dh_m)));
+            jacob = _mm512_add_pd( jacob, _mm512_mul_pd( rp_m, _mm512_sub_pd( lp_0, l0_m)));
+            jacob = _mm512_add_pd( jacob, _mm512_mul_pd( rp_p, _mm512_sub_pd( l0_p, lp_0)));
+            jacob = _mm512_add_pd( jacob, _mm512_mul_pd( rm_m, _mm512_sub_pd( l0_m, lm_0)));
+            jacob = _mm512_add_pd( jacob, _mm512_mul_pd( rm_p, _mm512_sub_pd( lm_0, l0_p)));
+            _mm512_storeu_pd( jac[k]+j, _mm512_mul_pd( cc, jacob));
+        }
+    }
+    interior_rows_scalar( l, dv ? dv + j - j0 : 0, stride, rm, r0, rp, jac, m, j, j1, c);
+}
+///@endcond
+#endif //TL_ARAKAWA_X86
+
+enum simd simd_support()
+{
+#ifdef TL_ARAKAWA_X86
+    static const enum simd s = __builtin_cpu_supports( "avx512f") ? TL_AVX512 : 
+                              (__builtin_cpu_supports( "avx2")   ? TL_AVX2 : TL_SCALAR);
+    return s;
+#else
+    return TL_SCALAR;
+#endif
+}
+
+/*! @brief computes all interior points of one line in the Arakawa scheme
+ *
+ * The result agrees with the interior function up to round-off.
+ * (The differences are grouped differently and the vector kernels 
+ * may contract multiplications and additions.)
+ * @param lm line i0-1 of the left function
+ * @param l0 line i0 of the left function
+ * @param lp line i0+1 of the left function
+ * @param rm line i0-1 of the right function
+ * @param r0 line i0 of the right function
+ * @param rp line i0+1 of the right function
+ * @param jac line i0 of the Poisson bracket. 
+ *  Contains the normalized values at 1,...,cols-2 on output. 
+ * @param cols number of columns in a line
+ * @param c the normalisation of the bracket
+ * @param s the instruction set to use (falls back to 
+ *  TL_SCALAR if not supported by the processor)
+ */
+void interior_row( const double* lm, const double* l0, const double* lp, 
+                   const double* rm, const double* r0, const double* rp, 
+                   double* jac, const size_t cols, const double c, const enum simd s)
+{
+    if( cols < 3) return;
+    interior_row( lm, l0, lp, rm, r0, rp, jac, 1, cols-1, c, s);
+}
+
+/*! @brief computes the interior points j0 <= j < j1 of one line in the Arakawa scheme
+ *
+ * Same as above but restricted to a column strip.
+ * @param lm line i0-1 of the left function
+ * @param l0 line i0 of the left function
+ * @param lp line i0+1 of the left function
+ * @param rm line i0-1 of the right function
+ * @param r0 line i0 of the right function
+ * @param rp line i0+1 of the right function
+ * @param jac line i0 of the Poisson bracket (contains solution on output)
+ * @param j0 first column to compute (>=1)
+ * @param j1 one past the last column to compute (<= cols-1)
+ * @param c the normalisation of the bracket
+ * @param s the instruction set to use (falls back to 
+ *  TL_SCALAR if not supported by the processor)
+ */
+void interior_row( const double* lm, const double* l0, const double* lp, 
+                   const double* rm, const double* r0, const double* rp, 
+                   double* jac, const size_t j0, const size_t j1, const double c, const enum simd s)
+{
+    const double* l[3] = { lm, l0, lp};
+    interior_rows( l, rm, r0, rp, &jac, 1, j0, j1, c, s);
+}
+
+/*! @brief computes the interior points j0 <= j < j1 of one line for several left functions
+ *
+ * Computes the lines of the brackets {l_k, r} for k = 0,...,m-1 
+ * with a common right function r.
+ * @param l lines i0-1, i0, i0+1 of the m left functions (3*m pointers)
+ * @param rm line i0-1 of the right function
+ * @param r0 line i0 of the right function
+ * @param rp line i0+1 of the right function
+ * @param jac lines i0 of the m Poisson brackets (contain solution on output)
+ * @param m number of left functions
+ * @param j0 first column to compute (>=1)
+ * @param j1 one past the last column to compute (<= cols-1)
+ * @param c the normalisation of the bracket
+ * @param s the instruction set to use (falls back to 
+ *  TL_SCALAR if not supported by the processor)
+ * @param buffered carry the row differences in a buffer (cf. Row differences)
+ */
+void interior_rows( const double* const* l, 
+                    const double* rm, const double* r0, const double* rp, 
+                    double* const* jac, const size_t m, 
+                    const size_t j0, const size_t j1, const double c, const enum simd s, 
+                    const bool buffered)
+{
+    if( j0 >= j1) return;
+    //the row differences dv(j0-1), ..., dv(j1) of every left function (cf. Row differences)
+    static thread_local std::vector< double> buffer;
+    const size_t stride = j1 - j0 + 2;
+    if( buffered && buffer.size() < m*stride)
+        buffer.resize( m*stride);
+    double* dv = buffered ? &buffer[0] : 0;
+    for( size_t k = 0; buffered && k < m; k++)
+    {
+        const double* lm = l[3*k] + j0 - 1, *lp = l[3*k+2] + j0 - 1;
+        double* d = dv + k*stride;
+        for( size_t j = 0; j < stride; j++)
+            d[j] = lp[j] - lm[j];
+    }
+#ifdef TL_ARAKAWA_X86
+    if( s == TL_AVX512 && simd_support() == TL_AVX512)
+        return interior_rows_avx512( l, dv, stride, rm, r0, rp, jac, m, j0, j1, c);
+    if( s >= TL_AVX2 && simd_support() >= TL_AVX2)
+        return interior_rows_avx2( l, dv, stride, rm, r0, rp, jac, m, j0, j1, c);
+#endif
+    interior_rows_scalar( l, dv, stride, rm, r0, rp, jac, m, j0, j1, c);
+}
 } //namespace spectral
 #endif// _TL_ARAKAWA_
 
@@ -1,4 +1,6 @@
 #include <iostream>
+#include <cmath>
+#include <array>
 #include "timer.h"
 #include "arakawa.h"
 #include "matrix.h"
@@ -31,7 +33,7 @@ const double hysq = -c;
 const int nymax = 2049;
 const int nxmax = 513;
     int rows = 500, cols = 500;
-    unsigned loop = 1;
+    unsigned loop = 20;
     int nx1 = rows, ny1 = cols;
 void arakawa2(double (*uuu)[nymax], double (*vvv)[nymax], double (*www)[nymax])
 { 
@@ -61,6 +63,17 @@ void arakawa2(double (*uuu)[nymax], double (*vvv)[nymax], double (*www)[nymax])
 	};
     }
 }
+/*! Print throughput of one sweep
+ *
+ * The minimal memory traffic of a sweep is reading lhs and rhs and 
+ * writing jac once.
+ */
+void throughput( double seconds)
+{
+    const double points = (double)rows*(double)cols*(double)loop;
+    cout << "    "<<points/seconds/1e6 <<" Mpoints/s, "
+         << 3.*sizeof(double)*points/seconds/1e9<<" GB/s\n";
+}
 int main()
 {
     Timer t;
@@ -87,7 +100,7 @@ int main()
             /*vvv[i+1][j+1] =*/ rhs0( i + 1, j + 1) = rhs(i,j);
         }
 
-    //Make Dirichlet BC
+    //Make periodic BC
     cout << "Completely with interior function\n";
     t.tic();
     for( unsigned k = 0; k < loop; k++)
@@ -103,23 +116,27 @@ int main()
         }
         for( int i = -1; i < rows+1 ; i++)
         {
-            /*uuu[i+1][0] = vvv[i+1][0] =*/ rhs0( i+1, -1+1)   = lhs0(i+1, -1+1) = 0;
-            /*uuu[i+1][cols+1] = uuu[i+1][cols+1] =*/ rhs0( i+1, cols+1) = lhs0(i+1,cols+1)= 0;
-            /*
+            /*uuu[i+1][0] = vvv[i+1][0] =*/ //rhs0( i+1, -1+1)   = lhs0(i+1, -1+1) = 0;
+            /*uuu[i+1][cols+1] = uuu[i+1][cols+1] =*/ //rhs0( i+1, cols+1) = lhs0(i+1,cols+1)= 0;
             rhs0(i+1, -1+1)  = rhs0(i+1, cols);
             lhs0(i+1, -1+1)  = lhs0(i+1, cols);
             rhs0(i+1, cols+1) = rhs0(i+1, 1);
             lhs0(i+1, cols+1) = lhs0(i+1, 1);
-            */
         }
         for( size_t i = 1; i < (size_t)rows+1; i++)
             for( size_t j = 1; j < (size_t)cols +1; j++)
                 jac0( i-1, j-1) = c*interior(i,j,lhs0, rhs0);
     }
     t.toc();
-    cout << "Arakawa scheme took " <<t.diff() <<" seconds\n";
-    //Make Dirichlet BC
+    cout << "Arakawa scheme took " <<t.diff()/(double)loop <<" seconds\n";
+    throughput( t.diff());
     cout << "The Matrices including ghost Cells\n";
+    const char* names[] = { "SCALAR", "AVX2", "AVX512"};
+    for( unsigned k = TL_SCALAR; k <= (unsigned)simd_support(); k++)
+    for( unsigned b = 0; b < 2; b++)
+    {
+    Arakawa arakawa_k( h, (enum simd)k, b);
+    cout << "with the "<<names[k]<<" kernel"<<(b ? " and the row buffer\n" : "\n");
     t.tic();
     for( unsigned i = 0; i < loop; i++)
     {
@@ -137,13 +154,42 @@ int main()
         */
         lhs.initGhostCells();
         rhs.initGhostCells();
-        arakawa( lhs, rhs, jac);
+        arakawa_k( lhs, rhs, jac);
     }
     t.toc();
-    cout << "Arakawa scheme took " <<t.diff() <<" seconds\n";
-    if( jac!=jac0)
-        cerr << "An error occured!\n";// << jac << "\n"<<jac0;
+    cout << "Arakawa scheme took " <<t.diff()/(double)loop <<" seconds\n";
+    throughput( t.diff());
+    double diff = 0;
+    for( int i=0; i<rows; i++)
+        for( int j=0; j<cols; j++)
+            diff = std::max( diff, fabs( jac(i,j) - jac0(i,j)));
+    if( diff > 1e-10)
+        cerr << "An error occured! Difference is "<<diff<<"\n";// << jac << "\n"<<jac0;
+    }
 
+    cout << "Three species with a common right function\n";
+    {
+    std::array<GhostMatrix<double>,3> l{{lhs, rhs, lhs}};
+    std::array<Matrix<double>,3> jac3{{jac0, jac0, jac0}};
+    t.tic();
+    for( unsigned i = 0; i < loop; i++)
+        for( unsigned k = 0; k < 3; k++)
+            arakawa( l[k], rhs, jac3[k]);
+    t.toc();
+    cout << "Three single sweeps took " <<t.diff()/(double)loop <<" seconds\n";
+    const std::array<const GhostMatrix<double>*,3> pl{{&l[0], &l[1], &l[2]}}, pr{{&rhs, &rhs, &rhs}};
+    t.tic();
+    for( unsigned i = 0; i < loop; i++)
+        arakawa( pl, pr, jac3);
+    t.toc();
+    cout << "One multi-species sweep took " <<t.diff()/(double)loop <<" seconds\n";
+    Arakawa buffered( h, simd_support(), true);
+    t.tic();
+    for( unsigned i = 0; i < loop; i++)
+        buffered( pl, pr, jac3);
+    t.toc();
+    cout << "One multi-species sweep with the row buffer took " <<t.diff()/(double)loop <<" seconds\n";
+    }
     cout << "Sum jac "<<sum(jac)<<"\n";
     cout << "Sum f*jac "<<sum(lhs, jac)<<"\n";
     cout << "Sum g*jac "<<sum(rhs, jac)<<"\n";
@@ -1,6 +1,9 @@
 #include <iostream>
 #include <iomanip>
 #include <complex>
+#include <cmath>
+#include <cstdlib>
+#include <array>
 #include "dft_dft.h"
 #include "ghostmatrix.h"
 #include "arakawa.h"
@@ -13,7 +16,8 @@ const unsigned rows = 3, cols = 10;
 const double h = 1./cols;
 
 
-double sum( const Matrix<double, TL_DFT>& jac)
+template< class M>
+double sum( const M& jac)
 {
     double s = 0;
     for( unsigned i=0; i<jac.rows(); i++)
@@ -63,5 +67,145 @@ int main()
     //cout << cjac(0,1)/norm<< endl;
     //cout << cjac_exact(0,1)<<endl;
     cout << "Difference with " << cols<< " cells: "<< (cjac(0,1)/norm - cjac_exact(0,1))<<endl;
+
+    cout << "Test whether the linewise kernels (with and without the row buffer) agree with the pointwise interior function\n";
+    const char* names[] = { "SCALAR", "AVX2", "AVX512"};
+    bool passed = true;
+    for( unsigned n = 5; n < 40; n+=7)
+    {
+        GhostMatrix<double> l( n, n+3, TL_DST10, TL_PERIODIC), r( n, n+3, TL_DST10, TL_PERIODIC);
+        Matrix<double> ref( n, n+3);
+        for( unsigned i=0; i<n; i++)
+            for( unsigned j=0; j<n+3; j++)
+            {
+                l(i,j) = (double)rand()/(double)RAND_MAX - 0.5;
+                r(i,j) = (double)rand()/(double)RAND_MAX - 0.5;
+            }
+        l.initGhostCells(), r.initGhostCells();
+        const double c = 1./(12.*h*h);
+        for( unsigned i=0; i<n; i++)
+            for( unsigned j=0; j<n+3; j++)
+                ref(i,j) = c*boundary( i, j, l, r);
+        for( unsigned k = TL_SCALAR; k <= (unsigned)simd_support(); k++)
+        for( unsigned b = 0; b < 2; b++)
+        {
+            Matrix<double> jac_s( n, n+3);
+            Arakawa arakawa_s( h, (enum simd)k, b);
+            arakawa_s( l, r, jac_s);
+            double diff = 0;
+            for( unsigned i=0; i<n; i++)
+                for( unsigned j=0; j<n+3; j++)
+                    diff = std::max( diff, fabs( jac_s(i,j) - ref(i,j))/c);
+            if( diff > 1e-14) 
+            {
+                cout << names[k] << " kernel "<<(b ? "with the row buffer " : "")<<"differs by "<<diff<<" on "<<n<<"x"<<n+3<<" points\n";
+                passed = false;
+            }
+        }
+    }
+    cout << "Test whether the tiled sweep agrees with the pointwise interior function\n";
+    {
+        const unsigned ny = 67, nx = 1500; //several tiles and column strips
+        std::array<GhostMatrix<double>,2> l{{GhostMatrix<double>( ny, nx, TL_DST00, TL_PERIODIC), GhostMatrix<double>( ny, nx, TL_DST00, TL_PERIODIC)}};
+        std::array<GhostMatrix<double>,2> r{{GhostMatrix<double>( ny, nx, TL_DST00, TL_PERIODIC), GhostMatrix<double>( ny, nx, TL_DST00, TL_PERIODIC)}};
+        std::array<Matrix<double>,2> jac_t{{Matrix<double>( ny, nx), Matrix<double>( ny, nx)}};
+        for( unsigned k=0; k<2; k++)
+        {
+            for( unsigned i=0; i<ny; i++)
+                for( unsigned j=0; j<nx; j++)
+                {
+                    l[k](i,j) = (double)rand()/(double)RAND_MAX - 0.5;
+                    r[k](i,j) = (double)rand()/(double)RAND_MAX - 0.5;
+                }
+            l[k].initGhostCells(), r[k].initGhostCells();
+        }
+        const double c = 1./(12.*h*h);
+        Arakawa arakawa_t( h);
+        arakawa_t( l[0], r[0], jac_t[0]);
+        double diff = 0;
+        for( unsigned i=0; i<ny; i++)
+            for( unsigned j=0; j<nx; j++)
+                diff = std::max( diff, fabs( jac_t[0](i,j) - c*boundary( i, j, l[0], r[0]))/c);
+        //called inside a loop over species
+#pragma omp parallel for
+        for( unsigned k=0; k<2; k++)
+            arakawa_t( l[k], r[k], jac_t[k]);
+        for( unsigned k=0; k<2; k++)
+            for( unsigned i=0; i<ny; i++)
+                for( unsigned j=0; j<nx; j++)
+                    diff = std::max( diff, fabs( jac_t[k](i,j) - c*boundary( i, j, l[k], r[k]))/c);
+        if( diff > 1e-14) 
+        {
+            cout << "Tiled sweep differs by "<<diff<<" on "<<ny<<"x"<<nx<<" points\n";
+            passed = false;
+        }
+    }
+    cout << "Test whether the multi-species sweep agrees with single sweeps\n";
+    {
+        const unsigned ny = 45, nx = 900; 
+        std::array<GhostMatrix<double>,3> l{{GhostMatrix<double>( ny, nx, TL_DST10, TL_PERIODIC), GhostMatrix<double>( ny, nx, TL_DST10, TL_PERIODIC), GhostMatrix<double>( ny, nx, TL_DST10, TL_PERIODIC)}};
+        std::array<GhostMatrix<double>,2> r{{GhostMatrix<double>( ny, nx, TL_DST10, TL_PERIODIC), GhostMatrix<double>( ny, nx, TL_DST10, TL_PERIODIC)}};
+        std::array<Matrix<double>,3> jac_m{{Matrix<double>( ny, nx), Matrix<double>( ny, nx), Matrix<double>( ny, nx)}};
+        Matrix<double> jac_s( ny, nx);
+        for( unsigned i=0; i<ny; i++)
+            for( unsigned j=0; j<nx; j++)
+            {
+                for( unsigned k=0; k<3; k++)
+                    l[k](i,j) = (double)rand()/(double)RAND_MAX - 0.5;
+                for( unsigned k=0; k<2; k++)
+                    r[k](i,j) = (double)rand()/(double)RAND_MAX - 0.5;
+            }
+        for( unsigned k=0; k<3; k++) l[k].initGhostCells();
+        for( unsigned k=0; k<2; k++) r[k].initGhostCells();
+        //species 0 and 2 share the right function
+        const std::array<const GhostMatrix<double>*,3> lp{{ &l[0], &l[1], &l[2]}}, rp{{ &r[0], &r[1], &r[0]}};
+        Arakawa arakawa_m( h);
+        arakawa_m( lp, rp, jac_m);
+        const double c = 1./(12.*h*h);
+        double diff = 0;
+        for( unsigned k=0; k<3; k++)
+        {
+            arakawa_m( *lp[k], *rp[k], jac_s);
+            for( unsigned i=0; i<ny; i++)
+                for( unsigned j=0; j<nx; j++)
+                    diff = std::max( diff, fabs( jac_m[k](i,j) - jac_s(i,j))/c);
+        }
+        if( diff > 1e-14) 
+        {
+            cout << "Multi-species sweep differs by "<<diff<<"\n";
+            passed = false;
+        }
+        cout << "Test whether the multi-species sweep with the row buffer agrees with the one without\n";
+        {
+            std::array<Matrix<double>,3> jac_b{{Matrix<double>( ny, nx), Matrix<double>( ny, nx), Matrix<double>( ny, nx)}};
+            Arakawa arakawa_b( h, simd_support(), true);
+            arakawa_b( lp, rp, jac_b);
+            diff = 0;
+            for( unsigned k=0; k<3; k++)
+                for( unsigned i=0; i<ny; i++)
+                    for( unsigned j=0; j<nx; j++)
+                        diff = std::max( diff, fabs( jac_b[k](i,j) - jac_m[k](i,j))/c);
+            if( diff > 1e-14) 
+            {
+                cout << "Multi-species sweep with the row buffer differs by "<<diff<<"\n";
+                passed = false;
+            }
+        }
+        cout << "Test whether the shared sweep inside a parallel region agrees with the multi-species sweep\n";
+        std::array<Matrix<double>,3> jac_p{{Matrix<double>( ny, nx, 0.), Matrix<double>( ny, nx, 0.), Matrix<double>( ny, nx, 0.)}};
+        size_t lines = 0;
+#pragma omp parallel
+        arakawa_m.shared( lp, rp, jac_p, [&]( size_t i_begin, size_t i_end){
+#pragma omp atomic
+            lines += i_end - i_begin;
+        });
+        if( !( jac_p == jac_m) || lines != ny) 
+        {
+            cout << "Shared sweep differs or computed "<<lines<<" of "<<ny<<" lines\n";
+            passed = false;
+        }
+    }
+    cout << "Widest available kernel is "<<names[simd_support()]<<"\n";
+    cout << (passed ? "TEST PASSED!\n" : "TEST FAILED!\n");
     return 0;
 }
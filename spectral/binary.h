@@ -0,0 +1,105 @@
+/*!
+ * @file
+ * @brief Binary input and output of values and matrices (e.g. for checkpoints)
+ */
+#ifndef _TL_BINARY_
+#define _TL_BINARY_
+
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include "matrix.h"
+#include "message.h"
+#include "padding.h"
+
+namespace spectral{
+
+/*! @brief Write a value in binary form
+ *
+ * @ingroup utilitiesX
+ * @tparam T an arithmetic type
+ * @param os the (binary) outstream
+ * @param value the value to write
+ */
+template< class T>
+typename std::enable_if< std::is_arithmetic<T>::value>::type write_binary( std::ostream& os, const T& value)
+{
+    os.write( reinterpret_cast< const char*>( &value), sizeof( T));
+}
+
+/*! @brief Read a value written by write_binary
+ *
+ * @ingroup utilitiesX
+ * @tparam T an arithmetic type
+ * @param is the (binary) instream
+ * @param value contains the value on output
+ * @throw Message if the stream ends before the value
+ */
+template< class T>
+typename std::enable_if< std::is_arithmetic<T>::value>::type read_binary( std::istream& is, T& value)
+{
+    is.read( reinterpret_cast< char*>( &value), sizeof( T));
+    if( !is)
+        throw Message( "Unexpected end of binary stream!", _ping_);
+}
+
+/*! @brief Write the size and the elements of a matrix in binary form
+ *
+ * @ingroup utilitiesX
+ * The padding is written as well, so the matrix is restored bitwise.
+ * For derived classes like GhostMatrix the ghost cells are not written.
+ * @param os the (binary) outstream
+ * @param m a non void matrix
+ * @throw Message if the matrix is void
+ */
+template< class T, enum Padding P>
+void write_binary( std::ostream& os, const Matrix<T,P>& m)
+{
+    if( m.isVoid())
+        throw Message( "Cannot write a void Matrix!", _ping_);
+    const size_t rows = m.rows(), cols = m.cols();
+    write_binary( os, rows);
+    write_binary( os, cols);
+    os.write( reinterpret_cast< const char*>( m.getPtr()), TotalNumberOf<P>::elements( rows, cols)*sizeof( T));
+}
+
+/*! @brief Read a matrix written by write_binary
+ *
+ * @ingroup utilitiesX
+ * @param is the (binary) instream
+ * @param m a matrix of the stored size (allocated if void)
+ * @throw Message if the sizes differ or the stream ends before the matrix
+ */
+template< class T, enum Padding P>
+void read_binary( std::istream& is, Matrix<T,P>& m)
+{
+    size_t rows, cols;
+    read_binary( is, rows);
+    read_binary( is, cols);
+    if( rows != m.rows() || cols != m.cols())
+        throw Message( "Stored Matrix has wrong size!", _ping_);
+    if( m.isVoid())
+        m.allocate();
+    is.read( reinterpret_cast< char*>( m.getPtr()), TotalNumberOf<P>::elements( rows, cols)*sizeof( T));
+    if( !is)
+        throw Message( "Unexpected end of binary stream!", _ping_);
+}
+
+/*! @brief The FNV-1a hash of a string
+ *
+ * @ingroup utilitiesX
+ * Meant to check that a checkpoint belongs to the parameters of a run,
+ * i.e. hash the parameters printed into a string.
+ * @param str the string 
+ * @return the 64 bit FNV-1a hash
+ */
+inline unsigned long long fnv1a( const std::string& str)
+{
+    unsigned long long h = 14695981039346656037ULL;
+    for( unsigned i=0; i<str.size(); i++)
+        h = ( h ^ (unsigned char)str[i])*1099511628211ULL;
+    return h;
+}
+
+} //namespace spectral
+#endif //_TL_BINARY_
@@ -0,0 +1,51 @@
+#include <iostream>
+#include <sstream>
+#include <array>
+#include "binary.h"
+#include "matrix.h"
+#include "karniadakis.h"
+
+using namespace std;
+using namespace spectral;
+
+int main()
+{
+    cout << "Test whether a matrix survives writing and reading...\n";
+    {
+        Matrix<double, TL_DFT> m( 3, 4), r( 3, 4, false), w( 2, 4);
+        for( size_t i=0; i<3; i++)
+            for( size_t j=0; j<4; j++)
+                m(i,j) = 0.1*(double)i - (double)j;
+        stringstream ss( ios::in|ios::out|ios::binary);
+        write_binary( ss, 2.5);
+        write_binary( ss, m);
+        write_binary( ss, m);
+        double x;
+        read_binary( ss, x);
+        read_binary( ss, r);
+        cout << ( x == 2.5 && r == m ? "TEST PASSED!\n" : "TEST FAILED!\n");
+        cout << "Reading into a matrix of wrong size throws:\n";
+        try{ read_binary( ss, w); cout << "TEST FAILED!\n";}
+        catch( Message& message){ message.display(); cout << "TEST PASSED!\n";}
+    }
+    cout << "Test whether a restored Karniadakis object continues identically...\n";
+    {
+        const size_t rows = 2, cols = 4;
+        Matrix< QuadMat<double,2> > coeff( rows, cols, One<2>()), coeff2( coeff);
+        Matrix<double, TL_NONE> m( rows, cols, 1.), n( rows, cols, 0.5);
+        std::array< Matrix<double>, 2> v{{m,m}}, non{{n,n}};
+        Karniadakis<2, double, TL_NONE> k( rows, cols, rows, cols, 0.01), l( k);
+        k.init_coeff( coeff, 1.), l.init_coeff( coeff2, 1.);
+        k.invert_coeff<TL_ORDER3>(), l.invert_coeff<TL_ORDER3>();
+        for( unsigned s=0; s<3; s++)
+            k.step_i<TL_ORDER3>( v, non), k.step_ii( v);
+        stringstream ss( ios::in|ios::out|ios::binary);
+        k.write( ss);
+        l.read( ss);
+        std::array< Matrix<double>, 2> v2( v), non2( non);
+        k.step_i<TL_ORDER3>( v, non), k.step_ii( v);
+        l.step_i<TL_ORDER3>( v2, non2), l.step_ii( v2);
+        cout << ( v == v2 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    return 0;
+}
@@ -2,6 +2,8 @@
 #define _TL_DFT_DFT_
 
 #include <complex>
+#include <cmath>
+#include <algorithm>
 #include "matrix.h"
 #include "fftw3.h"
 #include "fft.h"
@@ -151,6 +153,124 @@ void DFT_DFT::c2r( Matrix<complex, TL_NONE>& inout, Matrix<double, TL_DFT>& swap
     fftw_execute_dft_c2r( backward, fftw_cast(swap.getPtr()), swap.getPtr());
 }
 
+/*! @brief Class for many 2d discrete fourier transformations of fields at equal distances
+ *
+ * @ingroup fftw
+ * A wrapper for the plans of the advanced fftw interface (howmany) 
+ * that transform a batch of fields in the layout of DFT_DFT in place 
+ * with one execute call, e.g. the fields of the members of an ensemble that 
+ * lie in the slots of a MatrixPool. The first elements of the fields are
+ * dist doubles apart. Unlike DFT_DFT the plans work on raw pointers, i.e. 
+ * the caller swaps the matrices (cf. DFT_DFT::r2c and DFT_DFT::c2r).
+ */
+class DFT_DFT_Batch
+{
+  public:
+    /*! @brief Prepare the transformations of howmany fields of given size
+     *
+     * The plans are measured on a buffer of their own.
+     * @param real_rows # of rows in the real matrices
+     * @param real_cols # of colums in the real matrices
+     * @param howmany # of fields in the batch
+     * @param dist # of doubles between the first elements of two fields 
+     *  (an even number at least the size of a padded field)
+     * @param flags flags for plan creation 
+     */
+    DFT_DFT_Batch( const size_t real_rows, const size_t real_cols, const size_t howmany, const size_t dist, const unsigned flags = FFTW_MEASURE);
+    /*! @brief Execute the r2c transformations in place
+     *
+     * @param first The first element of the first field, 
+     *  aligned like memory from fftw_malloc (e.g. by a MatrixPool)
+     */
+    void r2c( double* first) { fftw_execute_dft_r2c( forward, first, fftw_cast( first));}
+    /*! @brief Execute the c2r transformations in place
+     *
+     * @param first The first element of the first field (cf. r2c)
+     * @attention Are you sure you normalized your coefficients with 
+     * (real_rows*real_cols) before backtrafo?
+     */
+    void c2r( double* first) { fftw_execute_dft_c2r( backward, fftw_cast( first), first);}
+    /*! @brief The number of fields of a batch
+     *
+     * @return howmany
+     */
+    size_t size() const { return howmany;}
+    DFT_DFT_Batch( DFT_DFT_Batch& ) = delete;
+    DFT_DFT_Batch& operator=( DFT_DFT_Batch&) = delete;
+    /*! @brief Free the fftw plans
+     */
+    ~DFT_DFT_Batch()
+    {
+        fftw_destroy_plan( forward);
+        fftw_destroy_plan( backward);
+    }
+  private:
+    const size_t howmany;
+    fftw_plan forward;
+    fftw_plan backward;
+};
+
+DFT_DFT_Batch::DFT_DFT_Batch( const size_t rows, const size_t cols, const size_t howmany, const size_t dist, const unsigned flags): howmany( howmany)
+{
+    const size_t padded = TotalNumberOf<TL_DFT>::elements( rows, cols);
+    if( dist % 2 || dist < padded)
+        throw Message( "Fields of the batch overlap or are not aligned!", _ping_);
+    const int n[2] = { (int)rows, (int)cols};
+    const int rembed[2] = { (int)rows, (int)TotalNumberOf<TL_DFT>::columns( cols)}, cembed[2] = { (int)rows, (int)cols/2 + 1};
+    double* temp = (double*)fftw_malloc( ( (howmany - 1)*dist + padded)*sizeof(double));
+    if( temp == NULL)
+        throw Message( "Allocation of the planning buffer failed!", _ping_);
+    forward = fftw_plan_many_dft_r2c( 2, n, howmany, temp, rembed, 1, dist, fftw_cast( temp), cembed, 1, dist/2, flags);
+    backward = fftw_plan_many_dft_c2r( 2, n, howmany, fftw_cast( temp), cembed, 1, dist/2, temp, rembed, 1, dist, flags);
+    fftw_free( temp);
+    if(forward == 0 )
+        throw Message( "Forward Planner routine failed!", _ping_);
+    if(backward == 0 )
+        throw Message( "Backward Planner routine failed!", _ping_);
+}
+
+/*! @brief Copy the modes of a 2d spectrum into a spectrum of different size
+ *
+ * @ingroup fftw
+ * This is the spectral prolongation (the additional modes are zero) or 
+ * restriction (the modes beyond the new size are dropped) of a field
+ * in the layout of DFT_DFT::r2c, i.e. rows lines (ky in fft order) of 
+ * cols/2 + 1 coefficients (kx >= 0) for rows x cols points. 
+ * The Nyquist modes of the smaller size are dropped. The points are
+ * cell centred, i.e. x_j = (j+1/2)h, so the coefficients are shifted
+ * by half the change of the grid constant.
+ * @param src the unnormalized transform of a field with an even number of columns
+ * @param dst the normalized spectrum of the new size on output (non void),
+ *  i.e. DFT_DFT::c2r yields the field on the new grid
+ */
+inline void resize_spectrum( const Matrix< std::complex<double> >& src, Matrix< std::complex<double> >& dst)
+{
+    typedef std::complex<double> complex;
+    const size_t src_rows = src.rows(), src_cols = 2*(src.cols() - 1);
+    const size_t dst_rows = dst.rows(), dst_cols = 2*(dst.cols() - 1);
+    const size_t rows = std::min( src_rows, dst_rows), cols = std::min( src_cols, dst_cols);
+    const double norm = (double)(src_rows*src_cols);
+    const double shift_y = M_PI*( 1./(double)dst_rows - 1./(double)src_rows), 
+                 shift_x = M_PI*( 1./(double)dst_cols - 1./(double)src_cols);
+#pragma omp parallel for
+    for( size_t i=0; i<dst_rows; i++)
+    {
+        const int ky = ( i <= dst_rows/2) ? (int)i : (int)i - (int)dst_rows;
+        if( 2*(size_t)std::abs( ky) >= rows)
+        {
+            for( size_t j=0; j<dst.cols(); j++)
+                dst(i,j) = 0;
+            continue;
+        }
+        const size_t i_src = ( ky >= 0) ? ky : ky + src_rows;
+        for( size_t j=0; j<dst.cols(); j++)
+            if( 2*j >= cols)
+                dst(i,j) = 0;
+            else
+                dst(i,j) = src( i_src, j)/norm*exp( complex( 0, shift_y*(double)ky + shift_x*(double)j));
+    }
+}
+
 } //namespace spectral
 #endif // _TL_DFT_DFT_
 
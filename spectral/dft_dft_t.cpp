@@ -106,6 +106,81 @@ int main()
 
 
 
+    cout << "Test of spectral prolongation and restriction...\n";
+    {
+        //a band limited field on cell centred grids of two sizes
+        const size_t rc = 16, cc = 12, rf = 32, cf = 40;
+        auto field = []( const double x, const double y){ return cos( 2.*M_PI*(2.*x + y)) + sin( 2.*M_PI*( 3.*y - x)) + 0.5*sin( 2.*M_PI*5.*x);};
+        Matrix<double, TL_DFT> coarse( rc, cc), fine( rf, cf), back( rc, cc);
+        for( unsigned i=0; i<rc; i++)
+            for( unsigned j=0; j<cc; j++)
+                coarse(i,j) = field( (j+0.5)/(double)cc, (i+0.5)/(double)rc);
+        back = coarse;
+        Matrix< complex<double> > ccoarse( rc, cc/2+1), cfine( rf, cf/2+1), cback( rc, cc/2+1);
+        DFT_DFT dft_coarse( rc, cc, FFTW_ESTIMATE), dft_fine( rf, cf, FFTW_ESTIMATE);
+        dft_coarse.r2c( coarse, ccoarse);
+        resize_spectrum( ccoarse, cfine);
+        dft_fine.c2r( cfine, fine);
+        double diff = 0;
+        for( unsigned i=0; i<rf; i++)
+            for( unsigned j=0; j<cf; j++)
+                diff = std::max( diff, fabs( fine(i,j) - field( (j+0.5)/(double)cf, (i+0.5)/(double)rf)));
+        cout << "Prolongation error "<<diff<<"\n";
+        cout << ( diff < 1e-12 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+        dft_fine.r2c( fine, cfine);
+        resize_spectrum( cfine, cback);
+        dft_coarse.c2r( cback, coarse);
+        diff = 0;
+        for( unsigned i=0; i<rc; i++)
+            for( unsigned j=0; j<cc; j++)
+                diff = std::max( diff, fabs( coarse(i,j) - back(i,j)));
+        cout << "Restriction error "<<diff<<"\n";
+        cout << ( diff < 1e-12 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+
+    cout << "Test whether a batch of transformations equals the single transformations...\n";
+    {
+        const size_t r = 24, c = 30, howmany = 3;
+        Matrix<double, TL_DFT> single( r, c);
+        Matrix< complex<double> > csingle( r, c/2+1);
+        const size_t dist = TotalNumberOf<TL_DFT>::elements( r, c) + 8; //a gap between the fields
+        MatrixPool pool( howmany*dist*sizeof(double));
+        std::vector< Matrix<double, TL_DFT> > fields;
+        fields.reserve( howmany);
+        for( unsigned m=0; m<howmany; m++)
+        {
+            pool.slot( m*dist*sizeof(double), dist*sizeof(double));
+            MatrixPool::Scope scope( pool);
+            fields.emplace_back( r, c, 0.);
+            init_gaussian( fields[m], 0.3 + 0.2*m, 0.5, 0.1, 0.2, 1.);
+        }
+        DFT_DFT dft( r, c, FFTW_ESTIMATE);
+        DFT_DFT_Batch batch( r, c, howmany, dist, FFTW_ESTIMATE);
+        bool equal = true;
+        batch.r2c( fields[0].getPtr());
+        for( unsigned m=0; m<howmany; m++)
+        {
+            single.zero();
+            init_gaussian( single, 0.3 + 0.2*m, 0.5, 0.1, 0.2, 1.);
+            dft.r2c( single, csingle);
+            Matrix< complex<double> > cfield( r, c/2+1, TL_VOID);
+            swap_fields( cfield, fields[m]);
+            equal = equal && ( csingle == cfield);
+            swap_fields( cfield, fields[m]);
+            swap_fields( single, csingle);
+        }
+        batch.c2r( fields[0].getPtr());
+        for( unsigned m=0; m<howmany; m++)
+        {
+            single.zero();
+            init_gaussian( single, 0.3 + 0.2*m, 0.5, 0.1, 0.2, 1.);
+            dft.r2c( single, csingle);
+            dft.c2r( csingle, single);
+            equal = equal && ( single == fields[m]);
+        }
+        cout << ( equal ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+
     fftw_cleanup();
     return 0;
 }
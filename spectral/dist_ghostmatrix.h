@@ -0,0 +1,181 @@
+/*!
+ * @file
+ * @brief GhostMatrix and Arakawa scheme for fields distributed linewise among MPI processes
+ */
+#ifndef _TL_DIST_GHOSTMATRIX_
+#define _TL_DIST_GHOSTMATRIX_
+
+#include <mpi.h>
+#include "ghostmatrix.h"
+#include "arakawa.h"
+
+namespace spectral{
+
+/*! @brief A GhostMatrix that is one block of lines of a distributed field
+ *
+ * @ingroup containers
+ * The global field is distributed linewise among the processes of
+ * a communicator, the process with rank 0 holding the first lines.
+ * The ghost lines between two processes are exchanged with
+ * nonblocking communication, the ghost columns and the ghost lines at the
+ * physical boundaries (first line of rank 0 and last line of the
+ * last rank) are initialized according to the boundary conditions
+ * like in a GhostMatrix. For TL_PERIODIC rows the first and the last
+ * process exchange their lines.
+ * @note Every process needs at least two lines.
+ */
+template< typename T, enum Padding P = TL_NONE>
+class DistGhostMatrix: public GhostMatrix<T,P>
+{
+  public:
+    /*! @brief Allocate memory for the local lines and the ghostcells.
+     *
+     * @param rows Rows of the local block
+     * @param cols Columns of the Matrix
+     * @param comm The communicator the field is distributed in
+     * @param bc_rows The boundary condition for the first and
+     *  the last line of the global field.
+     * @param bc_cols The boundary condition for the columns.
+     * @param allocate Whether memory shall be allocated or not. Ghostcells
+     * are always allocated.
+     */
+    DistGhostMatrix( const size_t rows, const size_t cols, MPI_Comm comm, const enum bc bc_rows = TL_PERIODIC, const enum bc bc_cols = TL_PERIODIC, const bool allocate = true);
+    /*! @brief Initialize ghost cells and exchange ghost lines
+     *
+     * Equals a call of initGhostCells_begin() followed by initGhostCells_end().
+     */
+    void initGhostCells( ){ initGhostCells_begin(); initGhostCells_end();}
+    /*! @brief Start the initialization of the ghost cells
+     *
+     * Initializes the ghost columns and the physical ghost lines and
+     * starts the exchange of the ghost lines with the neighbouring processes.
+     * The ghost lines must not be accessed nor the first and last line
+     * changed until initGhostCells_end() is called.
+     */
+    void initGhostCells_begin( );
+    /*! @brief Wait until the exchange of the ghost lines has finished
+     */
+    void initGhostCells_end( );
+    /*! @brief The communicator of the field
+     *
+     * @return the communicator
+     */
+    MPI_Comm communicator() const { return comm;}
+  private:
+    DistGhostMatrix( const DistGhostMatrix&); //requests cannot be copied
+    DistGhostMatrix& operator=( const DistGhostMatrix&);
+    MPI_Comm comm;
+    int up, down; //ranks of the processes holding the lines above and below
+    Matrix<T, TL_NONE> sendRows;
+    MPI_Request requests[4];
+    unsigned pending;
+};
+
+/*! @brief Arakawa scheme for linewise distributed fields
+ *
+ * @ingroup algorithms
+ * The communication of the ghost lines is overlapped with the computation
+ * of the lines that only need local values.
+ */
+class DistArakawa
+{
+  public:
+    /*! @brief constructor
+     *
+     * @param h the physical grid constant
+     * @param s the instruction set for the interior points
+     */
+    DistArakawa( const double h, const enum simd s = simd_support()): arakawa( h, s){}
+    /*! @brief Arakawa scheme on the local block of lines
+     *
+     * Initializes the ghostcells of lhs and rhs and computes the local
+     * lines of the Poisson bracket. The lines 1,...,rows-2 are computed
+     * while the ghost lines are communicated.
+     * @tparam T the value type of the GhostMatrix
+     * @tparam P the Padding of the GhostMatrix
+     * @tparam M    the type of the Matrix
+     * @param lhs the left function in the Poisson bracket (ghostcells initialized on output)
+     * @param rhs the right function in the Poisson bracket (ghostcells initialized on output)
+     * @param jac the Poisson bracket contains solution on output
+     */
+    template< class T, enum Padding P, class M>
+    void operator()( DistGhostMatrix<T,P>& lhs, DistGhostMatrix<T,P>& rhs, M& jac);
+  private:
+    Arakawa arakawa;
+};
+
+////////////////////////////////////////////DEFINITIONS////////////////////////////////////////////////
+template< typename T, enum Padding P>
+DistGhostMatrix<T,P>::DistGhostMatrix( const size_t rows, const size_t cols, MPI_Comm comm, const enum bc bc_rows, const enum bc bc_cols, const bool alloc):
+    GhostMatrix<T,P>( rows, cols, bc_rows, bc_cols, alloc), comm( comm), sendRows( 2, cols + 2), pending( 0)
+{
+    int rank, size;
+    MPI_Comm_rank( comm, &rank);
+    MPI_Comm_size( comm, &size);
+#ifdef TL_DEBUG
+    if( rows < 2)
+        throw Message( "Each process needs at least two lines!", _ping_);
+#endif
+    up   = rank - 1, down = rank + 1;
+    if( bc_rows == TL_PERIODIC)
+        up = (up + size)%size, down = down%size;
+    else
+    {
+        if( up < 0)     up   = MPI_PROC_NULL;
+        if( down >= size) down = MPI_PROC_NULL;
+    }
+}
+
+template< typename T, enum Padding P>
+void DistGhostMatrix<T,P>::initGhostCells_begin()
+{
+#ifdef TL_DEBUG
+    if( pending)
+        throw Message( "Exchange of ghost cells already in progress!", _ping_);
+#endif
+    GhostMatrix<T,P>::initGhostCells(); //columns and physical boundaries
+    const size_t rows = this->rows(), cols = this->cols();
+    const int bytes = (int)((cols + 2)*sizeof(T));
+    for( unsigned k = 0; k < 2; k++)
+    {
+        const size_t i = k ? rows - 1 : 0;
+        sendRows( k, 0) = this->ghostCols( i, 0);
+        for( size_t j = 0; j < cols; j++)
+            sendRows( k, j + 1) = (*this)( i, j);
+        sendRows( k, cols + 1) = this->ghostCols( i, 1);
+    }
+    //tag 0 travels upwards, tag 1 downwards
+    if( up != MPI_PROC_NULL)
+    {
+        MPI_Irecv( &this->ghostRows( 0, 0), bytes, MPI_BYTE, up,   1, comm, &requests[pending++]);
+        MPI_Isend( &sendRows( 0, 0),        bytes, MPI_BYTE, up,   0, comm, &requests[pending++]);
+    }
+    if( down != MPI_PROC_NULL)
+    {
+        MPI_Irecv( &this->ghostRows( 1, 0), bytes, MPI_BYTE, down, 0, comm, &requests[pending++]);
+        MPI_Isend( &sendRows( 1, 0),        bytes, MPI_BYTE, down, 1, comm, &requests[pending++]);
+    }
+}
+
+template< typename T, enum Padding P>
+void DistGhostMatrix<T,P>::initGhostCells_end()
+{
+    MPI_Waitall( pending, requests, MPI_STATUSES_IGNORE);
+    pending = 0;
+}
+
+template< class T, enum Padding P, class M>
+void DistArakawa::operator()( DistGhostMatrix<T,P>& lhs, DistGhostMatrix<T,P>& rhs, M& jac)
+{
+    const size_t rows = jac.rows();
+    lhs.initGhostCells_begin();
+    rhs.initGhostCells_begin();
+    arakawa.lines( lhs, rhs, jac, 1, rows - 1);
+    lhs.initGhostCells_end();
+    rhs.initGhostCells_end();
+    arakawa.lines( lhs, rhs, jac, 0, 1);
+    arakawa.lines( lhs, rhs, jac, rows - 1, rows);
+}
+
+} //namespace spectral
+#endif //_TL_DIST_GHOSTMATRIX_
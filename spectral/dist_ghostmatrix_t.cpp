@@ -0,0 +1,65 @@
+#include <iostream>
+#include <cmath>
+#include <cstdlib>
+#include "dist_ghostmatrix.h"
+
+using namespace std;
+using namespace spectral;
+
+//compare the distributed arakawa scheme with the serial one on the whole field
+//run with e.g. mpirun -n 3 ./dist_ghostmatrix_t
+int main( int argc, char* argv[])
+{
+    MPI_Init( &argc, &argv);
+    int rank, size;
+    MPI_Comm_rank( MPI_COMM_WORLD, &rank);
+    MPI_Comm_size( MPI_COMM_WORLD, &size);
+    const size_t local = 7, rows = local*size, cols = 20;
+    const double h = 1./(double)cols;
+    const enum bc bcs[] = { TL_PERIODIC, TL_DST00, TL_DST10, TL_DST01, TL_DST11};
+    const char* names[] = { "PERIODIC", "DST00", "DST10", "DST01", "DST11"};
+    bool passed = true;
+    Arakawa arakawa( h);
+    DistArakawa dist_arakawa( h);
+    for( unsigned b = 0; b < 5; b++)
+    {
+        GhostMatrix<double> lhs( rows, cols, bcs[b], TL_DST10), rhs( rows, cols, bcs[b], TL_DST10);
+        DistGhostMatrix<double> dlhs( local, cols, MPI_COMM_WORLD, bcs[b], TL_DST10), drhs( local, cols, MPI_COMM_WORLD, bcs[b], TL_DST10);
+        Matrix<double> jac( rows, cols), djac( local, cols);
+        srand( 42); //the same global field on every process
+        for( size_t i = 0; i < rows; i++)
+            for( size_t j = 0; j < cols; j++)
+            {
+                lhs( i, j) = (double)rand()/(double)RAND_MAX;
+                rhs( i, j) = (double)rand()/(double)RAND_MAX;
+            }
+        for( size_t i = 0; i < local; i++)
+            for( size_t j = 0; j < cols; j++)
+            {
+                dlhs( i, j) = lhs( rank*local + i, j);
+                drhs( i, j) = rhs( rank*local + i, j);
+            }
+        lhs.initGhostCells();
+        rhs.initGhostCells();
+        arakawa( lhs, rhs, jac);
+        dist_arakawa( dlhs, drhs, djac);
+        double diff = 0;
+        for( size_t i = 0; i < local; i++)
+        {
+            for( int j = -1; j <= (int)cols; j++)
+                diff = std::max( diff, fabs( dlhs.at( (int)i-1, j) - lhs.at( (int)(rank*local + i)-1, j)));
+            for( size_t j = 0; j < cols; j++)
+                diff = std::max( diff, fabs( djac( i, j) - jac( rank*local + i, j)));
+        }
+        double max_diff;
+        MPI_Allreduce( &diff, &max_diff, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+        if( rank == 0)
+            cout << names[b] << " rows on "<<size<<" processes: difference is "<<max_diff<<"\n";
+        if( max_diff > 1e-12)
+            passed = false;
+    }
+    if( rank == 0)
+        cout << (passed ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    MPI_Finalize();
+    return 0;
+}
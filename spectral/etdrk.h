@@ -0,0 +1,290 @@
+/*!
+ * @file
+ * @brief Exponential time differencing Runge-Kutta scheme (ETDRK2)
+ */
+#ifndef _TL_ETDRK_
+#define _TL_ETDRK_
+
+#include <array>
+#include <cmath>
+#include <complex>
+#include "matrix.h"
+#include "matrix_array.h"
+#include "quadmat.h"
+#include "karniadakis.h" //enum symmetry
+
+namespace spectral{
+
+///@cond
+namespace detail{
+inline double abs_value( const double x){ return fabs( x);}
+inline double abs_value( const std::complex<double>& x){ return std::abs( x);}
+//c = a*b
+template< typename T, size_t m>
+void multiply( const QuadMat<T,m>& a, const QuadMat<T,m>& b, QuadMat<T,m>& c)
+{
+    for( size_t i=0; i<m; i++)
+        for( size_t j=0; j<m; j++)
+        {
+            c(i,j) = a(i,0)*b(0,j);
+            for( size_t k=1; k<m; k++)
+                c(i,j) += a(i,k)*b(k,j);
+        }
+}
+//matrix exponential by scaling and squaring of the taylor series
+template< typename T, size_t m>
+void exponential( const QuadMat<T,m>& a, QuadMat<T,m>& e)
+{
+    double norm = 0; //maximum column sum
+    for( size_t j=0; j<m; j++)
+    {
+        double sum = 0;
+        for( size_t i=0; i<m; i++)
+            sum += abs_value( a(i,j));
+        norm = std::max( norm, sum);
+    }
+    //scale such that the norm is below 1/2
+    int s = 0;
+    if( norm > 0.5)
+        s = (int)ceil( log2( norm/0.5));
+    const double scale = ldexp( 1., -s);
+    QuadMat<T,m> as, term, temp;
+    for( size_t i=0; i<m*m; i++)
+        as(i/m,i%m) = scale*a(i/m,i%m);
+    //the taylor series converges to machine precision within 18 terms
+    e.zero(), term.zero();
+    for( size_t i=0; i<m; i++)
+        e(i,i) = term(i,i) = 1;
+    for( unsigned k=1; k<=18; k++)
+    {
+        multiply( term, as, temp);
+        for( size_t i=0; i<m; i++)
+            for( size_t j=0; j<m; j++)
+            {
+                term(i,j) = temp(i,j)/(double)k;
+                e(i,j) += term(i,j);
+            }
+    }
+    for( int k=0; k<s; k++)
+    {
+        multiply( e, e, temp);
+        e = temp;
+    }
+}
+} //namespace detail
+///@endcond
+
+/*! @brief Compute the matrix exponential and the first two phi functions of a matrix
+ *
+ * @ingroup algorithms
+ * phi_1( a) = a^{-1}( e^a - 1) and phi_2( a) = a^{-2}( e^a - 1 - a) are
+ * computed without the inverse (and thus also for singular a) as blocks of the
+ * exponential of the augmented matrix
+ * \f[ \begin{pmatrix} a & 1 & 0 \\ 0 & 0 & 1 \\ 0 & 0 & 0 \end{pmatrix} \f]
+ * @tparam T double or std::complex<double>
+ * @tparam n size of the matrix
+ * @param a The matrix
+ * @param e contains e^a on output
+ * @param phi1 contains phi_1( a) on output
+ * @param phi2 contains phi_2( a) on output
+ */
+template< typename T, size_t n>
+void phi_functions( const QuadMat<T,n>& a, QuadMat<T,n>& e, QuadMat<T,n>& phi1, QuadMat<T,n>& phi2)
+{
+    QuadMat<T,3*n> aug, exp_aug;
+    aug.zero();
+    for( size_t i=0; i<n; i++)
+    {
+        for( size_t j=0; j<n; j++)
+            aug(i,j) = a(i,j);
+        aug(i,n+i) = aug(n+i,2*n+i) = 1;
+    }
+    detail::exponential( aug, exp_aug);
+    for( size_t i=0; i<n; i++)
+        for( size_t j=0; j<n; j++)
+        {
+            e(i,j) = exp_aug(i,j);
+            phi1(i,j) = exp_aug(i,n+j);
+            phi2(i,j) = exp_aug(i,2*n+j);
+        }
+}
+
+/*! @brief The exponential time differencing Runge Kutta scheme of second order
+ *
+ * @ingroup algorithms
+ * Solves d/dt v = c v + N( v) where the linear part c is a
+ * n x n matrix for every fourier mode (as in the Karniadakis scheme) and
+ * N the nonlinearity. The linear part is integrated exactly, which
+ * removes the timestep restriction of stiff linear terms (e.g. hyperviscosity).
+ * One step of the scheme of Cox and Matthews is
+ * \f[ a = e^{c\Delta t}v^n + \Delta t\phi_1(c\Delta t) N(v^n) \f]
+ * \f[ v^{n+1} = a + \Delta t\phi_2( c\Delta t)( N(a) - N( v^n)) \f]
+ * and thus needs two evaluations of the nonlinearity.
+ * The matrix exponentials and phi functions are precomputed once in init_coeff.
+ * The nonlinearity has to be given in fourier space.
+ * @tparam n Number of equations
+ * @tparam T_k The type of the coefficients and fields in fourier space (double or std::complex<double>)
+ */
+template< size_t n, typename T_k>
+class ETDRK
+{
+  public:
+    /*! @brief Allocate storage for the fourier coefficients
+     *
+     * @param rows_k rows of fourier coefficients
+     * @param cols_k columns of fourier coefficients
+     * @param dt the timestep
+     * @param sym the symmetry of your k-space coefficients (cf. Karniadakis)
+     * @note Memory is allocated in init_coeff
+     */
+    ETDRK( const size_t rows_k, const size_t cols_k, const double dt, const enum symmetry sym = TL_GENERAL);
+    /*! @brief Compute the exponentials and phi functions of the coefficients
+     *
+     * @param coeff the fourier coefficients c (unchanged)
+     * @param normalisation
+        A numerical discrete fourier transformation followed by its inverse usually
+        yields the input times a constant factor. State this factor here to normalize the
+        output of predict and correct.
+     * @note May be called again with new coefficients, the storage is reused.
+     */
+    void init_coeff( const Matrix<QuadMat<T_k, n> >& coeff, const double normalisation);
+    /*! @brief Compute the first stage of a step
+     *
+     * @param v the fourier transformed field v^n on input,
+     *  the normalized stage a on output
+     * @param nl the fourier transformed nonlinearity N( v^n) (unchanged)
+     */
+    void predict( std::array< Matrix<T_k, TL_NONE>, n>& v, const std::array< Matrix<T_k, TL_NONE>, n>& nl);
+    /*! @brief Complete the step
+     *
+     * @param v contains the normalized v^{n+1} on output (input ignored)
+     * @param nl the fourier transformed nonlinearity N( a) of the stage (unchanged)
+     * @attention call predict before
+     */
+    void correct( std::array< Matrix<T_k, TL_NONE>, n>& v, const std::array< Matrix<T_k, TL_NONE>, n>& nl);
+    /*! @brief The timestep
+     *
+     * @return the timestep
+     */
+    double timestep() const { return dt;}
+  private:
+    //the element of line i of the (hermitian) table
+    T_k coeff( const Matrix< QuadMat< T_k, n> >& c, const size_t i, const size_t j, const unsigned k, const unsigned q) const
+    {
+        if( i < c.rows())
+            return c(i,j)(k,q);
+        return detail::conj_if( c( rows - i, j)(k,q), true);
+    }
+    const size_t rows, cols;
+    const double dt;
+    const enum symmetry sym;
+    Matrix< QuadMat< T_k, n> > e, q, p; //e^{c dt}, dt*(phi1 - phi2) and dt*phi2 (normalized)
+    std::array< Matrix< T_k, TL_NONE>, n> w; //e v^n + dt*(phi1 - phi2) N( v^n)
+};
+
+/////////////////////////////////////DEFINITIONS//////////////////////////////////
+template< size_t n, typename T_k>
+ETDRK<n,T_k>::ETDRK( const size_t rows, const size_t cols, const double dt, const enum symmetry sym):
+    rows( rows), cols( cols), dt( dt), sym( sym),
+    e( sym == TL_HERMITIAN ? rows/2 + 1 : rows, cols, TL_VOID), q( e), p( e),
+    w( MatrixArray< T_k, TL_NONE, n>::construct( rows, cols))
+{ 
+    for( unsigned k=0; k<n; k++) //w is allocated in init_coeff
+    {
+        Matrix< T_k, TL_NONE> temp( rows, cols, (bool)TL_VOID);
+        swap_fields( temp, w[k]);
+    }
+}
+
+template< size_t n, typename T_k>
+void ETDRK<n,T_k>::init_coeff( const Matrix<QuadMat<T_k, n> >& coeff, const double normalisation)
+{
+    const size_t crows = e.rows();
+#ifdef TL_DEBUG
+    if( normalisation < 1.)
+        throw Message( "Yield the prefactor, not its inverse!", _ping_);
+    if( coeff.isVoid())
+        throw Message("Your coefficients are void!", _ping_);
+    if( coeff.rows() != rows || coeff.cols() != cols)
+        throw Message("Your coefficients have wrong size!\n", _ping_);
+#endif
+    if( e.isVoid())
+    {
+        e.allocate(), q.allocate(), p.allocate();
+        for( unsigned k=0; k<n; k++)
+            w[k].allocate();
+    }
+#pragma omp parallel for
+    for( size_t i=0; i<crows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            QuadMat<T_k,n> a, phi1, phi2;
+            for( unsigned k=0; k<n; k++)
+                for( unsigned l=0; l<n; l++)
+                    a(k,l) = dt*coeff(i,j)(k,l);
+            phi_functions( a, e(i,j), phi1, phi2);
+            for( unsigned k=0; k<n; k++)
+                for( unsigned l=0; l<n; l++)
+                {
+                    e(i,j)(k,l) /= normalisation;
+                    q(i,j)(k,l) = dt*( phi1(k,l) - phi2(k,l))/normalisation;
+                    p(i,j)(k,l) = dt*phi2(k,l)/normalisation;
+                }
+        }
+}
+
+template< size_t n, typename T_k>
+void ETDRK<n,T_k>::predict( std::array< Matrix<T_k, TL_NONE>, n>& v, const std::array< Matrix<T_k, TL_NONE>, n>& nl)
+{
+#ifdef TL_DEBUG
+    if( e.isVoid())
+        throw Message( "Init coefficients first!", _ping_);
+    for( unsigned k=0; k<n; k++)
+        if( v[k].rows() != rows || v[k].cols() != cols || nl[k].rows() != rows || nl[k].cols() != cols)
+            throw Message( "Matrix has wrong size!\n", _ping_);
+#endif
+#pragma omp parallel for
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            T_k ev[n];
+            for( unsigned k=0; k<n; k++)
+            {
+                ev[k] = coeff( e, i,j,k,0)*v[0](i,j);
+                T_k qn = coeff( q, i,j,k,0)*nl[0](i,j), pn = coeff( p, i,j,k,0)*nl[0](i,j);
+                for( unsigned l=1; l<n; l++)
+                {
+                    ev[k] += coeff( e, i,j,k,l)*v[l](i,j);
+                    qn += coeff( q, i,j,k,l)*nl[l](i,j);
+                    pn += coeff( p, i,j,k,l)*nl[l](i,j);
+                }
+                w[k](i,j) = ev[k] + qn;
+                ev[k] = w[k](i,j) + pn;
+            }
+            for( unsigned k=0; k<n; k++)
+                v[k](i,j) = ev[k];
+        }
+}
+
+template< size_t n, typename T_k>
+void ETDRK<n,T_k>::correct( std::array< Matrix<T_k, TL_NONE>, n>& v, const std::array< Matrix<T_k, TL_NONE>, n>& nl)
+{
+#ifdef TL_DEBUG
+    for( unsigned k=0; k<n; k++)
+        if( v[k].rows() != rows || v[k].cols() != cols || nl[k].rows() != rows || nl[k].cols() != cols)
+            throw Message( "Matrix has wrong size!\n", _ping_);
+#endif
+#pragma omp parallel for
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+            for( unsigned k=0; k<n; k++)
+            {
+                T_k pn = coeff( p, i,j,k,0)*nl[0](i,j);
+                for( unsigned l=1; l<n; l++)
+                    pn += coeff( p, i,j,k,l)*nl[l](i,j);
+                v[k](i,j) = w[k](i,j) + pn;
+            }
+}
+
+} //namespace spectral
+#endif //_TL_ETDRK_
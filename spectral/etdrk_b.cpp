@@ -0,0 +1,135 @@
+#include <iostream>
+#include <iomanip>
+#include <array>
+#include <cmath>
+#include <omp.h>
+
+#include "etdrk.h"
+#include "karniadakis.h"
+#include "matrix.h"
+
+#include "timer.h"
+
+using namespace std;
+using namespace spectral;
+
+//accuracy per wall-second of the ETDRK and the Karniadakis scheme
+//for a stiff linear part (hyperviscosity) and a quadratic nonlinearity
+const size_t rows = 256, cols = 256;
+const double T = 1.;
+const double nu = 1e-6;
+
+Matrix< QuadMat<double,2> > coefficients( rows, cols);
+
+void linear( Matrix< QuadMat<double,2> >& c)
+{
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            const double k2 = (double)(i*i + j*j) + 1.;
+            c(i,j)(0,0) = -nu*k2*k2, c(i,j)(0,1) = 1.;
+            c(i,j)(1,0) = -1.,       c(i,j)(1,1) = -0.5;
+        }
+}
+void nonlinear( const std::array< Matrix<double>, 2>& v, std::array< Matrix<double>, 2>& nl)
+{
+#pragma omp parallel for
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            nl[0](i,j) = 0.5*v[1](i,j)*v[1](i,j);
+            nl[1](i,j) = -0.5*v[0](i,j)*v[1](i,j);
+        }
+}
+std::array< Matrix<double>, 2> init()
+{
+    std::array< Matrix<double>, 2> v{{ Matrix<double>( rows, cols), Matrix<double>( rows, cols)}};
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+            v[0](i,j) = 1., v[1](i,j) = 1./(1. + i + j);
+    return v;
+}
+
+//the time for init_coeff is returned in init_time
+std::array< Matrix<double>, 2> etdrk( unsigned steps, double& init_time)
+{
+    Timer t;
+    ETDRK<2,double> etd( rows, cols, T/(double)steps);
+    t.tic();
+    etd.init_coeff( coefficients, 1.);
+    t.toc();
+    init_time = t.diff();
+    std::array< Matrix<double>, 2> v = init(), nl( v);
+    for( unsigned s=0; s<steps; s++)
+    {
+        nonlinear( v, nl);
+        etd.predict( v, nl);
+        nonlinear( v, nl);
+        etd.correct( v, nl);
+    }
+    return v;
+}
+
+std::array< Matrix<double>, 2> karniadakis( unsigned steps, double& init_time)
+{
+    Timer t;
+    Karniadakis<2,double,TL_NONE> k( rows, cols, rows, cols, T/(double)steps);
+    Matrix< QuadMat<double,2> > c( coefficients);
+    t.tic();
+    k.init_coeff( c, 1.);
+    t.toc();
+    init_time = t.diff();
+    std::array< Matrix<double>, 2> v = init(), nl( v);
+    nonlinear( v, nl);
+    k.invert_coeff<TL_EULER>();
+    k.step_i<TL_EULER>( v, nl);
+    k.step_ii( v);
+    nonlinear( v, nl);
+    k.invert_coeff<TL_ORDER2>();
+    k.step_i<TL_ORDER2>( v, nl);
+    k.step_ii( v);
+    k.invert_coeff<TL_ORDER3>();
+    for( unsigned s=2; s<steps; s++)
+    {
+        nonlinear( v, nl);
+        k.step_i<TL_ORDER3>( v, nl);
+        k.step_ii( v);
+    }
+    return v;
+}
+
+double error( const std::array< Matrix<double>, 2>& v, const std::array< Matrix<double>, 2>& ref)
+{
+    double diff = 0;
+    for( unsigned k=0; k<2; k++)
+        for( size_t i=0; i<rows; i++)
+            for( size_t j=0; j<cols; j++)
+                diff = max( diff, fabs( v[k](i,j) - ref[k](i,j)));
+    return diff;
+}
+
+int main()
+{
+    cout << "With "<<omp_get_max_threads()<<" threads\n";
+    cout << rows<<"x"<<cols<<" modes, stiffest mode decays with rate "<<nu*pow(2.*rows*rows,2)<<"\n";
+    linear( coefficients);
+    Timer t;
+    double init_e, init_k;
+    const std::array< Matrix<double>, 2> ref = etdrk( 4096, init_e);
+    cout << "Error at t = "<<T<<" and time for the steps (init_coeff)\n";
+    cout << scientific << setprecision(2);
+    cout << "steps   ETDRK                         Karniadakis\n";
+    for( unsigned steps = 16; steps <= 256; steps*=2)
+    {
+        t.tic();
+        std::array< Matrix<double>, 2> v = etdrk( steps, init_e);
+        t.toc();
+        const double err_e = error( v, ref), time_e = t.diff() - init_e;
+        t.tic();
+        v = karniadakis( steps, init_k);
+        t.toc();
+        cout << setw(5) << steps << "   "<< err_e << " " << time_e<<"s ("<<init_e<<"s)   "
+             << error( v, ref) << " "<<t.diff() - init_k<<"s ("<<init_k<<"s)\n";
+    }
+    return 0;
+}
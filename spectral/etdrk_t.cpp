@@ -0,0 +1,97 @@
+#include <iostream>
+#include <cmath>
+#include <complex>
+#include "etdrk.h"
+#include "matrix.h"
+#include "quadmat.h"
+
+using namespace std;
+using namespace spectral;
+
+typedef std::complex<double> Complex;
+
+const size_t rows = 3, cols = 2;
+//a stiff linear part and a quadratic nonlinearity
+void linear( Matrix< QuadMat<double,2> >& c)
+{
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            const double k2 = (double)(i*i + j*j) + 1.;
+            c(i,j)(0,0) = -0.1*k2*k2*k2, c(i,j)(0,1) = 1.;
+            c(i,j)(1,0) = -1.,          c(i,j)(1,1) = -0.5;
+        }
+}
+void nonlinear( const std::array< Matrix<double>, 2>& v, std::array< Matrix<double>, 2>& nl)
+{
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            nl[0](i,j) = 0.5*v[1](i,j)*v[1](i,j);
+            nl[1](i,j) = -0.5*v[0](i,j)*v[1](i,j);
+        }
+}
+//integrate to t = 1 with the given number of steps
+std::array< Matrix<double>, 2> integrate( unsigned steps)
+{
+    Matrix< QuadMat<double,2> > c( rows, cols);
+    linear( c);
+    ETDRK<2,double> etdrk( rows, cols, 1./(double)steps);
+    etdrk.init_coeff( c, 1.);
+    std::array< Matrix<double>, 2> v{{ Matrix<double>( rows, cols, 1.), Matrix<double>( rows, cols, 0.5)}}, nl( v);
+    for( unsigned s=0; s<steps; s++)
+    {
+        nonlinear( v, nl);
+        etdrk.predict( v, nl);
+        nonlinear( v, nl);
+        etdrk.correct( v, nl);
+    }
+    return v;
+}
+
+int main()
+{
+    bool passed = true;
+    cout << "Test phi functions of a diagonal matrix against the closed form...\n";
+    {
+        const Complex lambda[] = { Complex( -0.3, 2.), Complex( -50., 0.), Complex( 1e-9, 0), Complex( 0, 0)};
+        double diff = 0;
+        for( unsigned l=0; l<4; l++)
+        {
+            QuadMat<Complex,2> a, e, phi1, phi2;
+            a.zero();
+            a(0,0) = lambda[l], a(1,1) = 2.*lambda[l];
+            phi_functions( a, e, phi1, phi2);
+            for( unsigned k=0; k<2; k++)
+            {
+                const Complex z = a(k,k);
+                //use the taylor series for small arguments
+                const Complex p1 = abs(z) < 1e-5 ? 1. + z/2. : (exp(z) - 1.)/z;
+                const Complex p2 = abs(z) < 1e-5 ? 0.5 + z/6. : (exp(z) - 1. - z)/z/z;
+                diff = max( diff, abs( e(k,k) - exp(z))/abs( exp(z)));
+                diff = max( diff, abs( phi1(k,k) - p1)/abs( p1));
+                diff = max( diff, abs( phi2(k,k) - p2)/abs( p2));
+                diff = max( diff, abs( e(k,1-k)) + abs( phi1(k,1-k)) + abs( phi2(k,1-k)));
+            }
+        }
+        cout << "Relative difference "<<diff<<"\n";
+        if( diff > 1e-12) passed = false;
+    }
+    cout << "Test the order of convergence with a stiff linear part...\n";
+    {
+        std::array< Matrix<double>, 2> ref = integrate( 1024), v1 = integrate( 32), v2 = integrate( 64);
+        double e1 = 0, e2 = 0;
+        for( unsigned k=0; k<2; k++)
+            for( size_t i=0; i<rows; i++)
+                for( size_t j=0; j<cols; j++)
+                {
+                    e1 = max( e1, fabs( v1[k](i,j) - ref[k](i,j)));
+                    e2 = max( e2, fabs( v2[k](i,j) - ref[k](i,j)));
+                }
+        cout << "Error with 32 steps "<<e1<<", with 64 steps "<<e2<<"\n";
+        cout << "Order "<<log2( e1/e2)<<"\n";
+        if( log2( e1/e2) < 1.8) passed = false;
+    }
+    cout << ( passed ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    return 0;
+}
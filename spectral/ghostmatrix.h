@@ -95,7 +95,7 @@ class GhostMatrix: public Matrix<T,P>
      *
      */
     inline void initGhostCells( );
-  private:
+  protected:
     enum bc bc_rows, bc_cols;
     Matrix<T,TL_NONE> ghostRows;
     Matrix<T,TL_NONE> ghostCols;
@@ -1,9 +1,17 @@
 #ifndef _TL_KARNIADAKIS_
 #define _TL_KARNIADAKIS_
 #include <array>
+#include <vector>
+#include <complex>
+#include <memory>
+#include <algorithm>
 #include "matrix.h"
 #include "matrix_array.h"
 #include "quadmat.h"
+#include "binary.h"
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace spectral{
 /*! @brief Kinds of Stepper coefficients for karniadakis scheme
@@ -14,6 +22,20 @@ enum stepper { TL_EULER, //!< Euler scheme (use for 1st step)
                TL_ORDER3  //!< 3rd order scheme ( the "usual" karniadakis scheme)
              };
 
+/*! @brief Symmetries of the fourier coefficients in the karniadakis scheme
+ * @ingroup algorithms
+ */
+enum symmetry { TL_GENERAL, //!< No symmetry, all coefficients are stored
+                TL_HERMITIAN //!< Line rows-i holds the complex conjugate coefficients of line i (the lines are the frequencies of a complex dft)
+              };
+
+/*! @brief Precision of the older levels stored in the karniadakis scheme
+ * @ingroup algorithms
+ */
+enum precision { TL_DOUBLE, //!< All levels are stored in double precision
+                 TL_FLOAT //!< The last two fields and nonlinearities are stored in single precision
+               };
+
 /*! @brief template traits class for various sets of coefficients in the karniadakis scheme from the karniadakis paper
  * @ingroup algorithms
  */
@@ -47,6 +69,75 @@ template<>
 const double Coefficients<TL_ORDER3>::beta[3] = {3.,-3.,1.};
 ///@endcond
 
+/*! @brief Set of coefficients of the karniadakis scheme known at runtime
+ * @ingroup algorithms
+ *
+ * Like the Coefficients traits class but for variable timesteps.
+ */
+struct StepCoefficients
+{
+    double gamma_0; //!< Coefficient in the dft part
+    double alpha[3]; //!< Coefficients for the timestep
+    double beta[3]; //!< Coefficients fot the nonlinear part in the timestep.
+};
+
+/*! @brief The coefficients of a stepper with constant timestep
+ * @ingroup algorithms
+ * @tparam S the stepper
+ * @return the Coefficients<S> 
+ */
+template< enum stepper S>
+inline StepCoefficients step_coefficients()
+{
+    StepCoefficients c;
+    c.gamma_0 = Coefficients<S>::gamma_0;
+    for( unsigned q=0; q<3; q++)
+        c.alpha[q] = Coefficients<S>::alpha[q], c.beta[q] = Coefficients<S>::beta[q];
+    return c;
+}
+
+/*! @brief The coefficients of the karniadakis scheme for variable timesteps
+ * @ingroup algorithms
+ *
+ * The implicit part is the backward differentiation formula and the 
+ * explicit part the extrapolation of the nonlinearity through the 
+ * last order timesteps, both with nonuniform nodes. 
+ * For equal timesteps the coefficients equal Coefficients<S>.
+ * @param order The order of the scheme (1, 2 or 3)
+ * @param h0 The timestep to be done
+ * @param h1 The timestep before (ignored for order 1)
+ * @param h2 The timestep before h1 (ignored for order 1 and 2)
+ * @return the coefficients normalized to the timestep h0
+ */
+inline StepCoefficients step_coefficients( const unsigned order, const double h0, const double h1, const double h2)
+{
+#ifdef TL_DEBUG
+    if( order < 1 || order > 3)
+        throw Message( "Order must be 1, 2 or 3!", _ping_);
+#endif
+    const double tau[4] = { 0, -h0, -h0-h1, -h0-h1-h2}; //the nodes relative to the new time
+    StepCoefficients c = {0, {0,0,0}, {0,0,0}};
+    for( unsigned k=1; k<=order; k++)
+        c.gamma_0 += h0/( tau[0] - tau[k]);
+    for( unsigned q=1; q<=order; q++)
+    {
+        //derivative of the lagrange polynomial of node q at tau[0]
+        double num = 1., den = tau[q] - tau[0]; 
+        //lagrange polynomial of node q without node 0 at tau[0]
+        double beta = 1.;
+        for( unsigned k=1; k<=order; k++)
+        {
+            if( k == q) continue;
+            num *= tau[0] - tau[k];
+            den *= tau[q] - tau[k];
+            beta *= ( tau[0] - tau[k])/( tau[q] - tau[k]);
+        }
+        c.alpha[q-1] = -h0*num/den;
+        c.beta[q-1] = beta;
+    }
+    return c;
+}
+
 /*! @brief pointwise multiply the n x n Matrix of coefficients by a n-vector of matrices  
  *
  * @ingroup algorithms
@@ -97,6 +188,194 @@ void multiply_coeff( const Matrix< QuadMat<T1,n>, TL_NONE>& c,
     }
 }
 
+///@cond
+namespace detail{
+inline double conj_if( const double c, const bool){ return c;}
+inline std::complex<double> conj_if( const std::complex<double>& c, const bool conj){ return conj ? std::conj(c) : c;}
+//x_k = sum_q c_kq x_q on one line of planar coefficients (generic version)
+//(with the complex conjugate of c if conj is true)
+template< size_t n, typename T1, typename T>
+struct MultiplyLine
+{
+    static void apply( const T1* const* c, T* const* x, const size_t cols, const bool conj)
+    {
+        T temp[n];
+        for( size_t j=0; j<cols; j++)
+        {
+            for( unsigned k=0; k<n; k++)
+            {
+                temp[k] = conj_if( c[k*n][j], conj)*x[0][j];
+                for( unsigned q=1; q<n; q++)
+                    temp[k] += conj_if( c[k*n+q][j], conj)*x[q][j];
+            }
+            for( unsigned k=0; k<n; k++)
+                x[k][j] = temp[k];
+        }
+    }
+};
+//complex products are written out in real arithmetic (std::complex 
+//multiplication checks for NaNs and does not vectorise)
+//(sg = -1 multiplies by the complex conjugate of c)
+#define TL_CMUL_RE( c, x) ( c[2*j]*x[2*j]   - sg*c[2*j+1]*x[2*j+1])
+#define TL_CMUL_IM( c, x) ( c[2*j]*x[2*j+1] + sg*c[2*j+1]*x[2*j])
+template<>
+struct MultiplyLine< 2, std::complex<double>, std::complex<double> >
+{
+    static void apply( const std::complex<double>* const* cc, std::complex<double>* const* xx, const size_t cols, const bool conj)
+    {
+        const double sg = conj ? -1. : 1.;
+        const double* __restrict__ c00 = reinterpret_cast<const double*>( cc[0]);
+        const double* __restrict__ c01 = reinterpret_cast<const double*>( cc[1]);
+        const double* __restrict__ c10 = reinterpret_cast<const double*>( cc[2]);
+        const double* __restrict__ c11 = reinterpret_cast<const double*>( cc[3]);
+        double* __restrict__ x0 = reinterpret_cast<double*>( xx[0]);
+        double* __restrict__ x1 = reinterpret_cast<double*>( xx[1]);
+#pragma omp simd
+        for( size_t j=0; j<cols; j++)
+        {
+            const double y0r = TL_CMUL_RE( c00, x0) + TL_CMUL_RE( c01, x1);
+            const double y0i = TL_CMUL_IM( c00, x0) + TL_CMUL_IM( c01, x1);
+            const double y1r = TL_CMUL_RE( c10, x0) + TL_CMUL_RE( c11, x1);
+            const double y1i = TL_CMUL_IM( c10, x0) + TL_CMUL_IM( c11, x1);
+            x0[2*j] = y0r, x0[2*j+1] = y0i;
+            x1[2*j] = y1r, x1[2*j+1] = y1i;
+        }
+    }
+};
+template<>
+struct MultiplyLine< 3, std::complex<double>, std::complex<double> >
+{
+    static void apply( const std::complex<double>* const* cc, std::complex<double>* const* xx, const size_t cols, const bool conj)
+    {
+        const double sg = conj ? -1. : 1.;
+        const double* __restrict__ c00 = reinterpret_cast<const double*>( cc[0]);
+        const double* __restrict__ c01 = reinterpret_cast<const double*>( cc[1]);
+        const double* __restrict__ c02 = reinterpret_cast<const double*>( cc[2]);
+        const double* __restrict__ c10 = reinterpret_cast<const double*>( cc[3]);
+        const double* __restrict__ c11 = reinterpret_cast<const double*>( cc[4]);
+        const double* __restrict__ c12 = reinterpret_cast<const double*>( cc[5]);
+        const double* __restrict__ c20 = reinterpret_cast<const double*>( cc[6]);
+        const double* __restrict__ c21 = reinterpret_cast<const double*>( cc[7]);
+        const double* __restrict__ c22 = reinterpret_cast<const double*>( cc[8]);
+        double* __restrict__ x0 = reinterpret_cast<double*>( xx[0]);
+        double* __restrict__ x1 = reinterpret_cast<double*>( xx[1]);
+        double* __restrict__ x2 = reinterpret_cast<double*>( xx[2]);
+#pragma omp simd
+        for( size_t j=0; j<cols; j++)
+        {
+            const double y0r = TL_CMUL_RE( c00, x0) + TL_CMUL_RE( c01, x1) + TL_CMUL_RE( c02, x2);
+            const double y0i = TL_CMUL_IM( c00, x0) + TL_CMUL_IM( c01, x1) + TL_CMUL_IM( c02, x2);
+            const double y1r = TL_CMUL_RE( c10, x0) + TL_CMUL_RE( c11, x1) + TL_CMUL_RE( c12, x2);
+            const double y1i = TL_CMUL_IM( c10, x0) + TL_CMUL_IM( c11, x1) + TL_CMUL_IM( c12, x2);
+            const double y2r = TL_CMUL_RE( c20, x0) + TL_CMUL_RE( c21, x1) + TL_CMUL_RE( c22, x2);
+            const double y2i = TL_CMUL_IM( c20, x0) + TL_CMUL_IM( c21, x1) + TL_CMUL_IM( c22, x2);
+            x0[2*j] = y0r, x0[2*j+1] = y0i;
+            x1[2*j] = y1r, x1[2*j+1] = y1i;
+            x2[2*j] = y2r, x2[2*j+1] = y2i;
+        }
+    }
+};
+#undef TL_CMUL_RE
+#undef TL_CMUL_IM
+//multiply line i of v by the planar coefficients with crows lines per plane
+template< size_t n, typename T1, typename T>
+inline void multiply_planar_line( const Matrix< T1, TL_NONE>& c, std::array< Matrix<T,TL_NONE>, n>& v, const size_t crows, const size_t i)
+{
+    const size_t rows = v[0].rows();
+    const bool conj = ( i >= crows);
+    const size_t ic = conj ? rows - i : i;
+    const T1* cl[n*n];
+    T* vl[n];
+    for( unsigned kq=0; kq<n*n; kq++)
+        cl[kq] = &c( kq*crows + ic, 0);
+    for( unsigned k=0; k<n; k++)
+        vl[k] = &v[k](i,0);
+    MultiplyLine<n,T1,T>::apply( cl, vl, v[0].cols(), conj);
+}
+} //namespace detail
+///@endcond
+
+/*! @brief pointwise multiply planar coefficients by a n-vector of matrices inplace
+ *
+ * @ingroup algorithms
+ * Same as above but the coefficients are stored as n*n planes of 
+ * rows x cols values in one Matrix (i.e. c has n*n*rows lines, and 
+ * the plane of c_kq starts at line (k*n+q)*rows).
+ * For TL_HERMITIAN coefficients only the lines 0,...,rows/2 are stored 
+ * (i.e. c has n*n*(rows/2+1) lines) and the line i > rows/2 is 
+ * the complex conjugate of line rows-i.
+ * For n = 2 and n = 3 and complex values the kernels are unrolled 
+ * and written in real arithmetic such that the compiler can vectorise them.
+ * @tparam T1 type of the coefficients i.e. double or std::complex<double>
+ * @tparam T type of the matrix elements, i.e. double or std::complex<double>
+ * @param c the planar coefficients 
+ * @param v Input vector of matrices. Contains solution on output.
+ * @param sym the symmetry of the coefficients
+ */
+template< size_t n, typename T1, typename T>
+void multiply_coeff( const Matrix< T1, TL_NONE>& c, 
+                     std::array< Matrix<T,TL_NONE>, n>& v, 
+                     const enum symmetry sym = TL_GENERAL)
+{
+    const size_t rows = v[0].rows();
+    const size_t crows = ( sym == TL_HERMITIAN) ? rows/2 + 1 : rows;
+#ifdef TL_DEBUG
+    const size_t cols = v[0].cols();
+    if( c.isVoid())
+        throw Message( "Cannot work with void Matrices!\n", _ping_);
+    if( c.rows() != n*n*crows || c.cols() != cols)
+        throw Message( "Cannot multiply coefficients! Sizes not equal!", _ping_);
+    for( unsigned k=0; k<n; k++)
+    {
+        if( v[k].rows() != rows || v[k].cols() != cols)
+            throw Message( "Cannot multiply coefficients! Sizes not equal!", _ping_);
+        if( v[k].isVoid() )
+            throw Message( "Cannot work with void Matrices!\n", _ping_);
+    }
+#endif
+#pragma omp parallel for 
+    for( size_t i = 0; i<rows; i++)
+        detail::multiply_planar_line<n,T1,T>( c, v, crows, i);
+}
+
+/*! @brief pointwise multiply planar coefficients by some lines of a n-vector of matrices inplace
+ *
+ * @ingroup algorithms
+ * Same as above but only for the lines i_begin <= i < i_end and 
+ * without opening a parallel region, i.e. the threads of an enclosing 
+ * parallel region can multiply disjoint sets of lines.
+ * @tparam T1 type of the coefficients i.e. double or std::complex<double>
+ * @tparam T type of the matrix elements, i.e. double or std::complex<double>
+ * @param c the planar coefficients 
+ * @param v Input vector of matrices. Contains solution in the given lines on output.
+ * @param i_begin first line
+ * @param i_end one past the last line
+ * @param sym the symmetry of the coefficients
+ */
+template< size_t n, typename T1, typename T>
+void multiply_coeff( const Matrix< T1, TL_NONE>& c, 
+                     std::array< Matrix<T,TL_NONE>, n>& v, 
+                     const size_t i_begin, const size_t i_end, 
+                     const enum symmetry sym = TL_GENERAL)
+{
+    const size_t rows = v[0].rows();
+    const size_t crows = ( sym == TL_HERMITIAN) ? rows/2 + 1 : rows;
+#ifdef TL_DEBUG
+    const size_t cols = v[0].cols();
+    if( c.isVoid())
+        throw Message( "Cannot work with void Matrices!\n", _ping_);
+    if( c.rows() != n*n*crows || c.cols() != cols)
+        throw Message( "Cannot multiply coefficients! Sizes not equal!", _ping_);
+    for( unsigned k=0; k<n; k++)
+        if( v[k].rows() != rows || v[k].cols() != cols)
+            throw Message( "Cannot multiply coefficients! Sizes not equal!", _ping_);
+    if( i_begin > i_end || i_end > rows)
+        throw Message( "Lines out of range!", _ping_);
+#endif
+    for( size_t i = i_begin; i<i_end; i++)
+        detail::multiply_planar_line<n,T1,T>( c, v, crows, i);
+}
+
 /*! @brief Multistep timestepper object 
  *
  * @ingroup algorithms
@@ -121,30 +400,146 @@ class Karniadakis
      * @param rows_k # of rows of your k-space coefficients
      * @param cols_k # of columns of your k-space coefficients
      * @param dt the timestep
+     * @param sym the symmetry of your k-space coefficients. With TL_HERMITIAN
+     *  only the lines 0,...,rows_k/2 of the coefficients are stored.
+     * @param history the precision of the stored fields and nonlinearities.
+     *  With TL_FLOAT the older levels are rounded to single precision, which
+     *  reduces the history from 4n double fields to n double and 4n float fields 
+     *  and the memory traffic of step_i accordingly. The combination is still 
+     *  computed in double precision.
      */
-    Karniadakis(const size_t rows_x, const size_t cols_x, const size_t rows_k, const size_t cols_k, const double dt);
+    Karniadakis(const size_t rows_x, const size_t cols_x, const size_t rows_k, const size_t cols_k, const double dt, const enum symmetry sym = TL_GENERAL, const enum precision history = TL_DOUBLE);
 
     /*! @brief Swap in the fourier coefficients.
      *
      * Swaps the coefficients into the object and allocates internal storage for the
-     * inverse matrix.
+     * inverse matrices of all three steppers.
+     * (With TL_HERMITIAN symmetry the unique lines are copied.)
      * @param coeff_origin Set of fourier coefficients, void on output.
      * @param normalisation 
         A numerical discrete fourier transformation followed by its inverse usually
         yields the input times a constant factor. State this factor here to normalize the 
         output of the step_ii function. 
+     * @param keep_origin If false the coefficients are freed after 
+        the first inversion (after which invert_all() cannot be called any more).
+     * @note The inverses of all three steppers are stored, i.e. three tables 
+        of n*n coefficients per (unique) mode instead of one, plus the original 
+        coefficients of the same size until the first inversion (for good if
+        keep_origin is true). With variable timesteps a fourth inverse table is 
+        allocated. The matrix-free mode stores none of them. Objects with 
+        equal coefficients can share the tables (cf. share_coeff).
+     */
+    void init_coeff( Matrix<QuadMat<T_k, n> > & coeff_origin, const double normalisation, const bool keep_origin = false);
+    /*! @brief Init the matrix-free mode
+     *
+     * No coefficients are stored. Instead step_ii recomputes and inverts 
+     * the coefficients of every line on the fly from a generator. 
+     * This saves the memory of the three inverse tables and their 
+     * memory traffic in step_ii at the expense of one inversion per mode and step.
+     * Every thread allocates a scratch line of coefficients at its first step 
+     * and keeps it, i.e. any number of threads may step.
+     * @param normalisation cf. init_coeff
+     */
+    void init_coeff( const double normalisation);
+    /*! @brief Use the inverse coefficients of another object
+     *
+     * Replaces init_coeff for objects with the same coefficients and the 
+     * same timestep (e.g. the members of an ensemble), i.e. the inverse 
+     * tables (and the coefficients kept for adaptive timesteps) are stored 
+     * once for all of them. The tables of src are inverted now if necessary.
+     * An object that changes its tables later (cf. update_coeff and 
+     * set_timestep) gets tables of its own first (copy on write). The 
+     * buffer of invert_coeff( gamma_0) is not shared.
+     * @param src An object with initialized coefficients of the same size, symmetry and timestep
+     * @throw Message If src does not match, is matrix-free or this object is already initialized
+     * @note The steps of objects that share their tables may be computed concurrently.
+     */
+    void share_coeff( Karniadakis& src);
+    /*! @brief Exchange the fourier coefficients
+     *
+     * Replaces the coefficients of init_coeff( coeff, normalisation, keep) e.g. after
+     * a change of the physical parameters. The history, the timesteps and the 
+     * allocated tables are kept. The inverse of the stepper in use
+     * is recomputed at once, the others at the next call of invert_coeff.
+     * In the matrix-free mode nothing is stored, so nothing is done.
+     * @param coeff_origin Set of fourier coefficients of the original size (unchanged)
      */
-    void init_coeff( Matrix<QuadMat<T_k, n> > & coeff_origin, const double normalisation);
+    void update_coeff( const Matrix<QuadMat<T_k, n> > & coeff_origin);
 
     /*! @brief Init the coefficients for step_ii
      *
-     * Inverts your fourier coefficients with the correct gamma_0.
+     * On the first call (and after the timestep was changed) the fourier coefficients are inverted for all 
+     * three steppers at once (cf. invert_all()). Every following call 
+     * just selects the inverse for S.
      * @tparam S The set of Karniadakis-Coefficients you want to use
+     * In the matrix-free mode only the stepper is selected.
      * @attention This function has to be called BEFORE a call of step_ii AND/OR
      *   AFTER you switched steppers.
      */
     template< enum stepper S>
     void invert_coeff( );
+    /*! @brief Invert the coefficients for a stepper known at runtime
+     *
+     * Inverts the coefficients with the given gamma_0 and the current 
+     * timestep into an extra buffer. Meant for the variable timestep 
+     * coefficients, that change from step to step.
+     * @param gamma_0 the gamma_0 of the stepper (cf. StepCoefficients)
+     * @attention Needs the original coefficients, i.e. call init_coeff with 
+     *  keep_origin = true
+     */
+    void invert_coeff( const double gamma_0);
+    /*! @brief The current timestep
+     *
+     * @return the timestep
+     */
+    double timestep() const { return dt;}
+    /*! @brief Change the timestep 
+     *
+     * The new timestep is used in all subsequent calls. The inverse
+     * coefficients are recomputed in the next call to invert_coeff
+     * (in tables of its own if they were shared, cf. share_coeff).
+     * As long as the last timesteps are not equidistant() use the 
+     * variable_coefficients() for the steps.
+     * @param dt_new the new timestep
+     * @attention Needs the original coefficients, i.e. call init_coeff with 
+     *  keep_origin = true (except in the matrix-free mode)
+     */
+    void set_timestep( const double dt_new)
+    {
+        if( dt_new == dt)
+            return;
+        unshare();
+        dt = dt_new, tables->stale = true;
+    }
+    /*! @brief Check whether the last two timesteps equal the current one
+     *
+     * @return true if the fixed Coefficients<TL_ORDER3> are valid for the next step
+     */
+    bool equidistant() const { return h1 == dt && h2 == dt;}
+    /*! @brief The number of steps in the history
+     *
+     * @return 0 after construction, 1 after the first step and 2 after all further steps, 
+     *  i.e. the order of the next step is levels() + 1
+     */
+    unsigned levels() const { return levels_;}
+    /*! @brief The coefficients for the next step with the current and the last two timesteps
+     *
+     * @param order the order of the scheme
+     * @return step_coefficients( order, timestep(), last timestep, timestep before)
+     */
+    StepCoefficients variable_coefficients( const unsigned order = 3) const 
+    { 
+        return step_coefficients( order, dt, h1, h2);
+    }
+    /*! @brief Invert the fourier coefficients for all steppers
+     *
+     * The inverses with the gamma_0 of TL_EULER, TL_ORDER2 and TL_ORDER3 
+     * are computed in parallel with the batched inversion of quadmat.h.
+     * The stepper in use (if any) stays selected.
+     * @attention Needs the original coefficients, i.e. call init_coeff with 
+     *  keep_origin = true if you want to call this function yourself.
+     */
+    void invert_all( );
 
     /*! @brief Compute the first part of the Karniadakis scheme
      *
@@ -153,11 +548,73 @@ class Karniadakis
      * Contains v_{temp} on output.
      * @param n0
      * The nonlinearity at timestep n.
-     * Contains the old v2 on output.
+     * Contains the old v2 on output (unchanged with TL_FLOAT history).
      * @tparam S The set of Karniadakis-Coefficients you want to use
      */
     template< enum stepper S>
     void step_i( std::array< Matrix<double, P_x>, n>& v0, std::array< Matrix<double, P_x>, n> & n0);
+    /*! @brief Compute the explicit combination of step_i for some lines of one species
+     *
+     * This is the pointwise part of step_i restricted to the lines 
+     * i_begin <= i < i_end of species k. It is meant to be called 
+     * right after the nonlinearity of these lines has been computed 
+     * (e.g. from the tile callback of the Arakawa scheme) while 
+     * the operands are still in cache. Different lines may be combined 
+     * concurrently. When all lines of all species are combined call 
+     * step_i_rotate to complete the step.
+     * @param v0 The field of species k at timestep n (unchanged)
+     * @param n0 The nonlinearity of species k at timestep n (unchanged)
+     * @param k the species
+     * @param i_begin first line
+     * @param i_end one past the last line
+     * @tparam S The set of Karniadakis-Coefficients you want to use
+     */
+    template< enum stepper S>
+    void step_i_combine( const Matrix<double, P_x>& v0, const Matrix<double, P_x>& n0, 
+                         const size_t k, const size_t i_begin, const size_t i_end)
+    {
+        step_i_combine( v0, n0, k, i_begin, i_end, step_coefficients<S>());
+    }
+    /*! @brief Compute the explicit combination of step_i for some lines of one species
+     *
+     * Same as above with coefficients known at runtime.
+     * @param v0 The field of species k at timestep n (unchanged)
+     * @param n0 The nonlinearity of species k at timestep n (unchanged)
+     * @param k the species
+     * @param i_begin first line
+     * @param i_end one past the last line
+     * @param c The coefficients (e.g. the variable_coefficients())
+     */
+    void step_i_combine( const Matrix<double, P_x>& v0, const Matrix<double, P_x>& n0, 
+                         const size_t k, const size_t i_begin, const size_t i_end, 
+                         const StepCoefficients& c);
+    /*! @brief Complete step_i after all lines were combined by step_i_combine
+     *
+     * Rotates the fields and nonlinearities exactly like step_i does
+     * and records the timestep.
+     * @param v0 
+     * The field at timestep n, that is stored by the class.
+     * Contains v_{temp} on output.
+     * @param n0
+     * The nonlinearity at timestep n.
+     * Contains the old v2 on output (unchanged with TL_FLOAT history).
+     */
+    void step_i_rotate( std::array< Matrix<double, P_x>, n>& v0, std::array< Matrix<double, P_x>, n> & n0);
+    /*! @brief Complete step_i for one species after all its lines were combined
+     *
+     * Rotates the field and nonlinearity of species k like step_i_rotate does. 
+     * The species may be rotated concurrently. The timestep is not recorded,
+     * call step_i_advance once per step.
+     * @param v0 
+     * The field of species k at timestep n. Contains v_{temp} on output.
+     * @param n0
+     * The nonlinearity of species k at timestep n.
+     * @param k the species
+     */
+    void step_i_rotate( Matrix<double, P_x>& v0, Matrix<double, P_x>& n0, const size_t k);
+    /*! @brief Record the timestep of a step whose species were rotated individually
+     */
+    void step_i_advance() { h2 = h1, h1 = dt, levels_ = std::min( levels_ + 1, 2u);}
     /*! @brief Compute the second part of the Karniadakis scheme
      *
      * The result is normalized with the inverse of the normalisation factor 
@@ -173,30 +630,203 @@ class Karniadakis
     inline void step_ii( std::array< Matrix< Fourier_T, TL_NONE>, n>& v)
     {
 #ifdef TL_DEBUG
-        if( c_origin.isVoid())
+        if( current == -1)
+            throw Message( "Init coefficients first!", _ping_);
+#endif
+        multiply_coeff< n,T_k,Fourier_T>( c_inv(), v, sym);
+    }
+    /*! @brief Compute the second part of the Karniadakis scheme for some lines
+     *
+     * Same as above for the lines i_begin <= i < i_end only. No parallel 
+     * region is opened, i.e. the threads of an enclosing parallel region 
+     * may call this function concurrently for disjoint sets of lines.
+     * @param v 
+     * The fourier transposed result of step_i on input.
+     * Contains the multiplied coefficients in the given lines on output
+     * @param i_begin first line
+     * @param i_end one past the last line
+     * @tparam Fourier_T The value type of the fourier transposed matrices
+     */
+    template< class Fourier_T>
+    inline void step_ii( std::array< Matrix< Fourier_T, TL_NONE>, n>& v, const size_t i_begin, const size_t i_end)
+    {
+#ifdef TL_DEBUG
+        if( current == -1)
             throw Message( "Init coefficients first!", _ping_);
 #endif
-        multiply_coeff< n,T_k,Fourier_T>( c_inv,v,v);
+        multiply_coeff< n,T_k,Fourier_T>( c_inv(), v, i_begin, i_end, sym);
     }
+    /*! @brief Compute the second part of the Karniadakis scheme in the matrix-free mode
+     *
+     * The coefficients of each line are generated, inverted and 
+     * multiplied while they are in cache. 
+     * @param v 
+     * The fourier transposed result of step_i on input.
+     * Contains the multiplied coefficients on output
+     * @param gen
+     * The generator of the coefficients. A call gen( i, line) must 
+     * write the fourier coefficients of line i (i.e. cols_k QuadMats) 
+     * to line. It is called concurrently for different lines.
+     * @tparam Fourier_T The value type of the fourier transposed matrices
+     * @tparam Generator The type of the generator 
+     * @attention Call init_coeff( normalisation) and invert_coeff BEFORE the first call to step_ii with 
+     *   a new stepper.
+     */
+    template< class Fourier_T, class Generator>
+    void step_ii( std::array< Matrix< Fourier_T, TL_NONE>, n>& v, const Generator& gen);
+    /*! @brief Compute the second part of the Karniadakis scheme in the matrix-free mode for some lines
+     *
+     * Same as above for the lines i_begin <= i < i_end only. No parallel 
+     * region is opened, i.e. the threads of an enclosing parallel region 
+     * may call this function concurrently for disjoint sets of lines.
+     * @param v 
+     * The fourier transposed result of step_i on input.
+     * Contains the multiplied coefficients in the given lines on output
+     * @param gen The generator of the coefficients 
+     * @param i_begin first line
+     * @param i_end one past the last line
+     * @tparam Fourier_T The value type of the fourier transposed matrices
+     * @tparam Generator The type of the generator 
+     */
+    template< class Fourier_T, class Generator>
+    void step_ii( std::array< Matrix< Fourier_T, TL_NONE>, n>& v, const Generator& gen, const size_t i_begin, const size_t i_end);
 
+    /*! @brief Write the history of the scheme in binary form
+     *
+     * The older fields and nonlinearities, the last timesteps and the 
+     * number of valid levels() are written.
+     * Together with the current fields they are the complete state of
+     * the scheme, so a restored scheme continues with the stepper of its levels().
+     * @param os The (binary) outstream
+     */
+    void write( std::ostream& os) const;
+    /*! @brief Restore the history written by write
+     *
+     * The timestep is restored as well (cf. set_timestep).
+     * @param is The (binary) instream
+     * @throw Message If the precision of the history or the sizes differ
+     * @attention Call invert_coeff before the next step
+     */
+    void read( std::istream& is);
+    /*! @brief Take the history of an object of a different size
+     *
+     * The timesteps are copied and every field of the history is 
+     * transferred by the given function (e.g. a spectral prolongation or restriction).
+     * @tparam Transfer A functor with 
+     *  void operator()( const Matrix<double, P_x>& from, Matrix<double, P_x>& to)
+     * @param src An object with the same precision of the history
+     * @param transfer The functor (called for fields of the size of src and this)
+     * @throw Message If the precision of the history differs
+     * @attention Call invert_coeff before the next step
+     */
+    template< class Transfer>
+    void resample( const Karniadakis& src, Transfer& transfer);
     /*! @brief Display the original and the inverted coefficients
      *
      * @param os The outstream, the coefficients are streamed to.
      */
     void display( std::ostream& os = std::cout) const
     {
-        os << "The current coefficients are \n"<< c_origin
-            <<"The current inverse is\n" << c_inv<<std::endl;
+        if( !tables->origin.isVoid())
+            os << "The current coefficients are \n"<< tables->origin;
+        if( current != -1)
+            os <<"The current inverse is (planes 00, 01, ...)\n" << c_inv()<<std::endl;
     }
   private:
     const size_t rows, cols;
     std::array< Matrix< double, P_x>, n> v1, v2;
-    std::array< Matrix< double, P_x>, n> n1, n2;
-    Matrix< QuadMat< T_k, n>, TL_NONE> c_inv;
-    Matrix< QuadMat< T_k, n>, TL_NONE> c_origin; //contains the coeff of first call
+    std::array< Matrix< double, P_x>, n> n1, n2; //with TL_FLOAT history only n2 (the result) is allocated
+    std::array< Matrix< float, P_x>, n> f_v1, f_v2; //the single precision history (void with TL_DOUBLE)
+    std::array< Matrix< float, P_x>, n> f_n1, f_n2;
+    const enum precision history;
+    struct Tables //the coefficients of the linear part (shared by the objects with equal coefficients, cf. share_coeff)
+    {
+        Tables( const size_t crows, const size_t ccols): 
+            inverse{{ Matrix< T_k, TL_NONE>( n*n*crows, ccols, (bool)TL_VOID), 
+                      Matrix< T_k, TL_NONE>( n*n*crows, ccols, (bool)TL_VOID), 
+                      Matrix< T_k, TL_NONE>( n*n*crows, ccols, (bool)TL_VOID)}}, 
+            origin( crows, ccols, TL_VOID), stale( true) { }
+        std::array< Matrix< T_k, TL_NONE>, 3> inverse; //the inverses of all steppers (n*n planes)
+        Matrix< QuadMat< T_k, n>, TL_NONE> origin; //contains the coeff of first call (unique lines)
+        bool stale; //the inverses need to be computed
+    };
+    std::shared_ptr< Tables> tables;
+    Matrix< T_k, TL_NONE> c_var; //storage for the inverse of invert_coeff( gamma_0) (void if unused)
+    int current; //the stepper in use (variable for invert_coeff( gamma_0)) or -1
+    double g0_var; //the gamma_0 of invert_coeff( gamma_0)
+    const enum symmetry sym;
+    bool keep_origin;
+    bool matrix_free;
     double prefactor;
-    const double dt;
-
+    double dt;
+    double h1, h2; //the last two timesteps
+    unsigned levels_; //the number of valid levels of the history (at most 2)
+    static const int variable = 3;
+    static double gamma_0( const int s)
+    {
+        const double g[3] = { Coefficients<TL_EULER>::gamma_0, 
+                              Coefficients<TL_ORDER2>::gamma_0, 
+                              Coefficients<TL_ORDER3>::gamma_0};
+        return g[s];
+    }
+    //replace the coefficients of a line by prefactor*inverse( gamma_0 - dt*c)
+    void invert_line( QuadMat< T_k, n>* line, const size_t ccols, const double gamma_0) const
+    {
+        for( size_t j=0; j<ccols; j++)
+            for( unsigned k=0; k<n; k++)
+            {
+                for( unsigned q=0; q<n; q++)
+                    line[j](k,q) = -prefactor*dt*line[j](k,q);
+                line[j](k,k) += prefactor*gamma_0;
+            }
+        invert( line, ccols);
+    }
+    void invert_table( Matrix< T_k, TL_NONE>& table, const double gamma_0);
+    //copy the tables before they are changed if they are shared
+    void unshare()
+    {
+        if( tables.use_count() == 1) 
+            return;
+        tables.reset( new Tables( *tables));
+    }
+    //the inverse in use (n*n planes)
+    const Matrix< T_k, TL_NONE>& c_inv() const
+    {
+        return current == variable ? c_var : tables->inverse[current];
+    }
+    //free the coefficients after the inversion unless they are kept
+    void release_origin()
+    {
+        if( keep_origin) 
+            return;
+        Matrix< QuadMat< T_k, n>, TL_NONE> temp( tables->origin.rows(), tables->origin.cols(), TL_VOID);
+        swap_fields( temp, tables->origin);
+    }
+    //generate, invert and multiply the coefficients of line i (line is a buffer of cols_k QuadMats)
+    template< class Fourier_T, class Generator>
+    void multiply_generated_line( std::array< Matrix< Fourier_T, TL_NONE>, n>& v, const Generator& gen, const size_t i, QuadMat< T_k, n>* line, const double g0) const;
+    //the scratch line of the calling thread (allocated at its first call, 
+    //so it never throws in the parallel regions of the steps)
+    QuadMat< T_k, n>* scratch_line() const
+    {
+        static thread_local std::vector< QuadMat< T_k, n> > line;
+        if( line.size() < tables->origin.cols())
+            line.resize( tables->origin.cols());
+        return &line[0];
+    }
+    //construct n matrices that are void unless allocate is true
+    template< class F>
+    static std::array< Matrix< F, P_x>, n> fields( const size_t rows, const size_t cols, const bool allocate)
+    {
+        std::array< Matrix< F, P_x>, n> a( MatrixArray< F, P_x, n>::construct( rows, cols));
+        if( !allocate)
+            for( unsigned k=0; k<n; k++)
+            {
+                Matrix< F, P_x> temp( rows, cols, (bool)TL_VOID);
+                swap_fields( temp, a[k]);
+            }
+        return a;
+    }
 };
 
 template< size_t n, typename T, enum Padding P>
@@ -205,56 +835,264 @@ Karniadakis<n,T,P>::Karniadakis(
              const size_t cols, 
              const size_t crows, 
              const size_t ccols, 
-             const double dt):
+             const double dt, 
+             const enum symmetry sym, 
+             const enum precision history):
         rows( rows), cols( cols),
-        v1( MatrixArray<double,P,n>::construct( rows, cols)), v2(v1), n1(v1), n2(n1),
-        c_inv( crows, ccols, TL_VOID), c_origin(c_inv),
+        v1( fields<double>( rows, cols, history == TL_DOUBLE)), v2(v1), n1(v1), 
+        n2( MatrixArray<double,P,n>::construct( rows, cols)),
+        f_v1( fields<float>( rows, cols, history == TL_FLOAT)), f_v2( f_v1), f_n1( f_v1), f_n2( f_v1), 
+        history( history),
+        tables( new Tables( sym == TL_HERMITIAN ? crows/2 + 1 : crows, ccols)), 
+        c_var( tables->inverse[0]), current( -1), g0_var( 0), 
+        sym( sym), keep_origin( false), matrix_free( false),
         prefactor(0.),
-        dt( dt)
+        dt( dt), h1( dt), h2( dt), levels_( 0)
 { }
 template< size_t n, typename T_k, enum Padding P>
-void Karniadakis<n,T_k,P>::init_coeff( Matrix<QuadMat<T_k, n> > & coeff_origin, const double normalisation)
+void Karniadakis<n,T_k,P>::init_coeff( Matrix<QuadMat<T_k, n> > & coeff_origin, const double normalisation, const bool keep)
 {
+    const size_t crows = ( sym == TL_HERMITIAN) ? coeff_origin.rows()/2 + 1 : coeff_origin.rows();
 #ifdef TL_DEBUG
     if( normalisation < 1.)
         throw Message( "Yield the prefactor, not its inverse!", _ping_);
     if( coeff_origin.isVoid())
         throw Message("Your coefficients are void!", _ping_);
-    if( coeff_origin.rows() != c_origin.rows() || coeff_origin.cols() != c_origin.cols())
+    if( crows != tables->origin.rows() || coeff_origin.cols() != tables->origin.cols())
         throw Message("Your coefficients have wrong size!\n", _ping_);
+    if( sym == TL_HERMITIAN)
+        for( size_t i=crows; i<coeff_origin.rows(); i++)
+            for( size_t j=0; j<coeff_origin.cols(); j++)
+                for( unsigned k=0; k<n; k++)
+                    for( unsigned q=0; q<n; q++)
+                        if( std::abs( coeff_origin(i,j)(k,q) - detail::conj_if( coeff_origin( coeff_origin.rows() - i, j)(k,q), true)) > 1e-12*std::abs( coeff_origin(i,j)(k,q)))
+                            throw Message("Your coefficients are not hermitian!\n", _ping_);
 #endif
     prefactor = normalisation; 
-    if( c_origin.isVoid())
+    keep_origin = keep;
+    if( !tables->inverse[0].isVoid() || matrix_free)
+        throw Message("You've already initialized coefficients", _ping_);
+    unshare(); //e.g. with a copy
+    Matrix< QuadMat< T_k, n>, TL_NONE>& c_origin = tables->origin;
+    if( sym == TL_HERMITIAN)
     {
-        swap_fields( c_origin, coeff_origin);
-        c_inv.allocate( );
+        Matrix<QuadMat<T_k, n> > full( coeff_origin.rows(), coeff_origin.cols(), TL_VOID);
+        swap_fields( full, coeff_origin);
+        c_origin.allocate();
+        for( size_t i=0; i<crows; i++)
+            for( size_t j=0; j<full.cols(); j++)
+                c_origin(i,j) = full(i,j);
     }
     else
+        swap_fields( c_origin, coeff_origin);
+    for( unsigned s=0; s<3; s++)
+        tables->inverse[s].allocate( );
+}
+
+template< size_t n, typename T_k, enum Padding P>
+void Karniadakis<n,T_k,P>::init_coeff( const double normalisation)
+{
+#ifdef TL_DEBUG
+    if( normalisation < 1.)
+        throw Message( "Yield the prefactor, not its inverse!", _ping_);
+#endif
+    if( !tables->inverse[0].isVoid() || matrix_free)
+        throw Message("You've already initialized coefficients", _ping_);
+    prefactor = normalisation; 
+    matrix_free = true;
+}
+
+template< size_t n, typename T_k, enum Padding P>
+void Karniadakis<n,T_k,P>::share_coeff( Karniadakis& src)
+{
+    if( src.matrix_free || src.tables->inverse[0].isVoid())
+        throw Message( "Init the coefficients of the source first!", _ping_);
+    if( !tables->inverse[0].isVoid() || matrix_free)
         throw Message("You've already initialized coefficients", _ping_);
+    if( src.sym != sym || src.dt != dt || src.tables->origin.rows() != tables->origin.rows() || src.tables->origin.cols() != tables->origin.cols())
+        throw Message( "Cannot share coefficients of a different size or timestep!", _ping_);
+    if( src.tables->stale)
+    {
+        src.invert_all();
+        src.release_origin();
+    }
+    prefactor = src.prefactor;
+    keep_origin = src.keep_origin;
+    tables = src.tables;
+}
+template< size_t n, typename T_k, enum Padding P>
+void Karniadakis<n,T_k,P>::update_coeff( const Matrix<QuadMat<T_k, n> > & coeff_origin)
+{
+    if( matrix_free)
+        return;
+    const size_t crows = ( sym == TL_HERMITIAN) ? coeff_origin.rows()/2 + 1 : coeff_origin.rows();
+    if( tables->inverse[0].isVoid())
+        throw Message( "Init your coefficients first!", _ping_);
+    if( crows != tables->origin.rows() || coeff_origin.cols() != tables->origin.cols())
+        throw Message("Your coefficients have wrong size!\n", _ping_);
+    unshare();
+    Matrix< QuadMat< T_k, n>, TL_NONE>& c_origin = tables->origin;
+    if( c_origin.isVoid()) //was freed after the first inversion
+        c_origin.allocate();
+#pragma omp parallel for
+    for( size_t i=0; i<crows; i++)
+        for( size_t j=0; j<coeff_origin.cols(); j++)
+            c_origin(i,j) = coeff_origin(i,j);
+    tables->stale = true;
+    if( current == variable)
+        invert_table( c_var, g0_var);
+    else if( current != -1)
+    {
+        invert_all();
+        release_origin(); //free memory
+    }
 }
+
 template< size_t n, typename T, enum Padding P>
 template< enum stepper S>
 void Karniadakis< n,T,P>::invert_coeff( )
 {
+    if( matrix_free)
+    {
+        current = S;
+        return;
+    }
 #ifdef TL_DEBUG
-    if( c_origin.isVoid())
+    if( tables->inverse[0].isVoid())
         throw Message( "Init your coefficients first!", _ping_);
 #endif
-    //invert coefficients
-    for(unsigned i=0; i<c_inv.rows(); i++)
-        for( unsigned j=0; j<c_inv.cols(); j++)
-        {
-            for( unsigned k=0; k<n; k++)
+    if( tables->stale)
+    {
+        invert_all();
+        release_origin(); //free memory
+    }
+    current = S;
+}
+
+template< size_t n, typename T, enum Padding P>
+void Karniadakis< n,T,P>::invert_coeff( const double gamma_0)
+{
+    g0_var = gamma_0;
+    if( matrix_free)
+    {
+        current = variable;
+        return;
+    }
+    if( tables->origin.isVoid())
+        throw Message( "Init your coefficients first (and keep them)!", _ping_);
+    if( c_var.isVoid())
+        c_var.allocate();
+    invert_table( c_var, gamma_0);
+    current = variable;
+}
+
+template< size_t n, typename T, enum Padding P>
+void Karniadakis< n,T,P>::invert_all( )
+{
+    if( tables->origin.isVoid())
+        throw Message( "Init your coefficients first (and keep them)!", _ping_);
+    unshare();
+    for( int s=0; s<3; s++)
+        invert_table( tables->inverse[s], gamma_0(s));
+    tables->stale = false;
+}
+
+template< size_t n, typename T, enum Padding P>
+void Karniadakis< n,T,P>::invert_table( Matrix< T, TL_NONE>& table, const double gamma_0)
+{
+    const Matrix< QuadMat< T, n>, TL_NONE>& c_origin = tables->origin;
+    const size_t crows = c_origin.rows(), ccols = c_origin.cols();
+    bool singular = false; //an exception must not leave the parallel region
+#pragma omp parallel reduction( ||: singular)
+    {
+    std::vector< QuadMat<T,n> > line( ccols);
+#pragma omp for 
+    for( size_t i=0; i<crows; i++)
+    {
+        for( size_t j=0; j<ccols; j++)
+            line[j] = c_origin(i,j);
+        try{ invert_line( &line[0], ccols, gamma_0);}
+        catch( Message&){ singular = true; continue;}
+        //scatter into the planes
+        for( unsigned k=0; k<n; k++)
+            for( unsigned q=0; q<n; q++)
             {
-                for( unsigned q=0; q<n; q++)
-                    c_inv(i,j)(k,q) = -prefactor*dt*c_origin(i,j)(k,q);
-                c_inv(i,j)(k,k) += prefactor*Coefficients<S>::gamma_0;
-                
+                T* plane = &table( (k*n+q)*crows + i, 0);
+                for( size_t j=0; j<ccols; j++)
+                    plane[j] = line[j](k,q);
             }
-            invert( c_inv(i,j), c_inv(i,j));
-        }
-    //std::cout << "C_inv "<<c_inv<<std::endl;
+    }
+    }
+    if( singular)
+        throw Message( "Determinant is Zero\n", _ping_);
+}
+
+template< size_t n, typename T, enum Padding P>
+template< class Fourier_T, class Generator>
+void Karniadakis< n,T,P>::step_ii( std::array< Matrix< Fourier_T, TL_NONE>, n>& v, const Generator& gen)
+{
+    const size_t crows = v[0].rows();
+#ifdef TL_DEBUG
+    const size_t ccols = v[0].cols();
+    if( !matrix_free || current == -1)
+        throw Message( "Init the matrix-free mode and the stepper first!", _ping_);
+    for( unsigned k=0; k<n; k++)
+        if( v[k].isVoid())
+            throw Message( "Cannot work with void Matrices!\n", _ping_);
+    if( ( sym == TL_HERMITIAN ? crows/2 + 1 : crows) != tables->origin.rows() || ccols != tables->origin.cols())
+        throw Message( "Matrix has wrong size!\n", _ping_);
+#endif
+    const double g0 = ( current == variable) ? g0_var : gamma_0( current);
+#pragma omp parallel
+    {
+    QuadMat<T,n>* line = scratch_line();
+#pragma omp for 
+    for( size_t i=0; i<crows; i++)
+        multiply_generated_line( v, gen, i, line, g0);
+    }
+}
+
+template< size_t n, typename T, enum Padding P>
+template< class Fourier_T, class Generator>
+void Karniadakis< n,T,P>::step_ii( std::array< Matrix< Fourier_T, TL_NONE>, n>& v, const Generator& gen, const size_t i_begin, const size_t i_end)
+{
+#ifdef TL_DEBUG
+    const size_t crows = v[0].rows(), ccols = v[0].cols();
+    if( !matrix_free || current == -1)
+        throw Message( "Init the matrix-free mode and the stepper first!", _ping_);
+    for( unsigned k=0; k<n; k++)
+        if( v[k].isVoid())
+            throw Message( "Cannot work with void Matrices!\n", _ping_);
+    if( ( sym == TL_HERMITIAN ? crows/2 + 1 : crows) != tables->origin.rows() || ccols != tables->origin.cols())
+        throw Message( "Matrix has wrong size!\n", _ping_);
+    if( i_begin > i_end || i_end > crows)
+        throw Message( "Lines out of range!", _ping_);
+#endif
+    const double g0 = ( current == variable) ? g0_var : gamma_0( current);
+    QuadMat<T,n>* line = scratch_line();
+    for( size_t i=i_begin; i<i_end; i++)
+        multiply_generated_line( v, gen, i, line, g0);
+}
 
+template< size_t n, typename T, enum Padding P>
+template< class Fourier_T, class Generator>
+void Karniadakis< n,T,P>::multiply_generated_line( std::array< Matrix< Fourier_T, TL_NONE>, n>& v, const Generator& gen, const size_t i, QuadMat< T, n>* line, const double g0) const
+{
+    const size_t ccols = v[0].cols();
+    gen( i, line);
+    invert_line( line, ccols, g0);
+    for( size_t j=0; j<ccols; j++)
+    {
+        Fourier_T temp[n];
+        for( unsigned k=0; k<n; k++)
+        {
+            temp[k] = line[j](k,0)*v[0](i,j);
+            for( unsigned q=1; q<n; q++)
+                temp[k] += line[j](k,q)*v[q](i,j);
+        }
+        for( unsigned k=0; k<n; k++)
+            v[k](i,j) = temp[k];
+    }
 }
 
 template< size_t n, typename T, enum Padding P>
@@ -273,24 +1111,153 @@ void Karniadakis<n,T,P>::step_i( std::array< Matrix<double, P>, n>& v0, std::arr
 #endif
 #pragma omp parallel for 
         for( size_t i = 0; i < rows; i++)
-        {
+            step_i_combine<S>( v0[k], n0[k], k, i, i+1);
+    }
+    step_i_rotate( v0, n0);
+}
+
+template< size_t n, typename T, enum Padding P>
+void Karniadakis<n,T,P>::step_i_combine( const Matrix<double, P>& v0, const Matrix<double, P>& n0, 
+                                         const size_t k, const size_t i_begin, const size_t i_end, 
+                                         const StepCoefficients& c)
+{
+    const double a0 = c.alpha[0], a1 = c.alpha[1], a2 = c.alpha[2];
+    const double b0 = c.beta[0],  b1 = c.beta[1],  b2 = c.beta[2];
+    if( history == TL_FLOAT)
+    {
+        //the oldest level is overwritten by the current one after it is read
+        for( size_t i = i_begin; i < i_end; i++)
             for( size_t j = 0; j < cols; j++)
             {
-                n2[k](i,j) =  Coefficients<S>::alpha[0]*v0[k](i,j) 
-                         + Coefficients<S>::alpha[1]*v1[k](i,j) 
-                         + Coefficients<S>::alpha[2]*v2[k](i,j)
-                         + dt*( Coefficients<S>::beta[0]*n0[k](i,j) 
-                              + Coefficients<S>::beta[1]*n1[k](i,j) 
-                              + Coefficients<S>::beta[2]*n2[k](i,j));
+                const double v = v0(i,j), nl = n0(i,j);
+                n2[k](i,j) =  a0*v 
+                         + a1*f_v1[k](i,j) 
+                         + a2*f_v2[k](i,j)
+                         + dt*( b0*nl 
+                              + b1*f_n1[k](i,j) 
+                              + b2*f_n2[k](i,j));
+                f_v2[k](i,j) = (float)v;
+                f_n2[k](i,j) = (float)nl;
             }
+        return;
+    }
+    for( size_t i = i_begin; i < i_end; i++)
+        for( size_t j = 0; j < cols; j++)
+        {
+            n2[k](i,j) =  a0*v0(i,j) 
+                     + a1*v1[k](i,j) 
+                     + a2*v2[k](i,j)
+                     + dt*( b0*n0(i,j) 
+                          + b1*n1[k](i,j) 
+                          + b2*n2[k](i,j));
         }
-        swap_fields( n2[k], v2[k]); //we want to keep v2 not n2
+}
+
+template< size_t n, typename T, enum Padding P>
+void Karniadakis<n,T,P>::step_i_rotate( std::array< Matrix<double, P>, n>& v0, std::array< Matrix<double, P>, n> & n0)
+{
+    for( unsigned k=0; k<n; k++)
+        step_i_rotate( v0[k], n0[k], k);
+    step_i_advance();
+}
+
+template< size_t n, typename T, enum Padding P>
+void Karniadakis<n,T,P>::step_i_rotate( Matrix<double, P>& v0, Matrix<double, P>& n0, const size_t k)
+{
+    if( history == TL_FLOAT)
+    {
+        swap_fields( f_v1[k], f_v2[k]);
+        swap_fields( f_n1[k], f_n2[k]);
+        swap_fields( v0, n2[k]);
+        return;
+    }
+    swap_fields( n2[k], v2[k]); //we want to keep v2 not n2
 
-        permute_fields( n0[k], n1[k], n2[k]);
-        permute_fields( v0[k], v1[k], v2[k]);
+    permute_fields( n0, n1[k], n2[k]);
+    permute_fields( v0, v1[k], v2[k]);
+}
+
+template< size_t n, typename T, enum Padding P>
+void Karniadakis<n,T,P>::write( std::ostream& os) const
+{
+    write_binary( os, (int)history);
+    write_binary( os, dt);
+    write_binary( os, h1);
+    write_binary( os, h2);
+    write_binary( os, levels_);
+    for( unsigned k=0; k<n; k++)
+    {
+        if( history == TL_FLOAT)
+        {
+            write_binary( os, f_v1[k]), write_binary( os, f_v2[k]);
+            write_binary( os, f_n1[k]), write_binary( os, f_n2[k]);
+            continue;
+        }
+        write_binary( os, v1[k]), write_binary( os, v2[k]);
+        write_binary( os, n1[k]), write_binary( os, n2[k]);
     }
 }
 
+template< size_t n, typename T, enum Padding P>
+void Karniadakis<n,T,P>::read( std::istream& is)
+{
+    int h;
+    double dt_new;
+    read_binary( is, h);
+    if( h != (int)history)
+        throw Message( "Stored history has a different precision!", _ping_);
+    read_binary( is, dt_new);
+    read_binary( is, h1);
+    read_binary( is, h2);
+    read_binary( is, levels_);
+    set_timestep( dt_new);
+    for( unsigned k=0; k<n; k++)
+    {
+        if( history == TL_FLOAT)
+        {
+            read_binary( is, f_v1[k]), read_binary( is, f_v2[k]);
+            read_binary( is, f_n1[k]), read_binary( is, f_n2[k]);
+            continue;
+        }
+        read_binary( is, v1[k]), read_binary( is, v2[k]);
+        read_binary( is, n1[k]), read_binary( is, n2[k]);
+    }
+}
+
+template< size_t n, typename T, enum Padding P>
+template< class Transfer>
+void Karniadakis<n,T,P>::resample( const Karniadakis& src, Transfer& transfer)
+{
+    if( src.history != history)
+        throw Message( "History has a different precision!", _ping_);
+    h1 = src.h1, h2 = src.h2, levels_ = src.levels_;
+    set_timestep( src.dt);
+    if( history == TL_DOUBLE)
+    {
+        for( unsigned k=0; k<n; k++)
+        {
+            transfer( src.v1[k], v1[k]), transfer( src.v2[k], v2[k]);
+            transfer( src.n1[k], n1[k]), transfer( src.n2[k], n2[k]);
+        }
+        return;
+    }
+    //transfer the single precision history in double precision
+    Matrix< double, P> from( src.rows, src.cols), to( rows, cols);
+    const std::array< Matrix< float, P>, n>* f_src[4] = { &src.f_v1, &src.f_v2, &src.f_n1, &src.f_n2};
+    std::array< Matrix< float, P>, n>* f_dst[4] = { &f_v1, &f_v2, &f_n1, &f_n2};
+    for( unsigned l=0; l<4; l++)
+        for( unsigned k=0; k<n; k++)
+        {
+            for( size_t i=0; i<src.rows; i++)
+                for( size_t j=0; j<src.cols; j++)
+                    from(i,j) = (*f_src[l])[k](i,j);
+            transfer( from, to);
+            for( size_t i=0; i<rows; i++)
+                for( size_t j=0; j<cols; j++)
+                    (*f_dst[l])[k](i,j) = (float)to(i,j);
+        }
+}
+
 
 } //namespace spectral
 #endif //_TL_KARNIADAKIS_
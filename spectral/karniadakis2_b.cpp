@@ -98,5 +98,78 @@ int main()
     }
     else
         cout << "TEST PASSED!\n";
+
+    cout << "Compare coefficients of QuadMats with planar coefficients\n";
+    const size_t crows = nz, ccols = nx/2+1;
+    const unsigned loop = 20;
+    Matrix< QuadMat< Complex, 2>> c_aos( crows, ccols);
+    Matrix< Complex> c_planar( 4*crows, ccols);
+    auto v_aos = MatrixArray<Complex, TL_NONE,2>::construct( crows, ccols);
+    auto v_planar = v_aos;
+    for( size_t i=0; i<crows; i++)
+        for( size_t j=0; j<ccols; j++)
+        {
+            for( unsigned k=0; k<2; k++)
+            {
+                v_aos[k](i,j) = v_planar[k](i,j) = Complex( 1./(1.+i+k), 1./(1.+j));
+                for( unsigned q=0; q<2; q++)
+                    c_aos(i,j)(k,q) = c_planar( (2*k+q)*crows+i, j) = Complex( 0.5*(k==q), 1e-3*(i+j+k-q));
+            }
+        }
+    t.tic();
+    for( unsigned i=0; i<loop; i++)
+        multiply_coeff<2,Complex,Complex>( c_aos, v_aos, v_aos);
+    t.toc();
+    cout << "QuadMat coefficients took "<<t.diff()/(double)loop<<"s\n";
+    t.tic();
+    for( unsigned i=0; i<loop; i++)
+        multiply_coeff<2,Complex,Complex>( c_planar, v_planar);
+    t.toc();
+    cout << "Planar coefficients took   "<<t.diff()/(double)loop<<"s\n";
+    double diff = 0;
+    for( size_t i=0; i<crows; i++)
+        for( size_t j=0; j<ccols; j++)
+            for( unsigned k=0; k<2; k++)
+                diff = max( diff, abs( v_aos[k](i,j) - v_planar[k](i,j)));
+    cout << "Difference "<<diff<<"\n";
+
+    cout << "Compare stored with matrix-free (on the fly) coefficients\n";
+    for( size_t N = 64; N <= 1024; N*=4)
+    {
+        const Complex dxmin { 0, 2.*M_PI/lx}, dzmin{ 0, M_PI/lz};
+        const size_t cols = N/2+1;
+        auto gen = [&]( size_t i, QuadMat<Complex,2>* line){ 
+            for( size_t j=0; j<cols; j++)
+                rayleigh_equations( line[j], (double)j*dxmin, (double)(i+1)*dzmin);
+        };
+        Matrix< QuadMat< Complex, 2>> c( N, cols);
+        for( size_t i=0; i<N; i++)
+            gen( i, &c(i,0));
+        Karniadakis<2,Complex,TL_DFT> k_stored( N, N, N, cols, dt), k_free( k_stored);
+        k_stored.init_coeff( c, 1.), k_free.init_coeff( 1.);
+        k_stored.invert_coeff<TL_ORDER3>(), k_free.invert_coeff<TL_ORDER3>();
+        auto v_stored = MatrixArray<Complex, TL_NONE,2>::construct( N, cols);
+        for( size_t i=0; i<N; i++)
+            for( size_t j=0; j<cols; j++)
+                v_stored[0](i,j) = v_stored[1](i,j) = Complex( 1., 1./(1.+i+j));
+        auto v_free = v_stored;
+        t.tic();
+        for( unsigned i=0; i<loop; i++)
+            k_stored.step_ii( v_stored);
+        t.toc();
+        cout << N<<"x"<<cols<<" modes:\n";
+        cout << "    stored coefficients took      "<<t.diff()/(double)loop<<"s\n";
+        t.tic();
+        for( unsigned i=0; i<loop; i++)
+            k_free.step_ii( v_free, gen);
+        t.toc();
+        cout << "    matrix-free coefficients took "<<t.diff()/(double)loop<<"s\n";
+        diff = 0;
+        for( size_t i=0; i<N; i++)
+            for( size_t j=0; j<cols; j++)
+                for( unsigned k=0; k<2; k++)
+                    diff = max( diff, abs( v_stored[k](i,j) - v_free[k](i,j))/abs( v_stored[k](i,j)));
+        cout << "    Relative difference "<<diff<<"\n";
+    }
     return 0;
 }
@@ -1,5 +1,8 @@
 #include <iostream>
 #include <cmath>
+#include <complex>
+#include <algorithm>
+#include <omp.h>
 #include "karniadakis.h"
 #include "matrix.h"
 #include "ghostmatrix.h"
@@ -54,6 +57,201 @@ int main()
          << "Relative error:          "<< (v[0](0,0)-exp(2))/exp(2) <<endl;
     cout << "(Test passed when relative error is small!)\n";
 
+    cout << "Test whether linewise combination and rotation equals step_i...\n";
+    Karniadakis<2, double, TL_NONE> k1( rows, cols, rows, cols, dt), k2( k1);
+    std::array< Matrix<double>, 2> v1{{m,m}}, n1{{n,n}}, v2( v1), n2( n1);
+    for( unsigned s = 0; s < 4; s++)
+    {
+        for( unsigned q=0; q<2; q++)
+            for( size_t i=0; i<rows; i++)
+                for( size_t j=0; j<cols; j++)
+                    v1[q](i,j) = v2[q](i,j) = (double)(s+q+i*j), 
+                    n1[q](i,j) = n2[q](i,j) = (double)(s*q+i+j);
+        k1.step_i<TL_ORDER3>( v1, n1);
+        for( unsigned q=0; q<2; q++)
+            for( size_t i=0; i<rows; i++)
+                k2.step_i_combine<TL_ORDER3>( v2[q], n2[q], q, i, i+1);
+        if( s%2)
+            k2.step_i_rotate( v2, n2);
+        else //rotate the species individually
+        {
+            for( unsigned q=0; q<2; q++)
+                k2.step_i_rotate( v2[q], n2[q], q);
+            k2.step_i_advance();
+        }
+    }
+    cout << ( v1 == v2 && n1 == n2 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+
+    cout << "Test whether hermitian coefficients equal the full coefficients...\n";
+    {
+        typedef std::complex<double> complex;
+        const size_t crows = 5, ccols = 3;
+        Matrix< QuadMat<complex,2> > c( crows, ccols), ch( crows, ccols);
+        Matrix< complex> x( crows, ccols);
+        for( size_t i=0; i<crows; i++)
+            for( size_t j=0; j<ccols; j++)
+            {
+                const int ik = (i>crows/2) ? (int)i-(int)crows : i;
+                c(i,j)(0,0) = complex( 2. + j, 0.1*ik), c(i,j)(0,1) = complex( 0.3, -0.2*ik);
+                c(i,j)(1,0) = complex( -0.5*j, 0.1*ik*ik*ik), c(i,j)(1,1) = complex( 3. + i*i, 0.);
+                if( i>crows/2) c(i,j)(1,1) = conj( c( crows-i,j)(1,1));
+                x(i,j) = complex( i+j, (double)i - (double)j);
+            }
+        ch = c;
+        Karniadakis<2, complex, TL_NONE> kg( crows, ccols, crows, ccols, dt), kh( crows, ccols, crows, ccols, dt, TL_HERMITIAN);
+        kg.init_coeff( c, 1.), kh.init_coeff( ch, 1.);
+        kg.invert_coeff<TL_ORDER3>(), kh.invert_coeff<TL_ORDER3>();
+        std::array< Matrix<complex>, 2> xg{{x,x}}, xh{{x,x}};
+        kg.step_ii( xg), kh.step_ii( xh);
+        double diff = 0;
+        for( unsigned q=0; q<2; q++)
+            for( size_t i=0; i<crows; i++)
+                for( size_t j=0; j<ccols; j++)
+                    diff = std::max( diff, std::abs( xg[q](i,j) - xh[q](i,j)));
+        cout << ( diff < 1e-14 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+
+    cout << "Test whether variable coefficients with equal timesteps equal the fixed coefficients...\n";
+    {
+        const StepCoefficients c[3] = { step_coefficients<TL_EULER>(), step_coefficients<TL_ORDER2>(), step_coefficients<TL_ORDER3>()};
+        double diff = 0;
+        for( unsigned s=0; s<3; s++)
+        {
+            StepCoefficients v = step_coefficients( s+1, 0.3, 0.3, 0.3);
+            diff = max( diff, fabs( v.gamma_0 - c[s].gamma_0));
+            for( unsigned q=0; q<3; q++)
+                diff = max( diff, max( fabs( v.alpha[q] - c[s].alpha[q]), fabs( v.beta[q] - c[s].beta[q])));
+        }
+        cout << ( diff < 1e-14 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Integrate with changing timesteps...\n";
+    {
+        Matrix< QuadMat<double,2> > c( rows, cols, One<2>());
+        Karniadakis<2, double, TL_NONE> kv( rows, cols, rows, cols, dt);
+        kv.init_coeff( c, 1., true);
+        std::array< Matrix<double>, 2> v{{m,m}}, non{{n,n}};
+        double time = 0;
+        unsigned step = 0;
+        while( time < 1. - 1e-12)
+        {
+            //double the timestep after a quarter and halve it again after three quarters
+            if( step > 2 && fabs( time - 0.25) < 1e-12) kv.set_timestep( 2.*dt);
+            if( step > 2 && fabs( time - 0.75) < 1e-12) kv.set_timestep( dt);
+            const unsigned order = step < 2 ? step + 1 : 3;
+            StepCoefficients sc = kv.variable_coefficients( order);
+            if( order == 3 && kv.equidistant())
+            {
+                kv.invert_coeff<TL_ORDER3>();
+                kv.step_i<TL_ORDER3>( v, non);
+            }
+            else
+            {
+                kv.invert_coeff( sc.gamma_0);
+                for( unsigned q=0; q<2; q++)
+                    for( size_t i=0; i<rows; i++)
+                        kv.step_i_combine( v[q], non[q], q, i, i+1, sc);
+                kv.step_i_rotate( v, non);
+            }
+            kv.step_ii( v);
+            time += kv.timestep(), step++;
+            non = v;
+        }
+        cout << "Relative error with changing timesteps: "<< (v[0](0,0)-exp(2))/exp(2) <<"\n";
+        cout << ( fabs( v[0](0,0) - exp(2))/exp(2) < 1e-4 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Integrate with single precision history...\n";
+    {
+        const enum precision p[2] = { TL_DOUBLE, TL_FLOAT};
+        double error[2];
+        for( unsigned l=0; l<2; l++)
+        {
+            Matrix< QuadMat<double,2> > c( rows, cols, One<2>());
+            Karniadakis<2, double, TL_NONE> kp( rows, cols, rows, cols, dt, TL_GENERAL, p[l]);
+            kp.init_coeff( c, 1.);
+            std::array< Matrix<double>, 2> v{{m,m}}, non{{n,n}};
+            kp.invert_coeff<TL_EULER>();
+            kp.step_i<TL_EULER>( v, non);
+            kp.step_ii( v);
+            non = v;
+            kp.invert_coeff<TL_ORDER2>();
+            kp.step_i<TL_ORDER2>( v, non);
+            kp.step_ii( v);
+            non = v;
+            kp.invert_coeff<TL_ORDER3>();
+            for( unsigned i = 2; i < steps; i++)
+            {
+                kp.step_i<TL_ORDER3>( v, non);
+                kp.step_ii( v);
+                non = v;
+            }
+            error[l] = (v[0](0,0)-exp(2))/exp(2);
+        }
+        cout << "Relative error with double history: "<< error[0] <<"\n"
+             << "Relative error with float history:  "<< error[1] <<"\n"
+             << "Difference:                         "<< error[1] - error[0] <<"\n";
+        cout << ( fabs( error[1] - error[0]) < 1e-6 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether objects with shared coefficients step like separate objects...\n";
+    {
+        Matrix< QuadMat<double,2> > c( rows, cols);
+        for( size_t i=0; i<rows; i++)
+            for( size_t j=0; j<cols; j++)
+                c(i,j)(0,0) = -1. - i, c(i,j)(0,1) = 0.5*j, c(i,j)(1,0) = 0.2, c(i,j)(1,1) = -2. + i*j;
+        Matrix< QuadMat<double,2> > c2( c);
+        Karniadakis<2, double, TL_NONE> ka( rows, cols, rows, cols, dt), kb( ka), ks( ka);
+        ka.init_coeff( c, 1., true), kb.init_coeff( c2, 1., true);
+        ks.share_coeff( ka);
+        std::array< Matrix<double>, 2> va{{m,m}}, na{{n,n}}, vb( va), nb( na), vs( va), ns( na);
+        auto step = [&]( Karniadakis<2, double, TL_NONE>& k, std::array< Matrix<double>, 2>& v, std::array< Matrix<double>, 2>& non, const unsigned s)
+        {
+            if( s == 0) k.invert_coeff<TL_EULER>(), k.step_i<TL_EULER>( v, non);
+            if( s == 1) k.invert_coeff<TL_ORDER2>(), k.step_i<TL_ORDER2>( v, non);
+            if( s >= 2) k.invert_coeff<TL_ORDER3>(), k.step_i<TL_ORDER3>( v, non);
+            k.step_ii( v);
+            non = v;
+        };
+        for( unsigned s=0; s<6; s++)
+            step( ka, va, na, s), step( ks, vs, ns, s), step( kb, vb, nb, s);
+        const bool shared = ( va == vb && vs == vb);
+        ks.set_timestep( 2.*dt); //copies the tables
+        for( unsigned s=6; s<9; s++)
+            step( ka, va, na, s), step( ks, vs, ns, s), step( kb, vb, nb, s);
+        cout << ( shared && va == vb && !( vs == vb) ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether the matrix-free mode steps with more threads than at its init...\n";
+    {
+        Matrix< QuadMat<double,2> > c( rows, cols);
+        for( size_t i=0; i<rows; i++)
+            for( size_t j=0; j<cols; j++)
+                c(i,j)(0,0) = -1. - i, c(i,j)(0,1) = 0.5*j, c(i,j)(1,0) = 0.2, c(i,j)(1,1) = -2. + i*j;
+        Matrix< QuadMat<double,2> > c2( c); //init_coeff takes the matrix
+        auto gen = [&]( size_t i, QuadMat<double,2>* line){ for( size_t j=0; j<cols; j++) line[j] = c(i,j);};
+        Karniadakis<2, double, TL_NONE> kt( rows, cols, rows, cols, dt), kf( kt);
+        kt.init_coeff( c2, 1.);
+        const int threads = omp_get_max_threads();
+        omp_set_num_threads( 1);
+        kf.init_coeff( 1.);
+        omp_set_num_threads( 4);
+        std::array< Matrix<double>, 2> vt{{m,m}}, nt{{n,n}}, vf( vt), nf( nt);
+        kt.invert_coeff<TL_EULER>(), kt.step_i<TL_EULER>( vt, nt), kt.step_ii( vt);
+        kf.invert_coeff<TL_EULER>(), kf.step_i<TL_EULER>( vf, nf), kf.step_ii( vf, gen);
+        omp_set_num_threads( threads);
+        double diff = 0;
+        for( size_t i=0; i<rows; i++)
+            for( size_t j=0; j<cols; j++)
+                for( unsigned k=0; k<2; k++)
+                    diff = std::max( diff, fabs( vt[k](i,j) - vf[k](i,j)));
+        cout << ( diff < 1e-14 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether a singular coefficient throws...\n";
+    {
+        Matrix< QuadMat<double,2> > c( rows, cols, One<2>());
+        c( 1, 1)(0,0) = c( 1, 1)(1,1) = 2.; //gamma_0 - dt*c is zero for the Euler stepper
+        Karniadakis<2, double, TL_NONE> ks( rows, cols, rows, cols, 0.5);
+        ks.init_coeff( c, 1.);
+        try{ ks.invert_coeff<TL_EULER>(); cout << "TEST FAILED!\n";}
+        catch( Message& m){ m.display(); cout << "TEST PASSED!\n";}
+    }
 
     return 0;
 }
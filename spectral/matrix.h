@@ -4,6 +4,7 @@
 #include <iostream>
 #include <array>
 #include <vector>
+#include <utility>
 #include "fftw3.h"
 #include "exceptions.h"
 #include "padding.h"
@@ -37,6 +38,105 @@ template <class T, enum Padding P>
 std::istream& operator>> ( std::istream& is, Matrix<T, P>& mat); 
 
 
+/*! @brief Memory for the matrices allocated by one thread 
+ *
+ * @ingroup containers
+ * While a pool is in use by a thread (cf. Scope) the matrices allocated by 
+ * this thread take consecutive pieces of the current slot of the pool 
+ * instead of calling fftw_malloc. The pieces belong to the pool, 
+ * i.e. the pool must outlive the matrices. Objects constructed in the 
+ * same way in slots of equal size have their matrices at equal offsets 
+ * (e.g. the members of an ensemble of solvers, whose fields are then 
+ * transformed by one fftw plan with many transforms).
+ * A pool without memory only counts the bytes, which yields the size 
+ * of the slot an object needs. If a slot is full, the matrices fall 
+ * back to fftw_malloc.
+ */
+class MatrixPool
+{
+  public:
+    static const size_t alignment = 64; //!< every piece starts at a multiple of the alignment
+    /*! @brief Allocate the memory of the pool
+     *
+     * @param size The number of bytes (0 for a pool that only counts)
+     */
+    MatrixPool( const size_t size = 0): pool( NULL), size_( size), begin( 0), end( 0), next( 0)
+    {
+        if( size == 0) return;
+        pool = (char*)fftw_malloc( size);
+        if( pool == NULL)
+            throw Message( "Allocation of the pool failed!", _ping_);
+    }
+    /*! @brief Free the memory of the pool
+     */
+    ~MatrixPool() { if( pool != NULL) fftw_free( pool);}
+    /*! @brief Take the following pieces from the given bytes of the pool
+     *
+     * @param offset The first byte of the slot (a multiple of the alignment)
+     * @param size The number of bytes of the slot
+     */
+    void slot( const size_t offset, const size_t size)
+    {
+        if( offset % alignment || offset + size > size_)
+            throw Message( "Slot outside of the pool!", _ping_);
+        begin = next = offset, end = offset + size;
+    }
+    /*! @brief The number of bytes requested in the current slot so far
+     *
+     * Includes the pieces that did not fit into the slot.
+     * @return The number of bytes (a multiple of the alignment)
+     */
+    size_t used() const { return next - begin;}
+    /*! @brief The address of a byte of the pool
+     *
+     * @param offset The byte
+     * @return The address
+     */
+    char* data( const size_t offset = 0) const { return pool + offset;}
+    /*! @brief Take the next piece of the current slot
+     *
+     * @param bytes The size of the piece
+     * @return The address of the piece or NULL if the slot is full
+     */
+    void* allocate( const size_t bytes)
+    {
+        const size_t offset = next;
+        next += ( bytes + alignment - 1)/alignment*alignment;
+        if( pool == NULL || next > end) 
+            return NULL;
+        return pool + offset;
+    }
+    /*! @brief Use a pool for the matrices allocated by this thread in a scope
+     */
+    class Scope
+    {
+      public:
+        /*! @brief Use the given pool until the end of the scope
+         *
+         * @param pool The pool (the pool in use before is restored at the end of the scope)
+         */
+        Scope( MatrixPool& pool): previous( current()) { current() = &pool;}
+        ~Scope() { current() = previous;}
+      private:
+        MatrixPool* previous;
+    };
+    /*! @brief The pool in use by the calling thread
+     *
+     * @return A reference to the pointer to the pool (NULL if none)
+     */
+    static MatrixPool*& current()
+    {
+        static thread_local MatrixPool* pool = NULL;
+        return pool;
+    }
+    MatrixPool( const MatrixPool&) = delete;
+    MatrixPool& operator=( const MatrixPool&) = delete;
+  private:
+    char* pool;
+    size_t size_; 
+    size_t begin, end, next; //the current slot and the next piece
+};
+
 /*! @brief Matrix class of constant size that provides fftw compatible dynamically allocated 2D fields 
  *
  * @ingroup containers
@@ -288,6 +388,7 @@ class Matrix
     size_t n; //!< # of columns
     size_t m; //!< # of rows
     T *ptr; //!< pointer to allocated memory
+    bool own; //!< ptr was allocated by fftw_malloc (else it belongs to a MatrixPool)
 };
 
 /////////////////////////////////////DEFINITIONS///////////////////////////////////////////////////////////////////////////////
@@ -302,10 +403,11 @@ void swap_fields( Matrix<T1, P1>& lhs, Matrix<T2, P2>& rhs)
     T1 * ptr = lhs.ptr;
     lhs.ptr = reinterpret_cast<T1*>(rhs.ptr);
     rhs.ptr = reinterpret_cast<T2*>(ptr); 
+    std::swap( lhs.own, rhs.own);
 }
 
 template <class T, enum Padding P>
-Matrix<T, P>::Matrix( const size_t n, const size_t m, const bool allocate): n(n), m(m), ptr(NULL)
+Matrix<T, P>::Matrix( const size_t n, const size_t m, const bool allocate): n(n), m(m), ptr(NULL), own( true)
 {
 #ifdef TL_DEBUG
     if( n==0|| m==0)
@@ -316,7 +418,7 @@ Matrix<T, P>::Matrix( const size_t n, const size_t m, const bool allocate): n(n)
 }
 
 template< class T, enum Padding P>
-Matrix<T,P>::Matrix( const size_t n, const size_t m, const T& value):n(n),m(m),ptr(NULL)
+Matrix<T,P>::Matrix( const size_t n, const size_t m, const T& value):n(n),m(m),ptr(NULL), own( true)
 {
 #ifdef TL_DEBUG
     if( n==0|| m==0)
@@ -332,12 +434,12 @@ Matrix<T,P>::Matrix( const size_t n, const size_t m, const T& value):n(n),m(m),p
 template <class T, enum Padding P>
 Matrix<T, P>::~Matrix()
 {
-    if( ptr!= NULL/*NULL*/)
+    if( ptr!= NULL/*NULL*/ && own)
         fftw_free( ptr);
 }
 
 template <class T, enum Padding P>
-Matrix<T, P>::Matrix( const Matrix& src):n(src.n), m(src.m), ptr(NULL){
+Matrix<T, P>::Matrix( const Matrix& src):n(src.n), m(src.m), ptr(NULL), own( true){
     if( src.ptr != NULL)
     {
         allocate_();
@@ -346,7 +448,7 @@ Matrix<T, P>::Matrix( const Matrix& src):n(src.n), m(src.m), ptr(NULL){
     }
 }
 template <class T, enum Padding P>
-Matrix<T, P>::Matrix(  Matrix&& src):n(src.n), m(src.m), ptr(src.ptr){
+Matrix<T, P>::Matrix(  Matrix&& src):n(src.n), m(src.m), ptr(src.ptr), own( src.own){
     src.ptr = NULL;
 }
 
@@ -379,6 +481,7 @@ Matrix<T, P>& Matrix<T, P>::operator=( Matrix&& src)
             throw Message( "Assigning to or from a void matrix!", _ping_);
 #endif
         ptr = src.ptr; 
+        own = src.own;
         src.ptr = NULL;
     }
     return *this;
@@ -389,7 +492,12 @@ void Matrix<T, P>::allocate_()
 {
     if( ptr == NULL) //allocate only if matrix is void 
     {
-        ptr = (T*)fftw_malloc( TotalNumberOf<P>::elements(n, m)*sizeof(T));
+        const size_t bytes = TotalNumberOf<P>::elements(n, m)*sizeof(T);
+        MatrixPool* pool = MatrixPool::current();
+        ptr = ( pool != NULL) ? (T*)pool->allocate( bytes) : NULL;
+        own = ( ptr == NULL);
+        if( own)
+            ptr = (T*)fftw_malloc( bytes);
         if( ptr == NULL) 
             throw AllocationError(n, m, _ping_);
     }
@@ -445,6 +553,10 @@ void permute_fields( Matrix<T, P>& first, Matrix<T, P>& second, Matrix<T, P>& th
     first.ptr = third.ptr; 
     third.ptr = second.ptr;
     second.ptr = ptr;
+    const bool own = first.own;
+    first.own = third.own;
+    third.own = second.own;
+    second.own = own;
 }
 
 template <class T, enum Padding P>
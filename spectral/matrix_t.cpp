@@ -48,5 +48,33 @@ int main()
     DoubMat m4(2,8,42.);
     cout << m4 <<endl;
 
+    cout << "Test of the matrix pool...\n";
+    {
+        MatrixPool counter;
+        counter.slot( 0, 0);
+        {
+            MatrixPool::Scope scope( counter);
+            DoubMat a( 2,8), b( 3,5);
+        }
+        const size_t slot = counter.used();
+        cout << "Slot of two matrices "<<slot<<" bytes\n";
+        MatrixPool pool( 2*slot);
+        DoubMat* a[2], *b[2];
+        for( unsigned s=0; s<2; s++)
+        {
+            pool.slot( s*slot, slot);
+            MatrixPool::Scope scope( pool);
+            a[s] = new DoubMat( 2,8, (double)s);
+            b[s] = new DoubMat( 3,5);
+        }
+        DoubMat c( 2,8, 7.); //not in the pool
+        swap_fields( c, *a[1]); //c is freed by the pool, a[1] by fftw_free
+        const bool passed = ( (char*)a[0]->getPtr() == pool.data( 0)) && ( (char*)b[1]->getPtr() - (char*)b[0]->getPtr() == (long)slot)
+                            && ( (char*)c.getPtr() == pool.data( slot)) && c(1,7) == 1. && (*a[1])(1,7) == 7.;
+        cout << ( passed ? "TEST PASSED!\n" : "TEST FAILED!\n");
+        for( unsigned s=0; s<2; s++)
+            delete a[s], delete b[s];
+    }
+
     return 0;
 }
@@ -8,6 +8,8 @@
 #ifndef _TL_QUADMAT_
 #define _TL_QUADMAT_
 #include <iostream>
+#include <algorithm>
+#include <complex>
 #include "exceptions.h"
 
 namespace spectral{
@@ -220,5 +222,155 @@ void invert( const QuadMat< T, 3>& m, QuadMat<T,3>& m1 )
     m1(2,1) = (temp01*temp20 - temp00*m(2,1))/det;
     m1(2,2) = (temp00*temp11 - temp10*temp01)/det;
 }
+
+///@cond
+namespace detail
+{
+//product and reciprocal in real arithmetic (std::complex checks for NaNs and calls a library function)
+inline double mul( const double a, const double b) { return a*b;}
+inline std::complex<double> mul( const std::complex<double>& a, const std::complex<double>& b)
+{
+    return std::complex<double>( a.real()*b.real() - a.imag()*b.imag(), a.real()*b.imag() + a.imag()*b.real());
+}
+inline double reciprocal( const double a) { return 1./a;}
+inline std::complex<double> reciprocal( const std::complex<double>& a)
+{
+    const double norm = a.real()*a.real() + a.imag()*a.imag();
+    return std::complex<double>( a.real()/norm, -a.imag()/norm);
+}
+} //namespace detail
+///@endcond
+
+/*! @brief inverts a batch of 2x2 matrices of given type inplace
+ *
+ * Same closed form as the single matrix version, but the matrices are 
+ * multiplied by the reciprocal of their determinant and the loop 
+ * over the batch contains no branch such that the compiler can vectorise it.
+ * \note throws a Message if a determinant is zero (after all matrices are processed). 
+ * @tparam T double or std::complex<double>
+ * @param m pointer to the first of the matrices. Contains the inverses on output.
+ * @param batch number of matrices 
+ */
+template< typename T>
+void invert( QuadMat<T,2>* m, const size_t batch)
+{
+    bool singular = false;
+    for( size_t b = 0; b < batch; b++)
+    {
+        const T a00 = m[b](0,0), a01 = m[b](0,1), a10 = m[b](1,0), a11 = m[b](1,1);
+        const T det = detail::mul( a00, a11) - detail::mul( a01, a10);
+        singular |= ( det == (T)0);
+        const T r = detail::reciprocal( det);
+        m[b](0,0) =  detail::mul( a11, r);
+        m[b](0,1) = -detail::mul( a01, r);
+        m[b](1,0) = -detail::mul( a10, r);
+        m[b](1,1) =  detail::mul( a00, r);
+    }
+    if( singular) throw Message("Determinant is Zero\n", _ping_);
+}
+
+/*! @brief inverts a batch of 3x3 matrices of given type inplace
+ *
+ * Same closed form (by cofactors) as the single matrix version, but the matrices are 
+ * multiplied by the reciprocal of their determinant and the loop 
+ * over the batch contains no branch such that the compiler can vectorise it.
+ * \note throws a Message if a determinant is zero (after all matrices are processed). 
+ * @tparam T double or std::complex<double>
+ * @param m pointer to the first of the matrices. Contains the inverses on output.
+ * @param batch number of matrices 
+ */
+template< typename T>
+void invert( QuadMat<T,3>* m, const size_t batch)
+{
+    bool singular = false;
+    for( size_t b = 0; b < batch; b++)
+    {
+        const QuadMat<T,3> a = m[b];
+        T c[3][3];
+        c[0][0] = detail::mul( a(1,1), a(2,2)) - detail::mul( a(1,2), a(2,1));
+        c[0][1] = detail::mul( a(0,2), a(2,1)) - detail::mul( a(0,1), a(2,2));
+        c[0][2] = detail::mul( a(0,1), a(1,2)) - detail::mul( a(0,2), a(1,1));
+        c[1][0] = detail::mul( a(1,2), a(2,0)) - detail::mul( a(1,0), a(2,2));
+        c[1][1] = detail::mul( a(0,0), a(2,2)) - detail::mul( a(0,2), a(2,0));
+        c[1][2] = detail::mul( a(0,2), a(1,0)) - detail::mul( a(0,0), a(1,2));
+        c[2][0] = detail::mul( a(1,0), a(2,1)) - detail::mul( a(1,1), a(2,0));
+        c[2][1] = detail::mul( a(0,1), a(2,0)) - detail::mul( a(0,0), a(2,1));
+        c[2][2] = detail::mul( a(0,0), a(1,1)) - detail::mul( a(0,1), a(1,0));
+        const T det = detail::mul( a(0,0), c[0][0]) + detail::mul( a(0,1), c[1][0]) + detail::mul( a(0,2), c[2][0]);
+        singular |= ( det == (T)0);
+        const T r = detail::reciprocal( det);
+        for( unsigned i=0; i<3; i++)
+            for( unsigned j=0; j<3; j++)
+                m[b](i,j) = detail::mul( c[i][j], r);
+    }
+    if( singular) throw Message("Determinant is Zero\n", _ping_);
+}
+
+/*! @brief inverts a batch of nxn matrices of given type inplace
+ *
+ * (overloads the 2x2 and 3x3 versions for any other n)
+ * Uses Gauss-Jordan elimination without pivoting, i.e. the matrices should 
+ * be diagonally dominant. 
+ * The elimination is done on chunks of matrices at once with the 
+ * innermost loops running over the matrices of the chunk, so that the 
+ * compiler can vectorise over the batch.
+ * \note throws a Message if a pivot element is zero. 
+ * @tparam T The type must support basic algorithmic functionality (i.e. +, -, * and /)
+ * @tparam n size of the matrices (any)
+ * @param m pointer to the first of the matrices. Contains the inverses on output.
+ * @param batch number of matrices 
+ */
+template< typename T, size_t n>
+void invert( QuadMat<T,n>* m, const size_t batch)
+{
+    const size_t chunk = 16;
+    T f[chunk];
+    for( size_t b0 = 0; b0 < batch; b0 += chunk)
+    {
+        QuadMat<T,n>* mb = m + b0;
+        const size_t nb = std::min( chunk, batch - b0);
+        for( size_t p = 0; p < n; p++)
+        {
+            for( size_t b = 0; b < nb; b++)
+            {
+                if( mb[b](p,p) == (T)0) throw Message( "Pivot is Zero\n", _ping_);
+                f[b] = (T)1/mb[b](p,p);
+                mb[b](p,p) = 1;
+            }
+            for( size_t q = 0; q < n; q++)
+                for( size_t b = 0; b < nb; b++)
+                    mb[b](p,q) *= f[b];
+            for( size_t r = 0; r < n; r++)
+            {
+                if( r == p) continue;
+                for( size_t b = 0; b < nb; b++)
+                {
+                    f[b] = mb[b](r,p);
+                    mb[b](r,p) = 0;
+                }
+                for( size_t q = 0; q < n; q++)
+                    for( size_t b = 0; b < nb; b++)
+                        mb[b](r,q) -= f[b]*mb[b](p,q);
+            }
+        }
+    }
+}
+
+/*! @brief inverts a nxn matrix of given type 
+ *
+ * (overloads the 2x2 and 3x3 versions for any other n, cf. the batched version)
+ * \attention Without pivoting, cf. the batched version.
+ * \note throws a Message if a pivot element is zero. 
+ * @tparam T The type must support basic algorithmic functionality (i.e. +, -, * and /)
+ * @param in The input matrix 
+ * @param out The output matrix contains the invert of in on output.
+ *  Inversion is inplace if in and out dereference the same object.
+ */
+template< typename T, size_t n>
+void invert( const QuadMat< T, n>& in, QuadMat<T,n>& out )
+{
+    out = in;
+    invert( &out, 1);
+}
 } //namespace spectral
 #endif //_TL_QUADMAT_
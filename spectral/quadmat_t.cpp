@@ -64,6 +64,75 @@ int main()
     catch ( Message& message) {message.display();}
     cout << m <<endl;
     cout << n <<endl;
+  }
+  {
+    cout << "Test of batched inversion\n";
+    QuadMat< complex<double>, 3> b3[5], c3[5];
+    QuadMat< double, 4> b4[20], c4[20];
+    for( size_t b=0; b<5; b++)
+        for( size_t i=0; i<3; i++)
+            for( size_t j=0; j<3; j++)
+                c3[b](i,j) = b3[b](i,j) = complex<double>( (i==j)*(5.+b), i+j+b);
+    for( size_t b=0; b<20; b++)
+        for( size_t i=0; i<4; i++)
+            for( size_t j=0; j<4; j++)
+                c4[b](i,j) = b4[b](i,j) = (i==j)*(10.+b) + (double)(i*j) - (double)b/3.;
+    invert( b3, 5);
+    invert( b4, 20);
+    double diff = 0;
+    for( size_t b=0; b<5; b++)
+    {
+        invert( c3[b], c3[b]);
+        for( size_t i=0; i<3; i++)
+            for( size_t j=0; j<3; j++)
+                diff = max( diff, abs( c3[b](i,j) - b3[b](i,j)));
+    }
+    for( size_t b=0; b<20; b++)
+        for( size_t i=0; i<4; i++)
+            for( size_t j=0; j<4; j++)
+            {
+                double e = 0;
+                for( size_t k=0; k<4; k++)
+                    e += c4[b](i,k)*b4[b](k,j);
+                diff = max( diff, abs( e - (double)(i==j)));
+            }
+    cout << "Maximum difference "<<diff<<"\n";
+    cout << (diff < 1e-14 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+  }
+  {
+    cout << "Test of batched inversion without diagonal dominance\n";
+    //zero diagonals would need pivoting in an elimination
+    QuadMat< complex<double>, 2> b2[7], c2[7];
+    QuadMat< double, 3> b3[7], c3[7];
+    for( size_t b=0; b<7; b++)
+    {
+        c2[b](0,0) = c2[b](1,1) = 0;
+        c2[b](0,1) = complex<double>( 1e3*(b+1), 1.);
+        c2[b](1,0) = complex<double>( -2., 1e-3*b);
+        for( size_t i=0; i<3; i++)
+            for( size_t j=0; j<3; j++)
+                c3[b](i,j) = ( i==j) ? 0. : 1e2*(b+1)*(i+1) - (double)j;
+        b2[b] = c2[b], b3[b] = c3[b];
+    }
+    try{ invert( b2, 7), invert( b3, 7);}
+    catch( Message& message) { message.display();}
+    double diff = 0;
+    for( size_t b=0; b<7; b++)
+    {
+        for( size_t i=0; i<2; i++)
+            for( size_t j=0; j<2; j++)
+                diff = max( diff, abs( c2[b](i,0)*b2[b](0,j) + c2[b](i,1)*b2[b](1,j) - (double)(i==j)));
+        for( size_t i=0; i<3; i++)
+            for( size_t j=0; j<3; j++)
+            {
+                double e = 0;
+                for( size_t k=0; k<3; k++)
+                    e += c3[b](i,k)*b3[b](k,j);
+                diff = max( diff, abs( e - (double)(i==j)));
+            }
+    }
+    cout << "Maximum difference "<<diff<<"\n";
+    cout << (diff < 1e-13 ? "TEST PASSED!\n" : "TEST FAILED!\n");
   }
     return 0;
 
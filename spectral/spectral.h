@@ -21,6 +21,7 @@
 //Arkawa and karniadakis scheme
 #include "arakawa.h"
 #include "karniadakis.h"
+#include "etdrk.h"
 //Fourier transforms
 #include "fft.h"
 #include "dft_dft.h"
@@ -2,6 +2,7 @@
 #define _CONVECTION_SOLVER_
 
 #include <complex>
+#include <sstream>
 
 #include "spectral/spectral.h"
 
@@ -34,6 +35,17 @@ struct Parameter
         os << "h is: "<< h <<"\n";
         os << "dt is: "<< dt <<"\n";
     }
+    /*! @brief A hash of all parameters (FNV-1a)
+     *
+     * @return The hash
+     */
+    unsigned long long hash() const
+    {
+        std::stringstream ss;
+        ss.precision( 17);
+        ss << R <<" "<< P <<" "<< nu <<" "<< nx <<" "<< nz <<" "<< lx <<" "<< lz <<" "<< h <<" "<< dt <<" "<< bc_z;
+        return spectral::fnv1a( ss.str());
+    }
 };
 
 typedef std::complex<double> Complex;
@@ -80,6 +92,24 @@ class Convection_Solver
     void init( std::array< Matrix<double,TL_DFT>, 2>& v, enum target t);
     /*! @brief Perform a step by the 3 step Karniadakis scheme*/
     void step(){ step_<TL_ORDER3>();}
+    /*! @brief Write the complete state of the solver in binary form
+     *
+     * The temperature, the vorticity, the potential, the history of the 
+     * Karniadakis scheme, the time and the hash of the parameters are written.
+     * @param os The (binary) outstream
+     * @param time The time of the current fields
+     */
+    void checkpoint( std::ostream& os, const double time) const;
+    /*! @brief Restore the state written by checkpoint
+     *
+     * Replaces init(), i.e. the next step() continues with the 
+     * third order scheme as if the run was not interrupted.
+     * @param is The (binary) instream
+     * @return The time of the restored fields
+     * @throw Message If the checkpoint belongs to different parameters
+     *  or was written before init()
+     */
+    double restart( std::istream& is);
     /*! @brief Get the result
         
         You get the solution matrix of the current timestep.
@@ -110,12 +140,16 @@ class Convection_Solver
         @note You cannot change parameters once constructed.
      */
     const Parameter& parameter() const { return param;}
-    void setHeat( double x0, double y0, double sigma_x, double sigma_y, double amp){
-        if( x0 >= 0 && x0 < param.lx && y0 >= 0 && y0 < param.lz)
-            x0_ = x0, y0_ = y0, sigma_x_ = sigma_x, sigma_y_ = sigma_y, amp_ = amp;
-        else
-            std::cerr << "x0 or y0 is not within the boundaries!\n";
-    }
+    /*! @brief Set a gaussian heat source (cf. init_gaussian)
+     *
+     * The source is computed once and added to the temperature in every step.
+     * @param x0 x-position of the center
+     * @param y0 y-position of the center
+     * @param sigma_x x-width
+     * @param sigma_y y-width
+     * @param amp The amplitude (0 switches the source off)
+     */
+    void setHeat( double x0, double y0, double sigma_x, double sigma_y, double amp);
   private:
     typedef std::complex<double> complex;
     //methods
@@ -129,6 +163,7 @@ class Convection_Solver
     const size_t crows, ccols;
     double x0_, y0_, sigma_x_, sigma_y_, amp_;
     const Parameter param;
+    Matrix_Type heat; //the heat source (void until the first source is set)
     /////////////////fields//////////////////////////////////
     //GhostMatrix<double, TL_DFT> ghostdens, ghostphi;
     std::array< Matrix_Type, 2> dens, nonlinear;
@@ -149,6 +184,7 @@ Convection_Solver::Convection_Solver( const Parameter& p):
     crows( rows), ccols( cols/2+1),
     x0_(0), y0_(0), sigma_x_(0), sigma_y_(0), amp_(0),
     param( p),
+    heat( rows, cols, false),
     //fields
     dens( MatrixArray<double, TL_DFT, 2>::construct( rows, cols)), nonlinear( dens),
     phi( rows, cols, param.bc_z, TL_PERIODIC),
@@ -262,6 +298,52 @@ void Convection_Solver::first_steps()
     step_<TL_ORDER3>();
 }
 
+void Convection_Solver::checkpoint( std::ostream& os, const double time) const
+{
+    write_binary( os, param.hash());
+    write_binary( os, time);
+    write_binary( os, dens[0]);
+    write_binary( os, dens[1]);
+    write_binary( os, phi);
+    karniadakis.write( os);
+}
+
+double Convection_Solver::restart( std::istream& is)
+{
+    unsigned long long hash;
+    double time;
+    read_binary( is, hash);
+    if( hash != param.hash())
+        throw Message( "Checkpoint belongs to different parameters!", _ping_);
+    read_binary( is, time);
+    read_binary( is, dens[0]);
+    read_binary( is, dens[1]);
+    read_binary( is, phi);
+    karniadakis.read( is);
+    if( karniadakis.levels() < 2)
+        throw Message( "Checkpoint was written before init()!", _ping_);
+    karniadakis.invert_coeff<TL_ORDER3>();
+    return time;
+}
+
+void Convection_Solver::setHeat( double x0, double y0, double sigma_x, double sigma_y, double amp)
+{
+    if( !( x0 >= 0 && x0 < param.lx && y0 >= 0 && y0 < param.lz))
+    {
+        std::cerr << "x0 or y0 is not within the boundaries!\n";
+        return;
+    }
+    if( x0 == x0_ && y0 == y0_ && sigma_x == sigma_x_ && sigma_y == sigma_y_ && amp == amp_)
+        return; //the source is unchanged
+    x0_ = x0, y0_ = y0, sigma_x_ = sigma_x, sigma_y_ = sigma_y, amp_ = amp;
+    if( amp_ == 0)
+        return;
+    if( heat.isVoid())
+        heat.allocate();
+    heat.zero();
+    init_gaussian( heat, x0_, y0_, sigma_x_, sigma_y_, amp_);
+}
+
 void Convection_Solver::compute_cphi()
 {
 #pragma omp parallel for 
@@ -284,12 +366,18 @@ void Convection_Solver::step_()
         arakawa( phi, ghostdens, nonlinear[k]);
         swap_fields( dens[k], ghostdens); //now ghostdens is void
     }
-    if( amp_ != 0)
+    //2. perform karniadakis step (the heat source is added to 
+    //   each line of the temperature right before it is combined)
+#pragma omp parallel for 
+    for( size_t i = 0; i < rows; i++)
     {
-        init_gaussian( dens[0], x0_, y0_, sigma_x_, sigma_y_, amp_);
+        if( amp_ != 0)
+            for( size_t j = 0; j < cols; j++)
+                dens[0](i,j) += heat(i,j);
+        for( unsigned k=0; k<2; k++)
+            karniadakis.step_i_combine<S>( dens[k], nonlinear[k], k, i, i+1);
     }
-    //2. perform karniadakis step
-    karniadakis.step_i<S>( dens, nonlinear);
+    karniadakis.step_i_rotate( dens, nonlinear);
     //3. solve linear equation
     //3.1. transform v_hut
 #pragma omp parallel for 
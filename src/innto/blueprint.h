@@ -2,9 +2,11 @@
 #define _BLUEPRINT_
 
 #include <iostream>
+#include <sstream>
 #include <cmath>
 #include "spectral/ghostmatrix.h" // holds boundary conditions
 #include "spectral/message.h"
+#include "spectral/binary.h"
 
 namespace spectral{
 /*! @addtogroup parameters
@@ -14,7 +16,12 @@ namespace spectral{
  */
 enum cap{   TL_IMPURITY, //!< Include impurities
             TL_GLOBAL, //!< Solve global equations
-            TL_MHW //!< Modify parallel term in electron density equation
+            TL_MHW, //!< Modify parallel term in electron density equation
+            TL_MATRIX_FREE, //!< Recompute the linear coefficients in every step instead of storing them
+            TL_ADAPTIVE_DT, //!< Allow CFL controlled timesteps (keeps the linear coefficients)
+            TL_ETDRK, //!< Use the exponential time differencing scheme instead of the Karniadakis scheme
+            TL_FLOAT_HISTORY, //!< Store the older fields of the Karniadakis scheme in single precision
+            TL_TASK_GRAPH //!< Schedule the phases of a Karniadakis step as OpenMP tasks with per-species dependencies
 };
 
 /*! @brief Possible targets for memory buffer
@@ -137,11 +144,11 @@ class Blueprint
     Physical phys;
     Boundary bound;
     Algorithmic alg;
-    bool imp, global, mhw;
+    bool imp, global, mhw, mfree, adaptive, etd, fhist, tasks;
   public:
     /*! @brief Construct empty blueprint
      */
-    Blueprint():imp(false), global(false), mhw(false){}
+    Blueprint():imp(false), global(false), mhw(false), mfree(false), adaptive(false), etd(false), fhist(false), tasks(false){}
     /*! @brief Init parameters
      *
      * All capacities are disabled by default!
@@ -151,12 +158,12 @@ class Blueprint
      */
     Blueprint( const Physical& phys, const Boundary& bound, const Algorithmic& alg): phys(phys), bound(bound), alg(alg)
     {
-        imp = global = mhw = false; 
+        imp = global = mhw = mfree = adaptive = etd = fhist = tasks = false; 
     }
 
     Blueprint( const std::vector<double>& para)
     {
-        imp = global = mhw = false;
+        imp = global = mhw = mfree = adaptive = etd = fhist = tasks = false;
         alg.nx = para[1];
         alg.ny = para[2];
         alg.dt = para[3];
@@ -231,6 +238,11 @@ class Blueprint
             case( TL_IMPURITY) : imp = true;     break;
             case( TL_GLOBAL):    global = true;  break;
             case( TL_MHW):       mhw = true;     break;
+            case( TL_MATRIX_FREE): mfree = true; break;
+            case( TL_ADAPTIVE_DT): adaptive = true; break;
+            case( TL_ETDRK):     etd = true;     break;
+            case( TL_FLOAT_HISTORY): fhist = true; break;
+            case( TL_TASK_GRAPH): tasks = true;  break;
             default: throw Message( "Unknown Capacity\n", _ping_); //is this necessary?
         }
     }
@@ -245,6 +257,11 @@ class Blueprint
             case( TL_IMPURITY) : return imp;
             case( TL_GLOBAL):    return global;
             case( TL_MHW):       return mhw;
+            case( TL_MATRIX_FREE): return mfree;
+            case( TL_ADAPTIVE_DT): return adaptive;
+            case( TL_ETDRK):     return etd;
+            case( TL_FLOAT_HISTORY): return fhist;
+            case( TL_TASK_GRAPH): return tasks;
             default: throw Message( "Unknown Capacity\n", _ping_);
         }
     }
@@ -252,6 +269,24 @@ class Blueprint
      *
      */
     void consistencyCheck() const;
+    /*! @brief A hash of the parameters that determine the solution
+     *
+     * The physical, boundary and algorithmic parameters, the capacities
+     * that change the equations and the ones that change the stored 
+     * history (ETDRK and single precision history) enter the hash. 
+     * Use it to check that a checkpoint belongs to the parameters of a run.
+     * @return The FNV-1a hash
+     */
+    unsigned long long hash() const
+    {
+        std::stringstream ss;
+        ss.precision( 17);
+        phys.display( ss);
+        bound.display( ss);
+        alg.display( ss);
+        ss << imp << global << mhw << etd << fhist;
+        return fnv1a( ss.str());
+    }
     /*! @brief Print all parameters to an outstream
      *
      * @param os The outstream
@@ -268,7 +303,17 @@ class Blueprint
             //<<"Global solvers are: \n"
             //<<"    "<<(global?enabled:disabled)<<"\n"
             <<"Modified Hasegawa Wakatani: \n"
-            <<"    "<<(mhw?enabled:disabled)<<std::endl;
+            <<"    "<<(mhw?enabled:disabled)<<"\n"
+            <<"Matrix-free linear coefficients: \n"
+            <<"    "<<(mfree?enabled:disabled)<<"\n"
+            <<"Adaptive timestep: \n"
+            <<"    "<<(adaptive?enabled:disabled)<<"\n"
+            <<"Exponential time differencing: \n"
+            <<"    "<<(etd?enabled:disabled)<<"\n"
+            <<"Single precision history: \n"
+            <<"    "<<(fhist?enabled:disabled)<<"\n"
+            <<"Task graph scheduling: \n"
+            <<"    "<<(tasks?enabled:disabled)<<std::endl;
     }
 
 };
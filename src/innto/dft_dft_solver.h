@@ -1,17 +1,25 @@
 #ifndef _DFT_DFT_SOLVER_
 #define _DFT_DFT_SOLVER_
 
+#include <algorithm>
 #include <complex>
+#include <vector>
+#include <memory>
 
 #include "spectral/spectral.h"
 #include "blueprint.h"
 #include "equations.h"
+#include "polarisation.h"
 
 namespace spectral
 {
+template< class Solver>
+class Ensemble;
 
 /*! @brief Solver for periodic boundary conditions of the spectral equations.
  * @ingroup solvers
+ * With TL_GLOBAL the potential is the solution of the global polarisation
+ * equation (cf. Polarisation), else of the local one.
  */
 template< size_t n>
 class DFT_DFT_Solver
@@ -24,17 +32,22 @@ class DFT_DFT_Solver
      * and initializes all fourier coefficients as well as 
      * all low level solvers needed.  
      * @param blueprint Contains all the necessary parameters.
+     * @param shared A solver whose fourier plans are used if the grid is the same
+     *  and whose inverse coefficients are used if in addition the parameters 
+     *  are the same (cf. Karniadakis::share_coeff), e.g. the first member 
+     *  of an ensemble. Its coefficients are inverted now if necessary.
      * @throw Message If your parameters are inconsistent.
      */
-    DFT_DFT_Solver( const Blueprint& blueprint);
+    DFT_DFT_Solver( const Blueprint& blueprint, DFT_DFT_Solver* shared = NULL);
     /*! @brief Prepare Solver for execution
      *
      * This function takes the fields and computes the missing 
      * one according to the target parameter passed. 
-     * @param v Container with three non void matrices
+     * @param v Container with three non void matrices (copied, i.e. the
+     *  solver keeps its own storage)
      * @param t which Matrix is missing?
      */
-    void init( std::array< Matrix<double,TL_DFT>, n>& v, enum target t);
+    void init( const std::array< Matrix<double,TL_DFT>, n>& v, enum target t);
     /**
      * @brief Perform first initializing step
      *
@@ -48,9 +61,99 @@ class DFT_DFT_Solver
     void second_step(); 
     /*! @brief Perform a step by the 3 step Karniadakis scheme
      *
+     * The step uses the current timestep, i.e. the last one chosen by 
+     * step( cfl, dt_max), and the variable timestep coefficients as long 
+     * as the last timesteps are not equidistant.
      * @attention At least one call of first_step() and second_step() is necessary
      * */
-    void step(){ step_<TL_ORDER3>();}
+    void step(){ 
+        if( blue.isEnabled( TL_ETDRK)) 
+            step_etdrk();
+        else
+            step_current();
+    }
+    /*! @brief Perform a step with a CFL controlled timestep
+     *
+     * The timestep is chosen from the maximum ExB velocity v of the current 
+     * potential such that v*dt/h < cfl. To avoid frequent inversions of the 
+     * linear coefficients the timestep is only changed if the 
+     * condition is violated or if a timestep larger by more than (1+threshold)^2 
+     * is allowed. The new timestep is then dt_cfl/(1+threshold) (but at most 1.5 times 
+     * the old timestep and dt_max). A timestep larger than dt_max is always changed. The steps following a change use the 
+     * variable timestep coefficients of the Karniadakis scheme.
+     * @param cfl The maximum Courant number 
+     * @param dt_max The maximum timestep
+     * @param threshold The relative change of the timestep that triggers a change
+     * @return The timestep of this step
+     * @note The calls may be mixed with step() and step( N), which keep the current timestep.
+     * @attention Enable TL_ADAPTIVE_DT (or TL_MATRIX_FREE) in the Blueprint. At least one call of first_step() and second_step() is necessary
+     */
+    double step( const double cfl, const double dt_max, const double threshold = 0.2);
+    /*! @brief Perform N steps by the 3 step Karniadakis scheme
+     *
+     * Equals N calls of step() but all steps are computed by one 
+     * team of threads, i.e. the parallel region is opened only once 
+     * and the phases of a step are separated by barriers instead of 
+     * the fork and join of a new parallel region. Call this function 
+     * with the number of steps between two outputs.
+     * If TL_TASK_GRAPH is enabled the N steps are one graph of tasks, i.e.
+     * a step can start with the species whose fields of the last step are finished.
+     * @param N the number of steps
+     * @attention At least one call of first_step() and second_step() is necessary
+     */
+    void step( const unsigned N);
+    /*! @brief Write the complete state of the solver in binary form
+     *
+     * The densities, the potentials, the history of the Karniadakis scheme, 
+     * the time and the hash of the blueprint are written.
+     * @param os The (binary) outstream
+     * @param time The time of the current fields
+     * @attention At least one call of first_step() and second_step() is necessary
+     */
+    void checkpoint( std::ostream& os, const double time) const;
+    /*! @brief Restore the state written by checkpoint
+     *
+     * Replaces init(), first_step() and second_step(), i.e. the next step()
+     * continues with the third order scheme as if the run was not interrupted.
+     * @param is The (binary) instream
+     * @return The time of the restored fields
+     * @throw Message If the checkpoint belongs to a different blueprint 
+     *  or was written before second_step() (the history is incomplete then)
+     */
+    double restart( std::istream& is);
+    /*! @brief Change the physical parameters of a running solver
+     *
+     * Recomputes the coefficients of the linear part and of the potential
+     * (and the inverses of the Karniadakis scheme) in parallel and the 
+     * potentials of the current densities. The fields, the history 
+     * and the fourier plans are kept, i.e. the next step continues 
+     * with the new parameters (e.g. in a parameter scan or a continuation run).
+     * @param phys The new physical parameters
+     * @throw Message If the new parameters are inconsistent (the solver is unchanged then)
+     */
+    void set_physical( const Physical& phys);
+    /*! @brief Take the state of a solver of a different resolution
+     *
+     * The densities and the history of the Karniadakis scheme are transferred
+     * by spectral prolongation (zero padding) or restriction (truncation) 
+     * of their fourier modes (cf. resize_spectrum), the potentials are 
+     * recomputed. The timesteps of src are kept. Use it to start a run coarse
+     * and refine it when the top shell of modes fills up (cf. top_shell)
+     * or to coarsen it for long time statistics.
+     * @param src A solver in the same box with the same capacities,
+     *  on which first_step() and second_step() were called
+     * @throw Message If the box, the time scheme or the precision of the history differ
+     * @attention The solver continues with third order steps (do not call first_step and second_step)
+     */
+    void resample( const DFT_DFT_Solver& src);
+    /*! @brief The fraction of the spectral energy in the top shell of modes
+     *
+     * The energy of the electron density in the modes with |kx| or |ky| 
+     * larger than shell times the largest resolved wavenumber.
+     * @param shell The inner boundary of the top shell relative to the largest wavenumber
+     * @return The fraction of the energy in the top shell
+     */
+    double top_shell( const double shell = 2./3.);
     /*! @brief Get the result
         
         You get the solution matrix of the current timestep.
@@ -76,41 +179,75 @@ class DFT_DFT_Solver
     */
     void getField( Matrix<double, TL_DFT>& m, enum target t);
     const std::array<Matrix<double, TL_DFT>, n>& getDensity( )const{return dens;}
-    const std::array<Matrix<double, TL_DFT>, n>& getPotential( )const{return phi;}
+    /*! @brief Get the potentials of all species
+     *
+     * The potentials of species with a trivial gyro-average (e.g. tau = 0) 
+     * equal phi[0] and are not transformed in the steps but copied 
+     * at the end of each step.
+     * @return The potentials of the current timestep
+     */
+    const std::array<Matrix<double, TL_DFT>, n>& getPotential( ) const { return phi;}
     /*! @brief Get the parameters of the solver.
 
         @return The parameters in use. 
-        @note You cannot change parameters once constructed.
+        @note Only the physical parameters can be changed (cf. set_physical).
      */
     const Blueprint& blueprint() const { return blue;}
   private:
+    template< class Solver>
+    friend class Ensemble; //steps the members together
     typedef std::complex<double> complex;
     //methods
-    void init_coefficients( const Boundary& bound, const Physical& phys);
+    void init_coefficients( const Boundary& bound, const Physical& phys, const bool update = false, Karniadakis<n, complex, TL_DFT>* tables = NULL);
+    void linear_coefficients( const size_t i, QuadMat< complex, n>* line) const;
     void compute_cphi();//multiply cphi
+    void update_potential();//compute phi of the current densities
+    void global_potential( const bool extrapolate = false);//correct cphi by the global polarisation equation
+    void copy_aliased();//phi[k] = phi[0] for the species with trivial gyro-average
+    void compute_cphi( const size_t i_begin, const size_t i_end);//multiply cphi in some lines (serial)
+    void spectral_update( const size_t i_begin, const size_t i_end);//step_ii and cphi in some lines (serial)
     double dot( const Matrix_Type& m1, const Matrix_Type& m2);
+    double max_velocity() const;
     template< enum stepper S>
-    void step_();
+    void step_(){ step_( step_coefficients<S>());}
+    void step_( const StepCoefficients& c);
+    void step_current();//third order step with the current timestep
+    void step_nonlinear( const StepCoefficients& c);//nonlinearity and step_i (the first half of step_)
+    void step_shared( const StepCoefficients& c);
+    void step_tasks( const StepCoefficients& c);
+    void ghost_pointers( std::array< const GhostMatrix<double, TL_DFT>*, n>& pdens, std::array< const GhostMatrix<double, TL_DFT>*, n>& pphi) const;
+    void step_etdrk();
+    template< class Tile>
+    void nonlinearity( const Tile& tile);
     //members
     const size_t rows, cols;
     const size_t crows, ccols;
-    const Blueprint blue;
+    Blueprint blue;
     /////////////////fields//////////////////////////////////
-    //GhostMatrix<double, TL_DFT> ghostdens, ghostphi;
-    std::array< Matrix<double, TL_DFT>, n> dens, phi, nonlinear;
+    std::vector< GhostMatrix<double, TL_DFT> > ghostdens, ghostphi; //void, hold dens and phi during the nonlinearity
+    std::array< Matrix<double, TL_DFT>, n> dens;
+    std::array< Matrix<double, TL_DFT>, n> phi;
+    std::array< Matrix<double, TL_DFT>, n> nonlinear;
     /////////////////Complex (void) Matrices for fourier transforms///////////
     std::array< Matrix< complex>, n> cdens, cphi;
     ///////////////////Solvers////////////////////////
     Arakawa arakawa;
-    Karniadakis<n, complex, TL_DFT> karniadakis;
-    DFT_DFT dft_dft;
+    std::unique_ptr< Karniadakis<n, complex, TL_DFT> > karniadakis; //the multistep scheme (null if ETDRK)
+    ETDRK<n, complex> etdrk;
+    std::shared_ptr< DFT_DFT> dft_dft; //the plans (shared with the solvers of the same grid)
     /////////////////////Coefficients//////////////////////
     Matrix< std::array< double, n> > phi_coeff;
     std::array< Matrix< double>, n-1> gamma_coeff;
+    std::array< bool, n> alias; //the gyro-average of species k is trivial, i.e. phi[k] equals phi[0] and is not computed
+    std::unique_ptr< const Equations> equations; //the linear part of the current parameters (for linear_coefficients)
+    std::unique_ptr< Polarisation> polarisation; //solves the global polarisation equation (null if local)
+    /////////////////////Task graph//////////////////////
+    const size_t blocks; //number of line blocks of the nonlinearity and the spectral update
+    std::vector< char> sentinel; //dependencies of the tasks: dens and phi of every species and the coupling
 };
 
 template< size_t n>
-DFT_DFT_Solver<n>::DFT_DFT_Solver( const Blueprint& bp):
+DFT_DFT_Solver<n>::DFT_DFT_Solver( const Blueprint& bp, DFT_DFT_Solver* shared):
     rows( bp.algorithmic().ny ), cols( bp.algorithmic().nx ),
     crows( rows), ccols( cols/2+1),
     blue( bp),
@@ -121,38 +258,45 @@ DFT_DFT_Solver<n>::DFT_DFT_Solver( const Blueprint& bp):
     cphi(cdens), 
     //Solvers
     arakawa( bp.algorithmic().h),
-    karniadakis(rows, cols, crows, ccols, bp.algorithmic().dt),
-    dft_dft( rows, cols, FFTW_MEASURE),
+    etdrk( crows, ccols, bp.algorithmic().dt, TL_HERMITIAN),
+    dft_dft( shared != NULL && shared->rows == rows && shared->cols == cols ? shared->dft_dft : std::shared_ptr< DFT_DFT>( new DFT_DFT( rows, cols, FFTW_MEASURE))),
     //Coefficients
     phi_coeff( crows, ccols),
-    gamma_coeff( MatrixArray< double, TL_NONE, n-1>::construct( crows, ccols))
+    gamma_coeff( MatrixArray< double, TL_NONE, n-1>::construct( crows, ccols)),
+    blocks( std::max( 1, std::min( (int)std::min( rows, crows)/8, 4*omp_get_max_threads()))),
+    sentinel( n + n + 1)
 {
     bp.consistencyCheck();
-    if( bp.isEnabled( TL_GLOBAL))
+    ghostdens.reserve( n), ghostphi.reserve( n);
+    for( unsigned k=0; k<n; k++)
     {
-        std::cerr << "WARNING: GLOBAL solver not implemented yet! \n\
-             Switch to local solver...\n";
+        ghostdens.emplace_back( rows, cols, TL_PERIODIC, TL_PERIODIC, TL_VOID);
+        ghostphi.emplace_back(  rows, cols, TL_PERIODIC, TL_PERIODIC, TL_VOID);
     }
-    init_coefficients( bp.boundary(), bp.physical());
+    if( bp.isEnabled( TL_GLOBAL))
+        polarisation.reset( new Polarisation( rows, cols, bp.boundary().lx, bp.boundary().ly, bp.physical()));
+    if( !bp.isEnabled( TL_ETDRK)) //ETDRK needs neither the history nor the inverse tables
+        karniadakis.reset( new Karniadakis<n, complex, TL_DFT>( rows, cols, crows, ccols, bp.algorithmic().dt, TL_HERMITIAN, bp.isEnabled( TL_FLOAT_HISTORY) ? TL_FLOAT : TL_DOUBLE)); //line rows-i holds ky = -ky(i)
+    const bool share = shared != NULL && karniadakis && shared->karniadakis && !bp.isEnabled( TL_MATRIX_FREE)
+                    && shared->blue.hash() == bp.hash() && shared->blue.isEnabled( TL_ADAPTIVE_DT) == bp.isEnabled( TL_ADAPTIVE_DT);
+    init_coefficients( bp.boundary(), bp.physical(), false, share ? shared->karniadakis.get() : NULL);
 }
 
+//tables: a scheme with the same coefficients (they are shared instead of computed)
 template< size_t n>
-void DFT_DFT_Solver<n>::init_coefficients( const Boundary& bound, const Physical& phys)
+void DFT_DFT_Solver<n>::init_coefficients( const Boundary& bound, const Physical& phys, const bool update, Karniadakis<n, complex, TL_DFT>* tables)
 {
-    Matrix< QuadMat< complex, n> > coeff( crows, ccols);
-    double laplace;
-    int ik;
-    const complex dymin( 0, 2.*M_PI/bound.ly);
+    equations.reset( new Equations( phys, blue.isEnabled( TL_MHW)));
     const double kxmin2 = 2.*2.*M_PI*M_PI/(double)(bound.lx*bound.lx),
                  kymin2 = 2.*2.*M_PI*M_PI/(double)(bound.ly*bound.ly);
-    Equations e( phys, blue.isEnabled( TL_MHW));
-    Poisson p( phys);
+    const Poisson p( phys);
     // dft_dft is not transposing so i is the y index by default
+#pragma omp parallel for
     for( unsigned i = 0; i<crows; i++)
         for( unsigned j = 0; j<ccols; j++)
         {
-            ik = (i>rows/2) ? (i-rows) : i; //integer division rounded down
-            laplace = - kxmin2*(double)(j*j) - kymin2*(double)(ik*ik);
+            const int ik = (i>rows/2) ? (i-rows) : i; //integer division rounded down
+            const double laplace = - kxmin2*(double)(j*j) - kymin2*(double)(ik*ik);
             if( n == 2)
             {
                 gamma_coeff[0](i,j) = p.gamma1_i( laplace);
@@ -162,18 +306,171 @@ void DFT_DFT_Solver<n>::init_coefficients( const Boundary& bound, const Physical
                 gamma_coeff[0](i,j) = p.gamma1_i( laplace);
                 gamma_coeff[1](i,j) = p.gamma1_z( laplace);
             }
-            if( rows%2 == 0 && i == rows/2) ik = 0;
-            e( coeff( i,j), laplace, (double)ik*dymin);
             if( laplace == 0) continue;
             p( phi_coeff(i,j), laplace);  
         }
         //for periodic bc the constant is undefined
     for( unsigned k=0; k<n; k++)
         phi_coeff(0,0)[k] = 0;
-    karniadakis.init_coeff( coeff, (double)(rows*cols));
+    //detect the trivial gyro-averages
+    alias[0] = false;
+    for( unsigned k=1; k<n; k++)
+    {
+        alias[k] = true;
+        for( size_t i = 0; i < crows; i++)
+            for( size_t j = 0; j < ccols; j++)
+                if( gamma_coeff[k-1](i,j) != 1.)
+                    alias[k] = false;
+    }
+    if( blue.isEnabled( TL_MATRIX_FREE) && !blue.isEnabled( TL_ETDRK)) //ETDRK always stores its exponentials
+    {
+        if( !update) karniadakis->init_coeff( (double)(rows*cols));
+        return;
+    }
+    if( tables != NULL)
+    {
+        karniadakis->share_coeff( *tables);
+        return;
+    }
+    Matrix< QuadMat< complex, n> > coeff( crows, ccols);
+#pragma omp parallel for
+    for( unsigned i = 0; i<crows; i++)
+        linear_coefficients( i, &coeff( i,0));
+    if( blue.isEnabled( TL_ETDRK))
+    {
+        etdrk.init_coeff( coeff, (double)(rows*cols));
+        return;
+    }
+    if( update)
+        karniadakis->update_coeff( coeff);
+    else
+        karniadakis->init_coeff( coeff, (double)(rows*cols), blue.isEnabled( TL_ADAPTIVE_DT));
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::set_physical( const Physical& phys)
+{
+    Blueprint bp( blue);
+    bp.physical() = phys;
+    bp.consistencyCheck();
+    blue = bp;
+    init_coefficients( blue.boundary(), blue.physical(), true);
+    if( polarisation)
+        polarisation->set_physical( blue.physical());
+    update_potential();
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::resample( const DFT_DFT_Solver& src)
+{
+    if( src.blue.boundary().lx != blue.boundary().lx || src.blue.boundary().ly != blue.boundary().ly)
+        throw Message( "Solvers must have the same box!", _ping_);
+    if( src.blue.isEnabled( TL_ETDRK) != blue.isEnabled( TL_ETDRK))
+        throw Message( "Solvers must use the same time scheme!", _ping_);
+    DFT_DFT forward( src.rows, src.cols, FFTW_ESTIMATE); //src is const
+    Matrix< double, TL_DFT> from( src.rows, src.cols);
+    Matrix< complex> cfrom( src.crows, src.ccols), cto( crows, ccols);
+    //spectral prolongation or restriction of a field of src 
+    auto transfer = [&]( const Matrix< double, TL_DFT>& src_field, Matrix< double, TL_DFT>& field)
+    {
+        from = src_field;
+        forward.r2c( from, cfrom);
+        resize_spectrum( cfrom, cto);
+        dft_dft->c2r( cto, field);
+        swap_fields( from, cfrom); //from is allocated again
+    };
+    for( unsigned k=0; k<n; k++)
+        transfer( src.dens[k], dens[k]);
+    update_potential();
+    if( blue.isEnabled( TL_ETDRK))
+        return;
+    karniadakis->resample( *src.karniadakis, transfer);
+    karniadakis->template invert_coeff<TL_ORDER3>();
+}
+
+template< size_t n>
+double DFT_DFT_Solver<n>::top_shell( const double shell)
+{
+    nonlinear[0] = dens[0];
+    dft_dft->r2c( nonlinear[0], cdens[0]);
+    double top = 0, all = 0;
+#pragma omp parallel for reduction( +: top, all)
+    for( size_t i = 0; i < crows; i++)
+    {
+        const int ik = (i>rows/2) ? (int)i-(int)rows : (int)i;
+        for( size_t j = 0; j < ccols; j++)
+        {
+            const double energy = ( j == 0 ? 1. : 2.)*std::norm( cdens[0](i,j)); //the negative kx are not stored
+            all += energy;
+            if( 2.*fabs( (double)ik) > shell*(double)rows || 2.*(double)j > shell*(double)cols)
+                top += energy;
+        }
+    }
+    return all > 0 ? top/all : 0;
+}
+
+//the potentials of the current densities
+template< size_t n>
+void DFT_DFT_Solver<n>::update_potential()
+{
+    const double norm = (double)(rows*cols);
+#pragma omp parallel for 
+    for( unsigned k=0; k<n; k++)
+    {
+        nonlinear[k] = dens[k]; //the densities are kept
+        dft_dft->r2c( nonlinear[k], cdens[k]);
+        for( size_t i = 0; i < crows; i++)
+            for( size_t j = 0; j < ccols; j++)
+                cdens[k](i,j) /= norm;
+    }
+    compute_cphi();
+    global_potential();
+#pragma omp parallel for 
+    for( unsigned k=0; k<n; k++)
+        if( !alias[k]) dft_dft->c2r( cphi[k], phi[k]);
+    copy_aliased();
+}
+
+//the back-transform of phi[0] is valid for all aliased species
+template< size_t n>
+void DFT_DFT_Solver<n>::copy_aliased()
+{
+    for( unsigned k=1; k<n; k++)
+        if( alias[k]) 
+            phi[k] = phi[0];
 }
+
+//the global potential from the local one in cphi[0]
 template< size_t n>
-void DFT_DFT_Solver<n>::init( std::array< Matrix<double, TL_DFT>,n>& v, enum target t)
+void DFT_DFT_Solver<n>::global_potential( const bool extrapolate)
+{
+    if( !polarisation)
+        return;
+    (*polarisation)( cdens, cphi[0], extrapolate);
+#pragma omp parallel for 
+    for( size_t i = 0; i < crows; i++)
+        for( size_t j = 0; j < ccols; j++)
+            for( unsigned k=0; k<n-1; k++)
+                if( !alias[k+1])
+                    cphi[k+1](i,j) = gamma_coeff[k](i,j)*cphi[0](i,j);
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::linear_coefficients( const size_t i, QuadMat< complex, n>* line) const
+{
+    const Boundary& bound = blue.boundary();
+    const complex dymin( 0, 2.*M_PI/bound.ly);
+    const double kxmin2 = 2.*2.*M_PI*M_PI/(double)(bound.lx*bound.lx),
+                 kymin2 = 2.*2.*M_PI*M_PI/(double)(bound.ly*bound.ly);
+    const Equations& e = *equations;
+    int ik = (i>rows/2) ? (int)i-(int)rows : (int)i; //integer division rounded down
+    const double laplace_y = - kymin2*(double)(ik*ik);
+    if( rows%2 == 0 && i == rows/2) ik = 0;
+    for( unsigned j = 0; j<ccols; j++)
+        e( line[j], - kxmin2*(double)(j*j) + laplace_y, (double)ik*dymin);
+}
+template< size_t n>
+void DFT_DFT_Solver<n>::init( const std::array< Matrix<double, TL_DFT>,n>& v, enum target t)
 { 
     //fourier transform input into cdens
     for( unsigned k=0; k<n; k++)
@@ -182,13 +479,11 @@ void DFT_DFT_Solver<n>::init( std::array< Matrix<double, TL_DFT>,n>& v, enum tar
         if( v[k].isVoid())
             throw Message("You gave me a void Matrix!!", _ping_);
 #endif
-        dft_dft.r2c( v[k], cdens[k]);
+        nonlinear[k] = v[k]; //the storage of v stays with the caller
+        dft_dft->r2c( nonlinear[k], cdens[k]);
     }
-    //don't forget to normalize coefficients!!
-    for( unsigned k=0; k<n; k++)
-        for( unsigned i=0; i<crows; i++)
-            for( unsigned j=0; j<ccols;j++)
-                cdens[k](i,j) /= (double)(rows*cols);
+    //don't forget to normalize coefficients!! (done with the rest cphi[k])
+    const double norm = (double)(rows*cols);
     switch( t) //which field must be computed?
     {
         case( TL_ELECTRONS): 
@@ -246,11 +541,19 @@ void DFT_DFT_Solver<n>::init( std::array< Matrix<double, TL_DFT>,n>& v, enum tar
         case( TL_ALL):
             throw Message( "TL_ALL not treated yet!", _ping_);
     }
-    //compute the rest cphi[k]
-    for( unsigned k=0; k<n-1; k++)
-        for( size_t i = 0; i < crows; i++)
-            for( size_t j = 0; j < ccols; j++)
-                cphi[k+1](i,j) = gamma_coeff[k](i,j)*cphi[0](i,j);
+    //normalize and compute the rest cphi[k] in one pass (all equations are linear)
+    for( size_t i = 0; i < crows; i++)
+        for( size_t j = 0; j < ccols; j++)
+        {
+            for( unsigned k=0; k<n; k++)
+                cdens[k](i,j) /= norm;
+            cphi[0](i,j) /= norm;
+            for( unsigned k=0; k<n-1; k++)
+                if( !alias[k+1])
+                    cphi[k+1](i,j) = gamma_coeff[k](i,j)*cphi[0](i,j);
+        }
+    if( t == TL_POTENTIAL) //the densities are given
+        global_potential();
     //backtransform to x-space
     for( unsigned k=0; k<n; k++)
     {
@@ -258,9 +561,10 @@ void DFT_DFT_Solver<n>::init( std::array< Matrix<double, TL_DFT>,n>& v, enum tar
         cdens[k](0,0) = 0;
         cphi[k](0,0) = 0;
 
-        dft_dft.c2r( cdens[k], dens[k]);
-        dft_dft.c2r( cphi[k], phi[k]);
+        dft_dft->c2r( cdens[k], dens[k]);
+        if( !alias[k]) dft_dft->c2r( cphi[k], phi[k]);
     }
+    copy_aliased();
     //now the density and the potential is given in x-space
     //first_steps();
 }
@@ -299,96 +603,440 @@ const Matrix<double, TL_DFT>& DFT_DFT_Solver<n>::getField( enum target t) const
 template< size_t n>
 void DFT_DFT_Solver<n>::first_step()
 {
-    karniadakis.template invert_coeff<TL_EULER>( );
+    if( blue.isEnabled( TL_ETDRK))
+    {
+        step_etdrk();
+        return;
+    }
+    karniadakis->template invert_coeff<TL_EULER>( );
     step_<TL_EULER>();
 }
 
 template< size_t n>
 void DFT_DFT_Solver<n>::second_step()
 {
-    karniadakis.template invert_coeff<TL_ORDER2>();
+    if( blue.isEnabled( TL_ETDRK))
+    {
+        step_etdrk();
+        return;
+    }
+    karniadakis->template invert_coeff<TL_ORDER2>();
     step_<TL_ORDER2>();
-    karniadakis.template invert_coeff<TL_ORDER3>();
+    karniadakis->template invert_coeff<TL_ORDER3>();
 }
 
 template< size_t n>
-void DFT_DFT_Solver<n>::compute_cphi()
+void DFT_DFT_Solver<n>::checkpoint( std::ostream& os, const double time) const
 {
-    if( n==2)
+    write_binary( os, blue.hash());
+    write_binary( os, time);
+    for( unsigned k=0; k<n; k++)
     {
-#pragma omp parallel for 
-        for( size_t i = 0; i < crows; i++){
-            for( size_t j = 0; j < ccols; j++)
-                cphi[0](i,j) = phi_coeff(i,j)[0]*cdens[0](i,j) 
-                             + phi_coeff(i,j)[1]*cdens[1](i,j);
-        }
-//#pragma omp barrier
-#pragma omp parallel for 
-        for( size_t i = 0; i < crows; i++){
-            for( size_t j = 0; j < ccols; j++)
-                cphi[1](i,j) = gamma_coeff[0](i,j)*cphi[0](i,j);
-        }
-//#pragma omp barrier
+        write_binary( os, dens[k]);
+        write_binary( os, phi[k]);
+    }
+    if( !blue.isEnabled( TL_ETDRK)) //the ETDRK scheme has no history
+        karniadakis->write( os);
+}
+
+template< size_t n>
+double DFT_DFT_Solver<n>::restart( std::istream& is)
+{
+    unsigned long long hash;
+    double time;
+    read_binary( is, hash);
+    if( hash != blue.hash())
+        throw Message( "Checkpoint belongs to different parameters!", _ping_);
+    read_binary( is, time);
+    for( unsigned k=0; k<n; k++)
+    {
+        read_binary( is, dens[k]);
+        read_binary( is, phi[k]);
     }
-    else if( n==3)
+    if( !blue.isEnabled( TL_ETDRK))
     {
+        karniadakis->read( is);
+        if( karniadakis->levels() < 2)
+            throw Message( "Checkpoint was written before second_step()!", _ping_);
+        karniadakis->template invert_coeff<TL_ORDER3>();
+    }
+    return time;
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::compute_cphi()
+{
 #pragma omp parallel for 
-        for( size_t i = 0; i < crows; i++){
-            for( size_t j = 0; j < ccols; j++)
-                cphi[0](i,j) = phi_coeff(i,j)[0]*cdens[0](i,j) 
-                             + phi_coeff(i,j)[1]*cdens[1](i,j) 
-                             + phi_coeff(i,j)[2]*cdens[2](i,j);
+    for( size_t i = 0; i < crows; i++)
+        compute_cphi( i, i+1);
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::compute_cphi( const size_t i_begin, const size_t i_end)
+{
+    for( size_t i = i_begin; i < i_end; i++)
+        for( size_t j = 0; j < ccols; j++)
+        {
+            cphi[0](i,j) = phi_coeff(i,j)[0]*cdens[0](i,j);
+            for( unsigned k=1; k<n; k++)
+                cphi[0](i,j) += phi_coeff(i,j)[k]*cdens[k](i,j);
+            for( unsigned k=0; k<n-1; k++)
+                if( !alias[k+1])
+                    cphi[k+1](i,j) = gamma_coeff[k](i,j)*cphi[0](i,j);
         }
-//#pragma omp barrier
-#pragma omp parallel for 
-        for( size_t i = 0; i < crows; i++){
-            for( size_t j = 0; j < ccols; j++)
-            {
-                cphi[1](i,j) = gamma_coeff[0](i,j)*cphi[0](i,j);
-                cphi[2](i,j) = gamma_coeff[1](i,j)*cphi[0](i,j);
-            }
+}
+
+//the spectral part of a karniadakis step linewise, i.e. each line of cdens 
+//is multiplied by the (normalized) inverse coefficients and the potentials 
+//are computed from it while it is still in cache
+template< size_t n>
+void DFT_DFT_Solver<n>::spectral_update( const size_t i_begin, const size_t i_end)
+{
+    for( size_t i = i_begin; i < i_end; i++)
+    {
+        if( blue.isEnabled( TL_MATRIX_FREE))
+            karniadakis->step_ii( cdens, [this]( size_t l, QuadMat< complex, n>* line){ linear_coefficients( l, line);}, i, i+1);
+        else
+            karniadakis->step_ii( cdens, i, i+1);
+        compute_cphi( i, i+1);
+    }
+}
+
+//max( |dy phi| + |dx phi|) of the electric potential
+template< size_t n>
+double DFT_DFT_Solver<n>::max_velocity() const
+{
+    const Matrix_Type& p = phi[0];
+    double v = 0;
+#pragma omp parallel for reduction( max: v)
+    for( size_t i = 0; i < rows; i++)
+    {
+        const size_t ip = (i+1)%rows, im = (i+rows-1)%rows;
+        for( size_t j = 0; j < cols; j++)
+        {
+            const size_t jp = (j+1)%cols, jm = (j+cols-1)%cols;
+            v = std::max( v, fabs( p( ip, j) - p( im, j)) + fabs( p( i, jp) - p( i, jm)));
         }
-//#pragma omp barrier
     }
+    return v/2./blue.algorithmic().h;
 }
 
+template< size_t n>
+double DFT_DFT_Solver<n>::step( const double cfl, const double dt_max, const double threshold)
+{
+    if( !blue.isEnabled( TL_ADAPTIVE_DT) && !blue.isEnabled( TL_MATRIX_FREE))
+        throw Message( "Enable adaptive timesteps in the blueprint first!", _ping_);
+    if( blue.isEnabled( TL_ETDRK))
+        throw Message( "Adaptive timesteps are not implemented for the ETDRK scheme!", _ping_);
+    const double dt = karniadakis->timestep();
+    const double v = max_velocity();
+    const double dt_cfl = ( v > 0) ? cfl*blue.algorithmic().h/v : dt_max;
+    if( dt > dt_cfl || dt > dt_max || dt*(1.+threshold)*(1.+threshold) < std::min( dt_cfl, dt_max))
+        karniadakis->set_timestep( std::min( std::min( dt_cfl/(1.+threshold), 1.5*dt), dt_max));
+    step_current();
+    return karniadakis->timestep();
+}
 
+//the fixed coefficients are only valid for equidistant timesteps
+template< size_t n>
+void DFT_DFT_Solver<n>::step_current()
+{
+    if( karniadakis->equidistant())
+    {
+        karniadakis->template invert_coeff<TL_ORDER3>();
+        step_<TL_ORDER3>();
+    }
+    else
+    {
+        const StepCoefficients c = karniadakis->variable_coefficients();
+        karniadakis->invert_coeff( c.gamma_0);
+        step_( c);
+    }
+}
 
+//compute the nonlinearity and call tile( ghostdens, i_begin, i_end) after each finished tile
 template< size_t n>
-template< enum stepper S>
-void DFT_DFT_Solver<n>::step_()
+template< class Tile>
+void DFT_DFT_Solver<n>::nonlinearity( const Tile& tile)
 {
-    //1. Compute nonlinearity
+    std::array< const GhostMatrix<double, TL_DFT>*, n> pdens, pphi;
 #pragma omp parallel for 
     for( unsigned k=0; k<n; k++)
     {
-        GhostMatrix<double, TL_DFT> ghostdens{ rows, cols, TL_PERIODIC, TL_PERIODIC}; 
-        GhostMatrix<double, TL_DFT> ghostphi{ rows, cols, TL_PERIODIC, TL_PERIODIC};
-        swap_fields( dens[k], ghostdens); //now dens[k] is void
-        swap_fields( phi[k], ghostphi); //now phi[k] is void
-        ghostdens.initGhostCells( );
-        ghostphi.initGhostCells(  );
-        arakawa( ghostdens, ghostphi, nonlinear[k]);
-        swap_fields( dens[k], ghostdens); //now ghostdens is void
-        swap_fields( phi[k], ghostphi); //now ghostphi is void
-    }
-    //2. perform karniadakis step
-    karniadakis.template step_i<S>( dens, nonlinear);
+        swap_fields( dens[k], ghostdens[k]); //now dens[k] is void
+        ghostdens[k].initGhostCells( );
+        if( alias[k]) continue; //shares the ghostcells of phi[0]
+        swap_fields( phi[k], ghostphi[k]); //now phi[k] is void
+        ghostphi[k].initGhostCells(  );
+    }
+    ghost_pointers( pdens, pphi);
+    arakawa( pdens, pphi, nonlinear, [&]( size_t i_begin, size_t i_end){ tile( ghostdens, i_begin, i_end);});
+    for( unsigned k=0; k<n; k++)
+    {
+        swap_fields( dens[k], ghostdens[k]); //now ghostdens is void
+        if( !alias[k]) swap_fields( phi[k], ghostphi[k]); //now ghostphi is void
+    }
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::step_( const StepCoefficients& c)
+{
+    if( blue.isEnabled( TL_TASK_GRAPH) && !polarisation)
+    {
+#pragma omp parallel
+#pragma omp single
+        step_tasks( c);
+        copy_aliased();
+        return;
+    }
+    step_nonlinear( c);
     //3. solve linear equation
     //3.1. transform v_hut
 #pragma omp parallel for 
     for( unsigned k=0; k<n; k++){
-        dft_dft.r2c( dens[k], cdens[k]);}
-    //3.2. perform karniadaksi step and multiply coefficients for phi
-    karniadakis.step_ii( cdens);
-    compute_cphi();
+        dft_dft->r2c( dens[k], cdens[k]);}
+    //3.2. perform karniadakis step and multiply coefficients for phi in one pass
+#pragma omp parallel for schedule( static)
+    for( size_t i = 0; i < crows; i++)
+        spectral_update( i, i+1);
+    global_potential( true);
     //3.3. backtransform
 #pragma omp parallel for 
     for( unsigned k=0; k<n; k++)
     {
-        dft_dft.c2r( cdens[k], dens[k]);
-        dft_dft.c2r( cphi[k],  phi[k]);
+        dft_dft->c2r( cdens[k], dens[k]);
+        if( !alias[k]) dft_dft->c2r( cphi[k],  phi[k]);
+    }
+    copy_aliased();
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::step_nonlinear( const StepCoefficients& c)
+{
+    //1. Compute nonlinearity and
+    //2. perform karniadakis step on each finished tile while it is in cache
+    nonlinearity( [&]( const std::vector< GhostMatrix<double, TL_DFT> >& ghostdens, size_t i_begin, size_t i_end)
+    {
+        for( unsigned k=0; k<n; k++)
+            karniadakis->step_i_combine( ghostdens[k], nonlinear[k], k, i_begin, i_end, c);
+    });
+    karniadakis->step_i_rotate( dens, nonlinear);
+}
+
+//species with trivial gyro-average (e.g. tau = 0) share the electron potential 
+template< size_t n>
+void DFT_DFT_Solver<n>::ghost_pointers( std::array< const GhostMatrix<double, TL_DFT>*, n>& pdens, std::array< const GhostMatrix<double, TL_DFT>*, n>& pphi) const
+{
+    for( unsigned k=0; k<n; k++)
+    {
+        pdens[k] = &ghostdens[k];
+        pphi[k] = alias[k] ? &ghostphi[0] : &ghostphi[k];
+    }
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::step( const unsigned N)
+{
+    if( blue.isEnabled( TL_ETDRK))
+    {
+        for( unsigned s=0; s<N; s++)
+            step_etdrk();
+        return;
+    }
+    unsigned first = 0; //the steps after a change of the timestep are single steps
+    for( ; first < N && !karniadakis->equidistant(); first++)
+        step_current();
+    karniadakis->template invert_coeff<TL_ORDER3>();
+    const StepCoefficients c = step_coefficients<TL_ORDER3>();
+    if( polarisation) //the global solve needs all lines of cdens
+    {
+        for( unsigned s=first; s<N; s++)
+            step_( c);
+        return;
+    }
+    if( blue.isEnabled( TL_TASK_GRAPH))
+    {
+#pragma omp parallel
+#pragma omp single
+        for( unsigned s=first; s<N; s++)
+            step_tasks( c);
+        copy_aliased();
+        return;
+    }
+#pragma omp parallel
+    for( unsigned s=first; s<N; s++)
+        step_shared( c);
+    copy_aliased();
+}
+
+//one step called by all threads of a parallel region (the same as step_)
+template< size_t n>
+void DFT_DFT_Solver<n>::step_shared( const StepCoefficients& c)
+{
+    //the species are distributed like in the backtransform of the last step
+    //so no barrier is needed in between
+#pragma omp for schedule( static)
+    for( unsigned k=0; k<n; k++)
+    {
+        swap_fields( dens[k], ghostdens[k]); 
+        ghostdens[k].initGhostCells( );
+        if( alias[k]) continue;
+        swap_fields( phi[k], ghostphi[k]); 
+        ghostphi[k].initGhostCells(  );
+    }
+    //1. Compute nonlinearity and
+    //2. perform karniadakis step on each finished tile while it is in cache
+    std::array< const GhostMatrix<double, TL_DFT>*, n> pdens, pphi;
+    ghost_pointers( pdens, pphi);
+    arakawa.shared( pdens, pphi, nonlinear, [&]( size_t i_begin, size_t i_end)
+    {
+        for( unsigned k=0; k<n; k++)
+            karniadakis->step_i_combine( ghostdens[k], nonlinear[k], k, i_begin, i_end, c);
+    });
+#pragma omp single
+    {
+        for( unsigned k=0; k<n; k++)
+        {
+            swap_fields( dens[k], ghostdens[k]); 
+            if( !alias[k]) swap_fields( phi[k], ghostphi[k]); 
+        }
+        karniadakis->step_i_rotate( dens, nonlinear);
+    }
+    //3. solve linear equation
+    //3.1. transform v_hut
+#pragma omp for schedule( static)
+    for( unsigned k=0; k<n; k++)
+        dft_dft->r2c( dens[k], cdens[k]);
+    //3.2. perform karniadakis step and multiply coefficients for phi in one pass
+#pragma omp for schedule( static)
+    for( size_t i = 0; i < crows; i++)
+        spectral_update( i, i+1);
+    //3.3. backtransform
+#pragma omp for schedule( static) nowait
+    for( unsigned k=0; k<n; k++)
+    {
+        dft_dft->c2r( cdens[k], dens[k]);
+        if( !alias[k]) dft_dft->c2r( cphi[k],  phi[k]);
+    }
+}
+
+//generate the tasks of one step (called by one thread of a parallel region, 
+//the tasks are finished at the next barrier). The tasks of a species depend on 
+//each other through the sentinels of dens and phi, only the spectral update couples the species.
+//A task with inout dependence waits for all previous tasks with in dependence 
+//on the same sentinel, so the blocks of the nonlinearity and the spectral 
+//update run concurrently and empty tasks join them.
+//Consecutive calls chain the steps, i.e. the next step of species k
+//starts as soon as its fields are transformed back.
+template< size_t n>
+void DFT_DFT_Solver<n>::step_tasks( const StepCoefficients& c)
+{
+    const StepCoefficients sc( c); //the tasks are deferred
+    const size_t B = blocks;
+    char* D = &sentinel[0], *P = D + n, *X = P + n;
+    for( unsigned k=0; k<n; k++)
+    {
+#pragma omp task depend( inout: D[k], P[k])
+        {
+            swap_fields( dens[k], ghostdens[k]); 
+            ghostdens[k].initGhostCells( );
+            if( !alias[k])
+            {
+                swap_fields( phi[k], ghostphi[k]); 
+                ghostphi[k].initGhostCells(  );
+            }
+        }
+    }
+    //1. Compute nonlinearity and
+    //2. perform karniadakis step on each finished tile while it is in cache
+    for( unsigned k=0; k<n; k++)
+    {
+        const unsigned q = alias[k] ? 0 : k; //the potential of species k
+        for( size_t b=0; b<B; b++)
+        {
+#pragma omp task depend( in: D[k], P[q]) firstprivate( k, q, b, sc)
+            arakawa.lines( ghostdens[k], ghostphi[q], nonlinear[k], b*rows/B, (b+1)*rows/B, [&]( size_t i_begin, size_t i_end)
+            {
+                karniadakis->step_i_combine( ghostdens[k], nonlinear[k], k, i_begin, i_end, sc);
+            });
+        }
+    }
+    //3.1. transform v_hut as soon as all blocks of species k are finished
+    for( unsigned k=0; k<n; k++)
+    {
+#pragma omp task depend( inout: D[k]) depend( in: X[0])
+        {
+            swap_fields( dens[k], ghostdens[k]); 
+            karniadakis->step_i_rotate( dens[k], nonlinear[k], k);
+            dft_dft->r2c( dens[k], cdens[k]);
+        }
+    }
+    for( unsigned k=0; k<n; k++)
+        if( !alias[k]) 
+        {
+            //waits for all blocks reading ghostphi[k]
+#pragma omp task depend( inout: P[k])
+            swap_fields( phi[k], ghostphi[k]); 
+        }
+    karniadakis->step_i_advance();
+    //3.2. perform karniadakis step and multiply coefficients for phi in one pass
+#pragma omp task depend( inout: X[0])
+    {} //all species are transformed
+    for( size_t b=0; b<B; b++)
+    {
+#pragma omp task depend( in: X[0]) firstprivate( b)
+        spectral_update( b*crows/B, (b+1)*crows/B);
+    }
+#pragma omp task depend( inout: X[0])
+    {} //all lines are updated
+    //3.3. backtransform dens and phi independently
+    for( unsigned k=0; k<n; k++)
+    {
+#pragma omp task depend( in: X[0]) depend( inout: D[k])
+        dft_dft->c2r( cdens[k], dens[k]);
+        if( alias[k]) continue;
+#pragma omp task depend( in: X[0]) depend( inout: P[k])
+        dft_dft->c2r( cphi[k],  phi[k]);
+    }
+}
+
+template< size_t n>
+void DFT_DFT_Solver<n>::step_etdrk()
+{
+    auto no_tile = []( const std::vector< GhostMatrix<double, TL_DFT> >&, size_t, size_t){};
+    //1. Compute the nonlinearity of v^n (cphi serves as buffer) 
+    nonlinearity( no_tile);
+#pragma omp parallel for
+    for( unsigned k=0; k<n; k++)
+    {
+        dft_dft->r2c( nonlinear[k], cphi[k]);
+        dft_dft->r2c( dens[k], cdens[k]);
+    }
+    //2. Compute the stage and its potential
+    etdrk.predict( cdens, cphi);
+    compute_cphi();
+    global_potential();
+#pragma omp parallel for
+    for( unsigned k=0; k<n; k++)
+    {
+        dft_dft->c2r( cdens[k], dens[k]);
+        if( !alias[k]) dft_dft->c2r( cphi[k], phi[k]);
+    }
+    //3. Compute the nonlinearity of the stage and complete the step
+    nonlinearity( no_tile);
+#pragma omp parallel for
+    for( unsigned k=0; k<n; k++)
+        dft_dft->r2c( nonlinear[k], cphi[k]);
+    etdrk.correct( cdens, cphi);
+    compute_cphi();
+    global_potential();
+#pragma omp parallel for
+    for( unsigned k=0; k<n; k++)
+    {
+        dft_dft->c2r( cdens[k], dens[k]);
+        if( !alias[k]) dft_dft->c2r( cphi[k], phi[k]);
     }
+    copy_aliased();
 }
 
 
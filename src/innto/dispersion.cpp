@@ -0,0 +1,81 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+
+#include "spectral/spectral.h"
+#include "file/read_input.h"
+#include "blueprint.h"
+#include "dispersion.h"
+/*
+ * Computes the linear growth rates of an innto input file and
+ * scans them over the coupling d, the curvature kappa and the gradients g
+ * (kappa is scanned around the value of the second argument, 
+ *  default is the kappa of the input file)
+ */
+
+using namespace std;
+using namespace spectral;
+
+const double factors[] = { 0., 0.25, 0.5, 1., 2., 4.};
+
+template< size_t n>
+void scan( const Blueprint& bp, const double kappa)
+{
+    Timer t;
+    t.tic();
+    Dispersion<n> dispersion( bp);
+    t.toc();
+    typename Dispersion<n>::Mode mode = dispersion.fastest();
+    cout << "Fastest mode kx = "<<mode.kx<<" ky = "<<mode.ky<<" with gamma = "<<mode.gamma<<" omega = "<<mode.omega<<"\n";
+    cout << "Timestep estimate "<<dispersion.timestep()<<" (computed in "<<t.diff()*1000.<<"ms)\n";
+    const Physical p0 = bp.physical();
+    for( unsigned s=0; s<3; s++)
+    {
+        const char* name[3] = { "d", "kappa", "g"};
+        if( s == 1 && kappa == 0)
+        {
+            cout << "No kappa scan (kappa is zero, give one as second argument)\n";
+            continue;
+        }
+        cout << setw(10)<<name[s]<<setw(14)<<"gamma"<<setw(14)<<"omega"<<setw(12)<<"kx"<<setw(12)<<"ky"<<"\n";
+        t.tic();
+        for( unsigned f=0; f<sizeof( factors)/sizeof( double); f++)
+        {
+            Physical p( p0);
+            double value;
+            switch( s)
+            {
+                case( 0): value = p.d *= factors[f]; break;
+                case( 1): value = p.kappa = kappa*factors[f]; break;
+                default: //keeps the background neutral
+                    value = p.g_e *= factors[f], p.g[0] *= factors[f], p.g[1] *= factors[f];
+            }
+            dispersion.set_physical( p);
+            mode = dispersion.fastest();
+            cout << setw(10)<<value<<setw(14)<<mode.gamma<<setw(14)<<mode.omega<<setw(12)<<mode.kx<<setw(12)<<mode.ky<<"\n";
+        }
+        t.toc();
+        cout << "Scan took "<<t.diff()*1000.<<"ms\n";
+    }
+}
+
+int main( int argc, char* argv[])
+{
+    if( argc > 3)
+    {
+        cerr << "ERROR: Too many arguments!\nUsage: "<< argv[0]<<" [inputfile [kappa]]\n";
+        return -1;
+    }
+    const char* file = argc > 1 ? argv[1] : "input/default.in";
+    std::cout << "Reading from "<<file<<"\n";
+    std::vector<double> para;
+    try{ para = file::read_input( file); }
+    catch (Message& m) {  m.display(); return -1;}
+    const Blueprint bp( para);
+    const double kappa = argc > 2 ? atof( argv[2]) : bp.physical().kappa;
+    if( bp.isEnabled( TL_IMPURITY))
+        scan<3>( bp, kappa);
+    else
+        scan<2>( bp, kappa);
+    return 0;
+}
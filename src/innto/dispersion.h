@@ -0,0 +1,246 @@
+#ifndef _TL_DISPERSION_
+#define _TL_DISPERSION_
+
+#include <array>
+#include <complex>
+#include <cmath>
+#include <limits>
+
+#include "spectral/spectral.h"
+#include "blueprint.h"
+#include "equations.h"
+
+namespace spectral
+{
+///@addtogroup equations
+///@{
+/*! @brief Compute the eigenvalues of a 2x2 matrix
+ *
+ * @param m The matrix
+ * @param lambda Contains the eigenvalues on output
+ */
+inline void eigenvalues( const QuadMat< std::complex<double>, 2>& m, std::array< std::complex<double>, 2>& lambda)
+{
+    const std::complex<double> tr = m(0,0) + m(1,1), det = m(0,0)*m(1,1) - m(0,1)*m(1,0);
+    const std::complex<double> root = sqrt( tr*tr - 4.*det);
+    lambda[0] = 0.5*( tr + root);
+    lambda[1] = 0.5*( tr - root);
+}
+/*! @brief Compute the eigenvalues of a 3x3 matrix
+ *
+ * The roots of the characteristic polynomial are found by the
+ * Durand-Kerner iteration.
+ * @param m The matrix
+ * @param lambda Contains the eigenvalues on output
+ */
+inline void eigenvalues( const QuadMat< std::complex<double>, 3>& m, std::array< std::complex<double>, 3>& lambda)
+{
+    typedef std::complex<double> complex;
+    //z^3 + a z^2 + b z + c
+    const complex a = -( m(0,0) + m(1,1) + m(2,2));
+    const complex b = m(0,0)*m(1,1) - m(0,1)*m(1,0) + m(0,0)*m(2,2) - m(0,2)*m(2,0) + m(1,1)*m(2,2) - m(1,2)*m(2,1);
+    const complex c = -( m(0,0)*(m(1,1)*m(2,2)-m(2,1)*m(1,2))+m(0,1)*(m(1,2)*m(2,0)-m(1,0)*m(2,2))+m(0,2)*(m(1,0)*m(2,1)-m(2,0)*m(1,1)));
+    const double R = 1. + std::max( std::abs( a), std::max( std::abs( b), std::abs( c))); //bound of the roots
+    const complex seed( 0.4, 0.9);
+    lambda[0] = R*seed, lambda[1] = lambda[0]*seed, lambda[2] = lambda[1]*seed;
+    for( unsigned it=0; it<500; it++)
+    {
+        double change = 0;
+        for( unsigned k=0; k<3; k++)
+        {
+            const complex z = lambda[k];
+            complex denom = 1.;
+            for( unsigned q=0; q<3; q++)
+                if( q != k) denom *= z - lambda[q];
+            const complex dz = (( z + a)*z + b)*z + c;
+            if( denom == complex( 0)) //coinciding estimates
+                continue;
+            lambda[k] = z - dz/denom;
+            change = std::max( change, std::abs( lambda[k] - z));
+        }
+        if( change <= 1e-15*R)
+            break;
+    }
+}
+///@}
+
+/*! @brief The linear growth rates and frequencies of the spectral equations
+ *
+ * @ingroup equations
+ * The eigenvalues \f$ \lambda = \gamma - i\omega\f$ of the linear coefficients
+ * (cf. Equations) are computed for every mode of the grid of a blueprint,
+ * i.e. for the same modes and the same coefficients the solvers use.
+ * The fields are stored like the coefficients of the DFT_DFT_Solver, i.e.
+ * line i holds ky(i) in fft order and column j holds kx(j) >= 0. For
+ * non periodic boundaries line i holds ky(i) >= 0 and column j the
+ * x-mode j of the DRT_DFT_Solver.
+ * A change of the physical parameters takes a few milliseconds,
+ * so parameter scans do not need nonlinear runs.
+ * @tparam n The number of species (2 or 3)
+ */
+template< size_t n>
+class Dispersion
+{
+  public:
+    typedef std::complex<double> complex;
+    /*! @brief A mode and its fastest growing eigenvalue
+     */
+    struct Mode
+    {
+        double kx; //!< The wavenumber in x
+        double ky; //!< The wavenumber in y
+        double gamma; //!< The growth rate
+        double omega; //!< The frequency
+    };
+    /*! @brief Compute the growth rates of all modes of a blueprint
+     *
+     * @param bp Contains the grid, the boundary and the physical parameters
+     */
+    Dispersion( const Blueprint& bp);
+    /*! @brief Recompute the growth rates with new physical parameters
+     *
+     * @param phys The new parameters
+     */
+    void set_physical( const Physical& phys);
+    /*! @brief The growth rates of the fastest growing eigenvalue of every mode
+     *
+     * @return The growth rates
+     */
+    const Matrix< double>& growth_rate() const { return gamma;}
+    /*! @brief The frequencies of the fastest growing eigenvalue of every mode
+     *
+     * @return The frequencies
+     */
+    const Matrix< double>& frequency() const { return omega;}
+    /*! @brief The wavenumber of a column
+     *
+     * @param j The column index
+     * @return The wavenumber in x
+     */
+    double kx( const size_t j) const;
+    /*! @brief The wavenumber of a line
+     *
+     * @param i The line index
+     * @return The wavenumber in y
+     */
+    double ky( const size_t i) const;
+    /*! @brief The fastest growing mode
+     *
+     * The constant mode is excluded.
+     * @return The mode with the largest growth rate
+     */
+    Mode fastest() const;
+    /*! @brief Estimate the largest timestep the linear dynamics allow
+     *
+     * The Karniadakis scheme treats the linear part like the BDF3 method,
+     * which is stable for all eigenvalues in the sector \f$ |\arg(-\lambda)| < 86^\circ\f$.
+     * The other eigenvalues (growing or weakly damped oscillating modes) must be
+     * resolved, i.e. \f$ \Delta t = c/\max|\lambda|\f$ over these eigenvalues.
+     * @param c The safety factor
+     * @return The timestep (infinity if all eigenvalues lie in the sector)
+     */
+    double timestep( const double c = 0.5) const;
+  private:
+    void compute();
+    Blueprint blue;
+    const bool periodic;
+    const size_t rows, cols;
+    Matrix< double> gamma, omega;
+    double lambda_max; //largest |lambda| outside the stable sector
+};
+
+template< size_t n>
+Dispersion<n>::Dispersion( const Blueprint& bp):
+    blue( bp), periodic( bp.boundary().bc_x == TL_PERIODIC),
+    rows( periodic ? bp.algorithmic().ny : bp.algorithmic().ny/2+1),
+    cols( periodic ? bp.algorithmic().nx/2+1 : bp.algorithmic().nx),
+    gamma( rows, cols), omega( rows, cols), lambda_max( 0)
+{
+    compute();
+}
+
+template< size_t n>
+void Dispersion<n>::set_physical( const Physical& phys)
+{
+    blue.physical() = phys;
+    compute();
+}
+
+template< size_t n>
+double Dispersion<n>::kx( const size_t j) const
+{
+    const Boundary& bound = blue.boundary();
+    if( periodic)
+        return 2.*M_PI/bound.lx*(double)j;
+    const double add = ( bound.bc_x == TL_DST00 || bound.bc_x == TL_DST10) ? 1.0 : 0.5;
+    return M_PI/bound.lx*((double)j + add);
+}
+
+template< size_t n>
+double Dispersion<n>::ky( const size_t i) const
+{
+    const size_t ny = blue.algorithmic().ny;
+    const int ik = ( periodic && i > ny/2) ? (int)i - (int)ny : (int)i;
+    return 2.*M_PI/blue.boundary().ly*(double)ik;
+}
+
+//the coefficients are those of linear_coefficients of the solvers
+template< size_t n>
+void Dispersion<n>::compute()
+{
+    const Equations e( blue.physical(), blue.isEnabled( TL_MHW));
+    const size_t ny = blue.algorithmic().ny;
+    const double sector = tan( 86.*M_PI/180.);
+    double l_max = 0;
+#pragma omp parallel for reduction( max: l_max)
+    for( size_t i=0; i<rows; i++)
+    {
+        QuadMat< complex, n> c;
+        std::array< complex, n> lambda;
+        //the Nyquist line has no y-derivative
+        const double k_y = ( periodic && ny%2 == 0 && i == ny/2) ? 0. : ky( i);
+        for( size_t j=0; j<cols; j++)
+        {
+            e( c, -kx( j)*kx( j) - ky( i)*ky( i), complex( 0, k_y));
+            eigenvalues( c, lambda);
+            unsigned q_max = 0;
+            for( unsigned q=0; q<n; q++)
+            {
+                if( lambda[q].real() > lambda[q_max].real())
+                    q_max = q;
+                if( fabs( lambda[q].imag()) > -sector*lambda[q].real())
+                    l_max = std::max( l_max, std::abs( lambda[q]));
+            }
+            gamma(i,j) = lambda[q_max].real();
+            omega(i,j) = -lambda[q_max].imag();
+        }
+    }
+    lambda_max = l_max;
+}
+
+template< size_t n>
+typename Dispersion<n>::Mode Dispersion<n>::fastest() const
+{
+    Mode m{ 0, 0, -std::numeric_limits<double>::infinity(), 0};
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            if( periodic && i == 0 && j == 0)
+                continue;
+            if( gamma(i,j) > m.gamma)
+                m = Mode{ kx( j), ky( i), gamma(i,j), omega(i,j)};
+        }
+    return m;
+}
+
+template< size_t n>
+double Dispersion<n>::timestep( const double c) const
+{
+    if( lambda_max == 0)
+        return std::numeric_limits<double>::infinity();
+    return c/lambda_max;
+}
+
+} //namespace spectral
+
+#endif //_TL_DISPERSION_
@@ -0,0 +1,83 @@
+#include <iostream>
+#include "file/read_input.h"
+#include "dispersion.h"
+#include "dft_dft_solver.h"
+
+using namespace std;
+using namespace spectral;
+typedef std::complex<double> Complex;
+
+template< size_t n>
+double residual( const QuadMat< Complex, n>& m, const Complex lambda)
+{
+    QuadMat< Complex, n> a( m);
+    for( unsigned k=0; k<n; k++)
+        a(k,k) -= lambda;
+    if( n == 2)
+        return std::abs( a(0,0)*a(1,1) - a(0,1)*a(1,0));
+    return std::abs( a(0,0)*(a(1,1)*a(2,2)-a(2,1)*a(1,2))+a(0,1)*(a(1,2)*a(2,0)-a(1,0)*a(2,2))+a(0,2)*(a(1,0)*a(2,1)-a(2,0)*a(1,1)));
+}
+
+int main( int argc, char* argv[])
+{
+    cout << "Test whether the eigenvalues solve the characteristic equation...\n";
+    {
+        const Complex v[9] = { Complex( 1, 2), -3., 0.5, Complex( 0, 1), Complex( -2, 0.5), 1., 2., Complex( 0, -1), 4.};
+        QuadMat< Complex, 2> m2;
+        QuadMat< Complex, 3> m3;
+        for( unsigned k=0; k<2; k++)
+            for( unsigned q=0; q<2; q++)
+                m2(k,q) = v[2*k+q];
+        for( unsigned k=0; k<3; k++)
+            for( unsigned q=0; q<3; q++)
+                m3(k,q) = v[3*k+q];
+        std::array< Complex, 2> l2;
+        std::array< Complex, 3> l3;
+        eigenvalues( m2, l2), eigenvalues( m3, l3);
+        double res = 0;
+        for( unsigned k=0; k<2; k++) res = std::max( res, residual( m2, l2[k]));
+        for( unsigned k=0; k<3; k++) res = std::max( res, residual( m3, l3[k]));
+        cout << "Maximum residual "<<res<<"\n";
+        cout << ( res < 1e-12 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    vector<double> para;
+    try{ para = file::read_input( argc > 1 ? argv[1] : "input/default.in"); }
+    catch (Message& m) {  m.display(); return -1;}
+    Blueprint bp( para);
+    bp.algorithmic().nx = bp.algorithmic().ny = 32;
+    bp.algorithmic().h = bp.boundary().ly/32.;
+    const Algorithmic& alg = bp.algorithmic();
+    Dispersion<2> dispersion( bp);
+    Dispersion<2>::Mode mode = dispersion.fastest();
+    cout << "Fastest mode kx = "<<mode.kx<<" ky = "<<mode.ky<<" gamma = "<<mode.gamma<<" omega = "<<mode.omega<<"\n";
+    cout << "Timestep estimate "<<dispersion.timestep()<<"\n";
+    cout << "Test whether a small perturbation grows with the fastest growth rate...\n";
+    {
+        DFT_DFT_Solver<2> solver( bp);
+        Matrix< double, TL_DFT> ne( alg.ny, alg.nx, 0.), phi( ne);
+        for( size_t i=0; i<alg.ny; i++)
+            for( size_t j=0; j<alg.nx; j++)
+                ne(i,j) = 1e-8*cos( mode.kx*((double)j+0.5)*alg.h + mode.ky*((double)i+0.5)*alg.h);
+        std::array< Matrix< double, TL_DFT>, 2> arr{{ ne, phi}};
+        solver.init( arr, TL_IONS);
+        solver.first_step(), solver.second_step();
+        const unsigned N = (unsigned)( 4./mode.gamma/alg.dt); //4 e-foldings
+        auto amplitude = [&]()
+        {
+            double a = 0;
+            const Matrix< double, TL_DFT>& p = solver.getField( TL_POTENTIAL);
+            for( size_t i=0; i<alg.ny; i++)
+                for( size_t j=0; j<alg.nx; j++)
+                    a += p(i,j)*p(i,j);
+            return sqrt( a);
+        };
+        solver.step( N);
+        const double a0 = amplitude();
+        solver.step( N);
+        const double gamma = log( amplitude()/a0)/( N*alg.dt);
+        const double rel = fabs( gamma - mode.gamma)/mode.gamma;
+        cout << "Measured growth rate "<<gamma<<" (relative difference "<<rel<<")\n";
+        cout << ( rel < 1e-6 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    return 0;
+}
@@ -1,7 +1,10 @@
 #ifndef _DRT_DFT_SOLVER_
 #define _DRT_DFT_SOLVER_
 
+#include <algorithm>
 #include <complex>
+#include <vector>
+#include <memory>
 
 #include "spectral/spectral.h"
 #include "blueprint.h"
@@ -24,9 +27,13 @@ class DRT_DFT_Solver
      * and initializes all fourier coefficients as well as 
      * all low level solvers needed.  
      * @param blueprint Contains all the necessary parameters.
+     * @param shared A solver whose fourier plans are used if the grid and the 
+     *  x-boundary are the same and whose inverse coefficients are used if in 
+     *  addition the parameters are the same (cf. Karniadakis::share_coeff), 
+     *  e.g. the first member of an ensemble. Its coefficients are inverted now if necessary.
      * @throw Message If your parameters are inconsistent.
      */
-    DRT_DFT_Solver( const Blueprint& blueprint);
+    DRT_DFT_Solver( const Blueprint& blueprint, DRT_DFT_Solver* shared = NULL);
     /*! @brief Prepare Solver for execution
      *
      * This function takes the fields and computes the missing 
@@ -52,9 +59,74 @@ class DRT_DFT_Solver
     void second_step(); 
     /*! @brief Perform a step by the 3 step Karniadakis scheme
      *
+     * The step uses the current timestep, i.e. the last one chosen by 
+     * step( cfl, dt_max), and the variable timestep coefficients as long 
+     * as the last timesteps are not equidistant.
      * @attention At least one call of first_step() and second_step() is necessary
      * */
-    void step(){ step_<TL_ORDER3>();}
+    void step(){ 
+        if( blue.isEnabled( TL_ETDRK)) 
+            step_etdrk();
+        else
+            step_current();
+    }
+    /*! @brief Perform a step with a CFL controlled timestep
+     *
+     * The timestep is chosen from the maximum ExB velocity v of the current 
+     * potential such that v*dt/h < cfl. To avoid frequent inversions of the 
+     * linear coefficients the timestep is only changed if the 
+     * condition is violated or if a timestep larger by more than (1+threshold)^2 
+     * is allowed. The new timestep is then dt_cfl/(1+threshold) (but at most 1.5 times 
+     * the old timestep and dt_max). A timestep larger than dt_max is always changed. The steps following a change use the 
+     * variable timestep coefficients of the Karniadakis scheme.
+     * @param cfl The maximum Courant number 
+     * @param dt_max The maximum timestep
+     * @param threshold The relative change of the timestep that triggers a change
+     * @return The timestep of this step
+     * @note The calls may be mixed with step() and step( N), which keep the current timestep.
+     * @attention Enable TL_ADAPTIVE_DT (or TL_MATRIX_FREE) in the Blueprint. At least one call of first_step() and second_step() is necessary
+     */
+    double step( const double cfl, const double dt_max, const double threshold = 0.2);
+    /*! @brief Perform N steps by the 3 step Karniadakis scheme
+     *
+     * Equals N calls of step() but all steps are computed by one 
+     * team of threads, i.e. the parallel region is opened only once 
+     * and the phases of a step are separated by barriers instead of 
+     * the fork and join of a new parallel region. Call this function 
+     * with the number of steps between two outputs.
+     * If TL_TASK_GRAPH is enabled the N steps are one graph of tasks, i.e.
+     * a step can start with the species whose fields of the last step are finished.
+     * @param N the number of steps
+     * @attention At least one call of first_step() and second_step() is necessary
+     */
+    void step( const unsigned N);
+    /*! @brief Write the complete state of the solver in binary form
+     *
+     * The densities, the potentials, the history of the Karniadakis scheme, 
+     * the time and the hash of the blueprint are written.
+     * @param os The (binary) outstream
+     * @param time The time of the current fields
+     * @attention At least one call of first_step() and second_step() is necessary
+     */
+    void checkpoint( std::ostream& os, const double time) const;
+    /*! @brief Restore the state written by checkpoint
+     *
+     * Replaces init(), first_step() and second_step(), i.e. the next step()
+     * continues with the third order scheme as if the run was not interrupted.
+     * @param is The (binary) instream
+     * @return The time of the restored fields
+     * @throw Message If the checkpoint belongs to a different blueprint 
+     *  or was written before second_step() (the history is incomplete then)
+     */
+    double restart( std::istream& is);
+    /*! @brief Change the physical parameters of a running solver
+     *
+     * Recomputes the coefficients and the potentials of the current densities
+     * but keeps the fields, the history and the plans (cf. DFT_DFT_Solver::set_physical).
+     * @param phys The new physical parameters
+     * @throw Message If the new parameters are inconsistent (the solver is unchanged then)
+     */
+    void set_physical( const Physical& phys);
     /*! @brief Get the result
         
         You get the solution matrix of the current timestep.
@@ -82,37 +154,55 @@ class DRT_DFT_Solver
     /*! @brief Get the parameters of the solver.
 
         @return The parameters in use. 
-        @note You cannot change parameters once constructed.
+        @note Only the physical parameters can be changed (cf. set_physical).
      */
     const Blueprint& blueprint() const { return blue;}
   private:
     typedef std::complex<double> complex;
     //methods
-    void init_coefficients( const Boundary& bound, const Physical& phys);
+    void init_coefficients( const Boundary& bound, const Physical& phys, const bool update = false, Karniadakis<n, complex, TL_DRT_DFT>* tables = NULL);
+    void linear_coefficients( const size_t i, QuadMat< complex, n>* line) const;
     void compute_cphi();//multiply cphi
+    void compute_cphi( const size_t i_begin, const size_t i_end);//multiply cphi in some lines (serial)
+    void spectral_update( const size_t i_begin, const size_t i_end);//step_ii and cphi in some lines (serial)
     //void first_steps(); 
+    double max_velocity() const;
     template< enum stepper S>
-    void step_();
+    void step_(){ step_( step_coefficients<S>());}
+    void step_( const StepCoefficients& c);
+    void step_current();//third order step with the current timestep
+    void step_shared( const StepCoefficients& c);
+    void step_tasks( const StepCoefficients& c);
+    void ghost_pointers( std::array< const GhostMatrix<double, TL_DRT_DFT>*, n>& pdens, std::array< const GhostMatrix<double, TL_DRT_DFT>*, n>& pphi) const;
+    void step_etdrk();
+    template< class Tile>
+    void nonlinearity( const Tile& tile);
     //members
     const size_t rows, cols;
     const size_t crows, ccols;
-    const Blueprint blue;
+    Blueprint blue;
     /////////////////fields//////////////////////////////////
-    //GhostMatrix<double, TL_DRT_DFT> ghostdens, ghostphi;
+    std::vector< GhostMatrix<double, TL_DRT_DFT> > ghostdens, ghostphi; //void, hold dens and phi during the nonlinearity
     std::array< Matrix<double, TL_DRT_DFT>, n> dens, phi, nonlinear;
     /////////////////Complex (void) Matrices for fourier transforms///////////
     std::array< Matrix< complex>, n> cdens, cphi;
     ///////////////////Solvers////////////////////////
     Arakawa arakawa;
-    Karniadakis<n, complex, TL_DRT_DFT> karniadakis;
-    DRT_DFT drt_dft;
+    std::unique_ptr< Karniadakis<n, complex, TL_DRT_DFT> > karniadakis; //the multistep scheme (null if ETDRK)
+    ETDRK<n, complex> etdrk;
+    std::shared_ptr< DRT_DFT> drt_dft; //the plans (shared with the solvers of the same grid)
     /////////////////////Coefficients//////////////////////
     Matrix< std::array< double, n> > phi_coeff;
     std::array< Matrix< double>, n-1> gamma_coeff;
+    std::array< bool, n> alias; //the gyro-average of species k is trivial, i.e. phi[k] equals phi[0] and is not computed
+    std::unique_ptr< const Equations> equations; //the linear part of the current parameters (for linear_coefficients)
+    /////////////////////Task graph//////////////////////
+    const size_t blocks; //number of line blocks of the nonlinearity and the spectral update
+    std::vector< char> sentinel; //dependencies of the tasks: dens and phi of every species and the coupling
 };
 
 template< size_t n>
-DRT_DFT_Solver<n>::DRT_DFT_Solver( const Blueprint& bp):
+DRT_DFT_Solver<n>::DRT_DFT_Solver( const Blueprint& bp, DRT_DFT_Solver* shared):
     rows( bp.algorithmic().ny ), cols( bp.algorithmic().nx ),
     crows( cols), ccols( rows/2+1),
     blue( bp),
@@ -123,29 +213,41 @@ DRT_DFT_Solver<n>::DRT_DFT_Solver( const Blueprint& bp):
     cphi(cdens), 
     //Solvers
     arakawa( bp.algorithmic().h),
-    karniadakis(rows, cols, crows, ccols, bp.algorithmic().dt),
-    drt_dft( rows, cols, fftw_convert( bp.boundary().bc_x), FFTW_MEASURE),
+    etdrk( crows, ccols, bp.algorithmic().dt),
+    drt_dft( shared != NULL && shared->rows == rows && shared->cols == cols && shared->blue.boundary().bc_x == bp.boundary().bc_x ? 
+             shared->drt_dft : std::shared_ptr< DRT_DFT>( new DRT_DFT( rows, cols, fftw_convert( bp.boundary().bc_x), FFTW_MEASURE))),
     //Coefficients
     phi_coeff( crows, ccols),
-    gamma_coeff( MatrixArray< double, TL_NONE, n-1>::construct( crows, ccols))
+    gamma_coeff( MatrixArray< double, TL_NONE, n-1>::construct( crows, ccols)),
+    blocks( std::max( 1, std::min( (int)std::min( rows, crows)/8, 4*omp_get_max_threads()))),
+    sentinel( n + n + 1)
 {
     bp.consistencyCheck();
+    ghostdens.reserve( n), ghostphi.reserve( n);
+    for( unsigned k=0; k<n; k++)
+    {
+        ghostdens.emplace_back( rows, cols, TL_PERIODIC, blue.boundary().bc_x, TL_VOID);
+        ghostphi.emplace_back(  rows, cols, TL_PERIODIC, blue.boundary().bc_x, TL_VOID);
+    }
     Physical phys = bp.physical();
     if( bp.isEnabled( TL_GLOBAL))
     {
         std::cerr << "WARNING: GLOBAL solver not implemented yet! \n\
              Switch to local solver...\n";
     }
-    init_coefficients( bp.boundary(), phys);
+    if( !bp.isEnabled( TL_ETDRK)) //ETDRK needs neither the history nor the inverse tables
+        karniadakis.reset( new Karniadakis<n, complex, TL_DRT_DFT>( rows, cols, crows, ccols, bp.algorithmic().dt, TL_GENERAL, bp.isEnabled( TL_FLOAT_HISTORY) ? TL_FLOAT : TL_DOUBLE));
+    const bool share = shared != NULL && karniadakis && shared->karniadakis && !bp.isEnabled( TL_MATRIX_FREE)
+                    && shared->blue.hash() == bp.hash() && shared->blue.isEnabled( TL_ADAPTIVE_DT) == bp.isEnabled( TL_ADAPTIVE_DT);
+    init_coefficients( bp.boundary(), phys, false, share ? shared->karniadakis.get() : NULL);
 }
 
 //aware of BC
+//tables: a scheme with the same coefficients (they are shared instead of computed)
 template< size_t n>
-void DRT_DFT_Solver<n>::init_coefficients( const Boundary& bound, const Physical& phys)
+void DRT_DFT_Solver<n>::init_coefficients( const Boundary& bound, const Physical& phys, const bool update, Karniadakis<n, complex, TL_DRT_DFT>* tables)
 {
-    Matrix< QuadMat< complex, n> > coeff( crows, ccols);
-    double laplace;
-    const complex dymin( 0, 2.*M_PI/bound.ly);
+    equations.reset( new Equations( phys, blue.isEnabled( TL_MHW)));
     const double kxmin2 = M_PI*M_PI/(double)(bound.lx*bound.lx),
                  kymin2 = 4.*M_PI*M_PI/(double)(bound.ly*bound.ly);
     double add;
@@ -154,13 +256,13 @@ void DRT_DFT_Solver<n>::init_coefficients( const Boundary& bound, const Physical
     else
         add = 0.5;
 
-    Equations e( phys, blue.isEnabled( TL_MHW));
-    Poisson p( phys);
+    const Poisson p( phys);
     // drt_dft is transposing so i is the x index 
+#pragma omp parallel for
     for( unsigned i = 0; i<crows; i++)
         for( unsigned j = 0; j<ccols; j++)
         {
-            laplace = - kxmin2*(double)((i+add)*(i+add)) - kymin2*(double)(j*j);
+            const double laplace = - kxmin2*(double)((i+add)*(i+add)) - kymin2*(double)(j*j);
             if( n == 2)
                 gamma_coeff[0](i,j) = p.gamma1_i( laplace);
             else if( n == 3)
@@ -168,11 +270,80 @@ void DRT_DFT_Solver<n>::init_coefficients( const Boundary& bound, const Physical
                 gamma_coeff[0](i,j) = p.gamma1_i( laplace);
                 gamma_coeff[1](i,j) = p.gamma1_z( laplace);
             }
-            e( coeff( i,j), laplace, (double)j*dymin);
             p( phi_coeff(i,j), laplace);  
         }
+    //detect the trivial gyro-averages
+    alias[0] = false;
+    for( unsigned k=1; k<n; k++)
+    {
+        alias[k] = true;
+        for( size_t i = 0; i < crows; i++)
+            for( size_t j = 0; j < ccols; j++)
+                if( gamma_coeff[k-1](i,j) != 1.)
+                    alias[k] = false;
+    }
     double norm = fftw_normalisation( bound.bc_x, cols)*(double)rows;
-    karniadakis.init_coeff( coeff, norm);
+    if( blue.isEnabled( TL_MATRIX_FREE) && !blue.isEnabled( TL_ETDRK)) //ETDRK always stores its exponentials
+    {
+        if( !update) karniadakis->init_coeff( norm);
+        return;
+    }
+    if( tables != NULL)
+    {
+        karniadakis->share_coeff( *tables);
+        return;
+    }
+    Matrix< QuadMat< complex, n> > coeff( crows, ccols);
+#pragma omp parallel for
+    for( unsigned i = 0; i<crows; i++)
+        linear_coefficients( i, &coeff( i,0));
+    if( blue.isEnabled( TL_ETDRK))
+    {
+        etdrk.init_coeff( coeff, norm);
+        return;
+    }
+    if( update)
+        karniadakis->update_coeff( coeff);
+    else
+        karniadakis->init_coeff( coeff, norm, blue.isEnabled( TL_ADAPTIVE_DT));
+}
+
+template< size_t n>
+void DRT_DFT_Solver<n>::set_physical( const Physical& phys)
+{
+    Blueprint bp( blue);
+    bp.physical() = phys;
+    bp.consistencyCheck();
+    blue = bp;
+    init_coefficients( blue.boundary(), blue.physical(), true);
+    //compute the potentials of the current densities with the new coefficients
+    const double norm = fftw_normalisation( blue.boundary().bc_x, cols)*(double)rows;
+#pragma omp parallel for 
+    for( unsigned k=0; k<n; k++)
+    {
+        nonlinear[k] = dens[k]; //the densities are kept
+        drt_dft->r2c_T( nonlinear[k], cdens[k]);
+        for( size_t i = 0; i < crows; i++)
+            for( size_t j = 0; j < ccols; j++)
+                cdens[k](i,j) /= norm;
+    }
+    compute_cphi();
+#pragma omp parallel for 
+    for( unsigned k=0; k<n; k++)
+        if( !alias[k]) drt_dft->c_T2r( cphi[k], phi[k]);
+}
+
+template< size_t n>
+void DRT_DFT_Solver<n>::linear_coefficients( const size_t i, QuadMat< complex, n>* line) const
+{
+    const Boundary& bound = blue.boundary();
+    const complex dymin( 0, 2.*M_PI/bound.ly);
+    const double kxmin2 = M_PI*M_PI/(double)(bound.lx*bound.lx),
+                 kymin2 = 4.*M_PI*M_PI/(double)(bound.ly*bound.ly);
+    const double add = ( bound.bc_x == TL_DST00 || bound.bc_x == TL_DST10) ? 1.0 : 0.5;
+    const Equations& e = *equations;
+    for( unsigned j = 0; j<ccols; j++)
+        e( line[j], - kxmin2*(double)((i+add)*(i+add)) - kymin2*(double)(j*j), (double)j*dymin);
 }
 //unaware of BC except FFT 
 template< size_t n>
@@ -185,14 +356,10 @@ void DRT_DFT_Solver<n>::init( std::array< Matrix<double, TL_DRT_DFT>,n>& v, enum
         if( v[k].isVoid())
             throw Message("You gave me a void Matrix!!", _ping_);
 #endif
-        drt_dft.r2c_T( v[k], cdens[k]);
+        drt_dft->r2c_T( v[k], cdens[k]);
     }
-    //don't forget to normalize coefficients!!
-    double norm = fftw_normalisation( blue.boundary().bc_x, cols)*(double)rows;
-    for( unsigned k=0; k<n; k++)
-        for( unsigned i=0; i<crows; i++)
-            for( unsigned j=0; j<ccols;j++)
-                cdens[k](i,j) /= norm;
+    //don't forget to normalize coefficients!! (done with the rest cphi[k])
+    const double norm = fftw_normalisation( blue.boundary().bc_x, cols)*(double)rows;
     switch( t) //which field must be computed?
     {
         case( TL_ELECTRONS): 
@@ -250,16 +417,22 @@ void DRT_DFT_Solver<n>::init( std::array< Matrix<double, TL_DRT_DFT>,n>& v, enum
         case( TL_ALL):
             throw Message( "TL_ALL not treated yet!", _ping_);
     }
-    //compute the rest cphi[k]
-    for( unsigned k=0; k<n-1; k++)
-        for( size_t i = 0; i < crows; i++)
-            for( size_t j = 0; j < ccols; j++)
-                cphi[k+1](i,j) = gamma_coeff[k](i,j)*cphi[0](i,j);
+    //normalize and compute the rest cphi[k] in one pass (all equations are linear)
+    for( size_t i = 0; i < crows; i++)
+        for( size_t j = 0; j < ccols; j++)
+        {
+            for( unsigned k=0; k<n; k++)
+                cdens[k](i,j) /= norm;
+            cphi[0](i,j) /= norm;
+            for( unsigned k=0; k<n-1; k++)
+                if( !alias[k+1])
+                    cphi[k+1](i,j) = gamma_coeff[k](i,j)*cphi[0](i,j);
+        }
     //backtransform to x-space
     for( unsigned k=0; k<n; k++)
     {
-        drt_dft.c_T2r( cdens[k], dens[k]);
-        drt_dft.c_T2r( cphi[k], phi[k]);
+        drt_dft->c_T2r( cdens[k], dens[k]);
+        if( !alias[k]) drt_dft->c_T2r( cphi[k], phi[k]);
     }
     //now the density and the potential is given in x-space
     //first_steps();
@@ -299,86 +472,420 @@ const Matrix<double, TL_DRT_DFT>& DRT_DFT_Solver<n>::getField( enum target t) co
 template< size_t n>
 void DRT_DFT_Solver<n>::first_step()
 {
-    karniadakis.template invert_coeff<TL_EULER>( );
+    if( blue.isEnabled( TL_ETDRK))
+    {
+        step_etdrk();
+        return;
+    }
+    karniadakis->template invert_coeff<TL_EULER>( );
     step_<TL_EULER>();
 }
 
 template< size_t n>
 void DRT_DFT_Solver<n>::second_step()
 {
-    karniadakis.template invert_coeff<TL_ORDER2>();
+    if( blue.isEnabled( TL_ETDRK))
+    {
+        step_etdrk();
+        return;
+    }
+    karniadakis->template invert_coeff<TL_ORDER2>();
     step_<TL_ORDER2>();
-    karniadakis.template invert_coeff<TL_ORDER3>();
+    karniadakis->template invert_coeff<TL_ORDER3>();
+}
+
+template< size_t n>
+void DRT_DFT_Solver<n>::checkpoint( std::ostream& os, const double time) const
+{
+    write_binary( os, blue.hash());
+    write_binary( os, time);
+    for( unsigned k=0; k<n; k++)
+    {
+        write_binary( os, dens[k]);
+        write_binary( os, phi[k]);
+    }
+    if( !blue.isEnabled( TL_ETDRK)) //the ETDRK scheme has no history
+        karniadakis->write( os);
+}
+
+template< size_t n>
+double DRT_DFT_Solver<n>::restart( std::istream& is)
+{
+    unsigned long long hash;
+    double time;
+    read_binary( is, hash);
+    if( hash != blue.hash())
+        throw Message( "Checkpoint belongs to different parameters!", _ping_);
+    read_binary( is, time);
+    for( unsigned k=0; k<n; k++)
+    {
+        read_binary( is, dens[k]);
+        read_binary( is, phi[k]);
+    }
+    if( !blue.isEnabled( TL_ETDRK))
+    {
+        karniadakis->read( is);
+        if( karniadakis->levels() < 2)
+            throw Message( "Checkpoint was written before second_step()!", _ping_);
+        karniadakis->template invert_coeff<TL_ORDER3>();
+    }
+    return time;
 }
 
 template< size_t n>
 void DRT_DFT_Solver<n>::compute_cphi()
 {
-    if( n==2)
+#pragma omp parallel for 
+    for( size_t i = 0; i < crows; i++)
+        compute_cphi( i, i+1);
+}
+
+template< size_t n>
+void DRT_DFT_Solver<n>::compute_cphi( const size_t i_begin, const size_t i_end)
+{
+    for( size_t i = i_begin; i < i_end; i++)
+        for( size_t j = 0; j < ccols; j++)
+        {
+            cphi[0](i,j) = phi_coeff(i,j)[0]*cdens[0](i,j);
+            for( unsigned k=1; k<n; k++)
+                cphi[0](i,j) += phi_coeff(i,j)[k]*cdens[k](i,j);
+            for( unsigned k=0; k<n-1; k++)
+                if( !alias[k+1])
+                    cphi[k+1](i,j) = gamma_coeff[k](i,j)*cphi[0](i,j);
+        }
+}
+
+//the spectral part of a karniadakis step linewise, i.e. each line of cdens 
+//is multiplied by the (normalized) inverse coefficients and the potentials 
+//are computed from it while it is still in cache
+template< size_t n>
+void DRT_DFT_Solver<n>::spectral_update( const size_t i_begin, const size_t i_end)
+{
+    for( size_t i = i_begin; i < i_end; i++)
     {
-#pragma omp parallel for
-        for( size_t i = 0; i < crows; i++)
-            for( size_t j = 0; j < ccols; j++)
-                cphi[0](i,j) = phi_coeff(i,j)[0]*cdens[0](i,j) 
-                             + phi_coeff(i,j)[1]*cdens[1](i,j);
-#pragma omp parallel for
-        for( size_t i = 0; i < crows; i++)
-            for( size_t j = 0; j < ccols; j++)
-                cphi[1](i,j) = gamma_coeff[0](i,j)*cphi[0](i,j);
+        if( blue.isEnabled( TL_MATRIX_FREE))
+            karniadakis->step_ii( cdens, [this]( size_t l, QuadMat< complex, n>* line){ linear_coefficients( l, line);}, i, i+1);
+        else
+            karniadakis->step_ii( cdens, i, i+1);
+        compute_cphi( i, i+1);
+    }
+}
+
+//max( |dy phi| + |dx phi|) of the electric potential
+template< size_t n>
+double DRT_DFT_Solver<n>::max_velocity() const
+{
+    const Matrix_Type& p = phi[0];
+    double v = 0;
+#pragma omp parallel for reduction( max: v)
+    for( size_t i = 0; i < rows; i++)
+    {
+        const size_t ip = (i+1)%rows, im = (i+rows-1)%rows;
+        for( size_t j = 0; j < cols; j++)
+        {
+            //one-sided at the x boundaries
+            const size_t jp = std::min( j+1, cols-1), jm = ( j == 0) ? 0 : j-1;
+            v = std::max( v, fabs( p( ip, j) - p( im, j)) + fabs( p( i, jp) - p( i, jm))*2./(double)(jp - jm));
+        }
+    }
+    return v/2./blue.algorithmic().h;
+}
+
+template< size_t n>
+double DRT_DFT_Solver<n>::step( const double cfl, const double dt_max, const double threshold)
+{
+    if( !blue.isEnabled( TL_ADAPTIVE_DT) && !blue.isEnabled( TL_MATRIX_FREE))
+        throw Message( "Enable adaptive timesteps in the blueprint first!", _ping_);
+    if( blue.isEnabled( TL_ETDRK))
+        throw Message( "Adaptive timesteps are not implemented for the ETDRK scheme!", _ping_);
+    const double dt = karniadakis->timestep();
+    const double v = max_velocity();
+    const double dt_cfl = ( v > 0) ? cfl*blue.algorithmic().h/v : dt_max;
+    if( dt > dt_cfl || dt > dt_max || dt*(1.+threshold)*(1.+threshold) < std::min( dt_cfl, dt_max))
+        karniadakis->set_timestep( std::min( std::min( dt_cfl/(1.+threshold), 1.5*dt), dt_max));
+    step_current();
+    return karniadakis->timestep();
+}
+
+//the fixed coefficients are only valid for equidistant timesteps
+template< size_t n>
+void DRT_DFT_Solver<n>::step_current()
+{
+    if( karniadakis->equidistant())
+    {
+        karniadakis->template invert_coeff<TL_ORDER3>();
+        step_<TL_ORDER3>();
+    }
+    else
+    {
+        const StepCoefficients c = karniadakis->variable_coefficients();
+        karniadakis->invert_coeff( c.gamma_0);
+        step_( c);
+    }
+}
+
+//compute the nonlinearity and call tile( ghostdens, i_begin, i_end) after each finished tile
+template< size_t n>
+template< class Tile>
+void DRT_DFT_Solver<n>::nonlinearity( const Tile& tile)
+{
+    std::array< const GhostMatrix<double, TL_DRT_DFT>*, n> pdens, pphi;
+#pragma omp parallel for 
+    for( unsigned k=0; k<n; k++)
+    {
+        swap_fields( dens[k], ghostdens[k]); //now dens[k] is void
+        ghostdens[k].initGhostCells( );
+        if( alias[k]) continue; //shares the ghostcells of phi[0]
+        swap_fields( phi[k], ghostphi[k]); //now phi[k] is void
+        ghostphi[k].initGhostCells(  );
+    }
+    ghost_pointers( pdens, pphi);
+    arakawa( pdens, pphi, nonlinear, [&]( size_t i_begin, size_t i_end){ tile( ghostdens, i_begin, i_end);});
+    for( unsigned k=0; k<n; k++)
+    {
+        swap_fields( dens[k], ghostdens[k]); //now ghostdens is void
+        if( !alias[k]) swap_fields( phi[k], ghostphi[k]); //now ghostphi is void
     }
-    else if( n==3)
+}
+
+template< size_t n>
+void DRT_DFT_Solver<n>::step_( const StepCoefficients& c)
+{
+    if( blue.isEnabled( TL_TASK_GRAPH))
     {
+#pragma omp parallel
+#pragma omp single
+        step_tasks( c);
+        return;
+    }
+    //1. Compute nonlinearity and
+    //2. perform karniadakis step on each finished tile while it is in cache
+    nonlinearity( [&]( const std::vector< GhostMatrix<double, TL_DRT_DFT> >& ghostdens, size_t i_begin, size_t i_end)
+    {
+        for( unsigned k=0; k<n; k++)
+            karniadakis->step_i_combine( ghostdens[k], nonlinear[k], k, i_begin, i_end, c);
+    });
+    karniadakis->step_i_rotate( dens, nonlinear);
+    //3. solve linear equation
+    //3.1. transform v_hut
 #pragma omp parallel for
-        for( size_t i = 0; i < crows; i++)
-            for( size_t j = 0; j < ccols; j++)
-                cphi[0](i,j) = phi_coeff(i,j)[0]*cdens[0](i,j) 
-                             + phi_coeff(i,j)[1]*cdens[1](i,j) 
-                             + phi_coeff(i,j)[2]*cdens[2](i,j);
+    for( unsigned k=0; k<n; k++)
+        drt_dft->r2c_T( dens[k], cdens[k]);
+    //3.2. perform karniadakis step and multiply coefficients for phi in one pass
+#pragma omp parallel for schedule( static)
+    for( size_t i = 0; i < crows; i++)
+        spectral_update( i, i+1);
+    //3.3. backtransform
 #pragma omp parallel for
-        for( size_t i = 0; i < crows; i++)
-            for( size_t j = 0; j < ccols; j++)
-            {
-                cphi[1](i,j) = gamma_coeff[0](i,j)*cphi[0](i,j);
-                cphi[2](i,j) = gamma_coeff[1](i,j)*cphi[0](i,j);
-            }
+    for( unsigned k=0; k<n; k++)
+    {
+        drt_dft->c_T2r( cdens[k], dens[k]);
+        if( !alias[k]) drt_dft->c_T2r( cphi[k],  phi[k]);
     }
 }
 
-//unaware of BC except FFT
+//species with trivial gyro-average (e.g. tau = 0) share the electron potential 
 template< size_t n>
-template< enum stepper S>
-void DRT_DFT_Solver<n>::step_()
+void DRT_DFT_Solver<n>::ghost_pointers( std::array< const GhostMatrix<double, TL_DRT_DFT>*, n>& pdens, std::array< const GhostMatrix<double, TL_DRT_DFT>*, n>& pphi) const
 {
-    //1. Compute nonlinearity
-#pragma omp parallel for 
     for( unsigned k=0; k<n; k++)
     {
-        GhostMatrix<double, TL_DRT_DFT> ghostphi{ rows, cols, TL_PERIODIC, blue.boundary().bc_x};
-        GhostMatrix<double, TL_DRT_DFT> ghostdens{ rows, cols, TL_PERIODIC, blue.boundary().bc_x};
-        swap_fields( dens[k], ghostdens); //now dens[j] is void
-        swap_fields( phi[k], ghostphi); //now phi[j] is void
-        ghostdens.initGhostCells( );
-        ghostphi.initGhostCells(  );
-        arakawa( ghostdens, ghostphi, nonlinear[k]);
-        swap_fields( dens[k], ghostdens); //now ghostdens is void
-        swap_fields( phi[k], ghostphi); //now ghostphi is void
-    }
-    //2. perform karniadakis step
-    karniadakis.template step_i<S>( dens, nonlinear);
+        pdens[k] = &ghostdens[k];
+        pphi[k] = alias[k] ? &ghostphi[0] : &ghostphi[k];
+    }
+}
+
+template< size_t n>
+void DRT_DFT_Solver<n>::step( const unsigned N)
+{
+    if( blue.isEnabled( TL_ETDRK))
+    {
+        for( unsigned s=0; s<N; s++)
+            step_etdrk();
+        return;
+    }
+    unsigned first = 0; //the steps after a change of the timestep are single steps
+    for( ; first < N && !karniadakis->equidistant(); first++)
+        step_current();
+    karniadakis->template invert_coeff<TL_ORDER3>();
+    const StepCoefficients c = step_coefficients<TL_ORDER3>();
+    if( blue.isEnabled( TL_TASK_GRAPH))
+    {
+#pragma omp parallel
+#pragma omp single
+        for( unsigned s=first; s<N; s++)
+            step_tasks( c);
+        return;
+    }
+#pragma omp parallel
+    for( unsigned s=first; s<N; s++)
+        step_shared( c);
+}
+
+//one step called by all threads of a parallel region (the same as step_)
+template< size_t n>
+void DRT_DFT_Solver<n>::step_shared( const StepCoefficients& c)
+{
+    //the species are distributed like in the backtransform of the last step
+    //so no barrier is needed in between
+#pragma omp for schedule( static)
+    for( unsigned k=0; k<n; k++)
+    {
+        swap_fields( dens[k], ghostdens[k]); 
+        ghostdens[k].initGhostCells( );
+        if( alias[k]) continue;
+        swap_fields( phi[k], ghostphi[k]); 
+        ghostphi[k].initGhostCells(  );
+    }
+    //1. Compute nonlinearity and
+    //2. perform karniadakis step on each finished tile while it is in cache
+    std::array< const GhostMatrix<double, TL_DRT_DFT>*, n> pdens, pphi;
+    ghost_pointers( pdens, pphi);
+    arakawa.shared( pdens, pphi, nonlinear, [&]( size_t i_begin, size_t i_end)
+    {
+        for( unsigned k=0; k<n; k++)
+            karniadakis->step_i_combine( ghostdens[k], nonlinear[k], k, i_begin, i_end, c);
+    });
+#pragma omp single
+    {
+        for( unsigned k=0; k<n; k++)
+        {
+            swap_fields( dens[k], ghostdens[k]); 
+            if( !alias[k]) swap_fields( phi[k], ghostphi[k]); 
+        }
+        karniadakis->step_i_rotate( dens, nonlinear);
+    }
     //3. solve linear equation
     //3.1. transform v_hut
+#pragma omp for schedule( static)
+    for( unsigned k=0; k<n; k++)
+        drt_dft->r2c_T( dens[k], cdens[k]);
+    //3.2. perform karniadakis step and multiply coefficients for phi in one pass
+#pragma omp for schedule( static)
+    for( size_t i = 0; i < crows; i++)
+        spectral_update( i, i+1);
+    //3.3. backtransform
+#pragma omp for schedule( static) nowait
+    for( unsigned k=0; k<n; k++)
+    {
+        drt_dft->c_T2r( cdens[k], dens[k]);
+        if( !alias[k]) drt_dft->c_T2r( cphi[k],  phi[k]);
+    }
+}
+
+//generate the tasks of one step (called by one thread of a parallel region, 
+//the tasks are finished at the next barrier). The tasks of a species depend on 
+//each other through the sentinels of dens and phi, only the spectral update couples the species.
+//A task with inout dependence waits for all previous tasks with in dependence 
+//on the same sentinel, so the blocks of the nonlinearity and the spectral 
+//update run concurrently and empty tasks join them.
+//Consecutive calls chain the steps, i.e. the next step of species k
+//starts as soon as its fields are transformed back.
+template< size_t n>
+void DRT_DFT_Solver<n>::step_tasks( const StepCoefficients& c)
+{
+    const StepCoefficients sc( c); //the tasks are deferred
+    const size_t B = blocks;
+    char* D = &sentinel[0], *P = D + n, *X = P + n;
+    for( unsigned k=0; k<n; k++)
+    {
+#pragma omp task depend( inout: D[k], P[k])
+        {
+            swap_fields( dens[k], ghostdens[k]); 
+            ghostdens[k].initGhostCells( );
+            if( !alias[k])
+            {
+                swap_fields( phi[k], ghostphi[k]); 
+                ghostphi[k].initGhostCells(  );
+            }
+        }
+    }
+    //1. Compute nonlinearity and
+    //2. perform karniadakis step on each finished tile while it is in cache
+    for( unsigned k=0; k<n; k++)
+    {
+        const unsigned q = alias[k] ? 0 : k; //the potential of species k
+        for( size_t b=0; b<B; b++)
+        {
+#pragma omp task depend( in: D[k], P[q]) firstprivate( k, q, b, sc)
+            arakawa.lines( ghostdens[k], ghostphi[q], nonlinear[k], b*rows/B, (b+1)*rows/B, [&]( size_t i_begin, size_t i_end)
+            {
+                karniadakis->step_i_combine( ghostdens[k], nonlinear[k], k, i_begin, i_end, sc);
+            });
+        }
+    }
+    //3.1. transform v_hut as soon as all blocks of species k are finished
+    for( unsigned k=0; k<n; k++)
+    {
+#pragma omp task depend( inout: D[k]) depend( in: X[0])
+        {
+            swap_fields( dens[k], ghostdens[k]); 
+            karniadakis->step_i_rotate( dens[k], nonlinear[k], k);
+            drt_dft->r2c_T( dens[k], cdens[k]);
+        }
+    }
+    for( unsigned k=0; k<n; k++)
+        if( !alias[k]) 
+        {
+            //waits for all blocks reading ghostphi[k]
+#pragma omp task depend( inout: P[k])
+            swap_fields( phi[k], ghostphi[k]); 
+        }
+    karniadakis->step_i_advance();
+    //3.2. perform karniadakis step and multiply coefficients for phi in one pass
+#pragma omp task depend( inout: X[0])
+    {} //all species are transformed
+    for( size_t b=0; b<B; b++)
+    {
+#pragma omp task depend( in: X[0]) firstprivate( b)
+        spectral_update( b*crows/B, (b+1)*crows/B);
+    }
+#pragma omp task depend( inout: X[0])
+    {} //all lines are updated
+    //3.3. backtransform dens and phi independently
+    for( unsigned k=0; k<n; k++)
+    {
+#pragma omp task depend( in: X[0]) depend( inout: D[k])
+        drt_dft->c_T2r( cdens[k], dens[k]);
+        if( alias[k]) continue;
+#pragma omp task depend( in: X[0]) depend( inout: P[k])
+        drt_dft->c_T2r( cphi[k],  phi[k]);
+    }
+}
+
+template< size_t n>
+void DRT_DFT_Solver<n>::step_etdrk()
+{
+    auto no_tile = []( const std::vector< GhostMatrix<double, TL_DRT_DFT> >&, size_t, size_t){};
+    //1. Compute the nonlinearity of v^n (cphi serves as buffer) 
+    nonlinearity( no_tile);
 #pragma omp parallel for
     for( unsigned k=0; k<n; k++)
-        drt_dft.r2c_T( dens[k], cdens[k]);
-    //3.2. perform karniadaksi step and multiply coefficients for phi
-    karniadakis.step_ii( cdens);
+    {
+        drt_dft->r2c_T( nonlinear[k], cphi[k]);
+        drt_dft->r2c_T( dens[k], cdens[k]);
+    }
+    //2. Compute the stage and its potential
+    etdrk.predict( cdens, cphi);
+    compute_cphi();
+#pragma omp parallel for
+    for( unsigned k=0; k<n; k++)
+    {
+        drt_dft->c_T2r( cdens[k], dens[k]);
+        if( !alias[k]) drt_dft->c_T2r( cphi[k], phi[k]);
+    }
+    //3. Compute the nonlinearity of the stage and complete the step
+    nonlinearity( no_tile);
+#pragma omp parallel for
+    for( unsigned k=0; k<n; k++)
+        drt_dft->r2c_T( nonlinear[k], cphi[k]);
+    etdrk.correct( cdens, cphi);
     compute_cphi();
-    //3.3. backtransform
 #pragma omp parallel for
     for( unsigned k=0; k<n; k++)
     {
-        drt_dft.c_T2r( cdens[k], dens[k]);
-        drt_dft.c_T2r( cphi[k],  phi[k]);
+        drt_dft->c_T2r( cdens[k], dens[k]);
+        if( !alias[k]) drt_dft->c_T2r( cphi[k], phi[k]);
     }
 }
 }//namespace spectral
@@ -0,0 +1,279 @@
+#ifndef _TL_ENSEMBLE_
+#define _TL_ENSEMBLE_
+
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <omp.h>
+
+#include "spectral/spectral.h"
+#include "blueprint.h"
+
+namespace spectral
+{
+template< size_t n>
+class DFT_DFT_Solver;
+
+/*! @brief Advance many independent realisations of a solver in one process
+ *
+ * @ingroup solvers
+ * Each member is a solver of its own (e.g. of a parameter or seed sweep).
+ * The members share the FFTW plans if they have the same grid and
+ * the inverse coefficients of the Karniadakis scheme if they have the
+ * same parameters, i.e. the plans are measured and the coefficients are
+ * inverted once for the whole ensemble (cf. DFT_DFT_Solver( blueprint, shared)).
+ * The matrices of every member lie in a slot of one MatrixPool, so
+ * a field of all members is found at the same offset in the slots.
+ * The steps of the members of a DFT_DFT_Solver ensemble with at least two 
+ * members per thread are computed together:
+ * the nonlinearity and the spectral part are distributed
+ * over the members and the transforms of a field of a batch of members
+ * are one execution of a DFT_DFT_Batch plan. The result of every member is
+ * bitwise the one of a standalone solver.
+ * In all other cases (the DRT_DFT_Solver, the ETDRK scheme, the global
+ * polarisation, the task graph, changed timesteps and members on different grids)
+ * the members are distributed over the threads, i.e. each member is
+ * advanced by one thread and the parallel regions inside the solver
+ * are inactive.
+ * @tparam Solver DFT_DFT_Solver or DRT_DFT_Solver
+ * @note Use at least as many members as threads.
+ * @attention The memory of the fields belongs to the ensemble, i.e.
+ *  matrices swapped out of a member (cf. getField) must not outlive the ensemble.
+ */
+template< class Solver>
+class Ensemble
+{
+  public:
+    typedef typename Solver::Matrix_Type Matrix_Type;
+    /*! @brief Construct M members with the same parameters
+     *
+     * @param blueprint The parameters of every member
+     * @param M The number of members
+     */
+    Ensemble( const Blueprint& blueprint, const unsigned M): Ensemble( std::vector<Blueprint>( M, blueprint)) { }
+    /*! @brief Construct one member for every blueprint
+     *
+     * @param blueprints The parameters of the members (e.g. of a parameter sweep)
+     */
+    Ensemble( const std::vector<Blueprint>& blueprints);
+    /*! @brief The number of members
+     *
+     * @return The number of members
+     */
+    unsigned size() const { return members.size();}
+    /*! @brief Access a member
+     *
+     * Use it to initialize the member and to get its fields.
+     * @param m The index of the member
+     * @return The solver of member m
+     */
+    Solver& operator[]( const unsigned m) { return *members[m];}
+    const Solver& operator[]( const unsigned m) const { return *members[m];}
+    /*! @brief Perform the first initializing step of all members
+     */
+    void first_step() { for_each( []( Solver& s){ s.first_step();}, 1);}
+    /*! @brief Perform the second initializing step of all members
+     */
+    void second_step() { for_each( []( Solver& s){ s.second_step();}, 1);}
+    /*! @brief Perform a step of all members
+     */
+    void step() { step( 1);}
+    /*! @brief Perform N steps of all members
+     *
+     * The members of a DFT_DFT_Solver ensemble compute their steps together
+     * (cf. the class description), else each member computes all N steps
+     * before the thread takes the next member.
+     * @param N The number of steps (e.g. between two outputs)
+     */
+    void step( const unsigned N)
+    {
+        if( members.empty() || !step_batched( members[0].get(), N))
+            for_each( [N]( Solver& s){ s.step( N);}, N);
+    }
+    /*! @brief The throughput of the stepping functions so far
+     *
+     * @return The number of member-steps per second
+     */
+    double throughput() const { return time > 0 ? (double)member_steps/time : 0;}
+  private:
+    template< class F>
+    void for_each( const F& f, const unsigned steps);
+    template< size_t n>
+    void init_batches( DFT_DFT_Solver<n>* first);
+    void init_batches( void*) { }
+    template< size_t n>
+    bool step_batched( DFT_DFT_Solver<n>* first, const unsigned N);
+    bool step_batched( void*, const unsigned) { return false;}
+    //are the fields f( member) of the members m0,...,m1-1 one slot apart
+    template< class F>
+    bool uniform( const unsigned m0, const unsigned m1, const F& f) const
+    {
+        for( unsigned m=m0+1; m<m1; m++)
+            if( (const char*)f( *members[m]) != (const char*)f( *members[m0]) + (m-m0)*slot)
+                return false;
+        return true;
+    }
+    std::unique_ptr< MatrixPool> pool; //the memory of the members (outlives them)
+    std::vector< std::unique_ptr< Solver> > members;
+    size_t slot; //bytes per member in the pool
+    std::unique_ptr< DFT_DFT_Batch> batch, rest; //the plans of the full batches and of the last one (null if not batched)
+    double time;
+    unsigned long member_steps;
+};
+
+template< class Solver>
+Ensemble<Solver>::Ensemble( const std::vector<Blueprint>& blueprints): members( blueprints.size()), slot( 0), time( 0), member_steps( 0)
+{
+    const unsigned M = blueprints.size();
+    if( M == 0)
+        return;
+    //the first solver measures the plans and inverts the coefficients for all members
+    std::unique_ptr< Solver> first( new Solver( blueprints[0]));
+    {
+        MatrixPool counter; //the memory of a member
+        MatrixPool::Scope scope( counter);
+        Solver member( blueprints[0], first.get());
+        slot = counter.used();
+    }
+    pool.reset( new MatrixPool( M*slot));
+    for( unsigned m=0; m<M; m++)
+    {
+        pool->slot( m*slot, slot); //a larger member takes the rest from fftw_malloc
+        MatrixPool::Scope scope( *pool);
+        members[m].reset( new Solver( blueprints[m], first.get()));
+    }
+    init_batches( first.get());
+}
+
+//a batch for every thread but at most max_batch members,
+//i.e. the planning buffer takes at most max_batch slots
+template< class Solver>
+template< size_t n>
+void Ensemble<Solver>::init_batches( DFT_DFT_Solver<n>* first)
+{
+    const unsigned M = members.size(), max_batch = 8;
+    for( unsigned m=0; m<M; m++)
+        if( members[m]->rows != first->rows || members[m]->cols != first->cols)
+            return;
+    const unsigned B = std::min( std::max( M/omp_get_max_threads(), 1u), max_batch);
+    if( B == 1)
+        return;
+    batch.reset( new DFT_DFT_Batch( first->rows, first->cols, B, slot/sizeof(double), FFTW_MEASURE));
+    if( M%B > 1)
+        rest.reset( new DFT_DFT_Batch( first->rows, first->cols, M%B, slot/sizeof(double), FFTW_MEASURE));
+}
+
+//the steps of step_shared distributed over the members and the transforms of the batches
+template< class Solver>
+template< size_t n>
+bool Ensemble<Solver>::step_batched( DFT_DFT_Solver<n>* , const unsigned N)
+{
+    if( !batch)
+        return false;
+    const unsigned M = members.size();
+    for( unsigned m=0; m<M; m++)
+    {
+        const DFT_DFT_Solver<n>& s = *members[m];
+        if( s.blue.isEnabled( TL_ETDRK) || s.blue.isEnabled( TL_TASK_GRAPH) || s.polarisation || !s.karniadakis->equidistant())
+            return false;
+    }
+    const double start = omp_get_wtime();
+    for( unsigned m=0; m<M; m++)
+        members[m]->karniadakis->template invert_coeff<TL_ORDER3>();
+    const StepCoefficients c = step_coefficients<TL_ORDER3>();
+    const unsigned B = batch->size(), batches = ( M + B - 1)/B;
+    const size_t crows = members[0]->crows;
+    //transform field k of the batch b by one plan if the fields are in their slots
+    auto r2c = [&]( const unsigned k, const unsigned b)
+    {
+        const unsigned m0 = b*B, m1 = std::min( m0 + B, M);
+        DFT_DFT_Batch* plan = ( m1 - m0 == B) ? batch.get() : rest.get();
+        if( plan && uniform( m0, m1, [k]( const DFT_DFT_Solver<n>& s){ return s.dens[k].getPtr();}))
+        {
+            plan->r2c( members[m0]->dens[k].getPtr());
+            for( unsigned m=m0; m<m1; m++)
+                swap_fields( members[m]->dens[k], members[m]->cdens[k]);
+        }
+        else
+            for( unsigned m=m0; m<m1; m++)
+                members[m]->dft_dft->r2c( members[m]->dens[k], members[m]->cdens[k]);
+    };
+    auto c2r = [&]( std::array< Matrix< std::complex<double>, TL_NONE>, n> DFT_DFT_Solver<n>::* from,
+                    std::array< Matrix< double, TL_DFT>, n> DFT_DFT_Solver<n>::* to, const unsigned k, const unsigned b)
+    {
+        const unsigned m0 = b*B, m1 = std::min( m0 + B, M);
+        DFT_DFT_Batch* plan = ( m1 - m0 == B) ? batch.get() : rest.get();
+        if( plan && uniform( m0, m1, [k, from]( const DFT_DFT_Solver<n>& s){ return (s.*from)[k].getPtr();}))
+        {
+            for( unsigned m=m0; m<m1; m++)
+                swap_fields( ((*members[m]).*from)[k], ((*members[m]).*to)[k]);
+            plan->c2r( ((*members[m0]).*to)[k].getPtr());
+        }
+        else
+            for( unsigned m=m0; m<m1; m++)
+                members[m]->dft_dft->c2r( ((*members[m]).*from)[k], ((*members[m]).*to)[k]);
+    };
+    //the species whose potential is computed by all members of a batch
+    std::vector< char> potential( n*batches, 1);
+    for( unsigned m=0; m<M; m++)
+        for( unsigned k=0; k<n; k++)
+            if( members[m]->alias[k])
+                potential[k*batches + m/B] = 0;
+#pragma omp parallel
+    {
+    omp_set_num_threads( 1); //only affects nested regions of this thread
+    for( unsigned s=0; s<N; s++)
+    {
+        //1. Compute nonlinearity and
+        //2. perform karniadakis step of every member
+#pragma omp for schedule( dynamic)
+        for( unsigned m=0; m<M; m++)
+            members[m]->step_nonlinear( c);
+        //3.1. transform v_hut
+#pragma omp for schedule( dynamic)
+        for( unsigned l=0; l<n*batches; l++)
+            r2c( l/batches, l%batches);
+        //3.2. perform karniadakis step and multiply coefficients for phi in one pass
+#pragma omp for schedule( static)
+        for( size_t l=0; l<M*crows; l++)
+            members[l/crows]->spectral_update( l%crows, l%crows + 1);
+        //3.3. backtransform
+#pragma omp for schedule( dynamic)
+        for( unsigned l=0; l<n*batches; l++)
+        {
+            const unsigned k = l/batches, b = l%batches;
+            c2r( &DFT_DFT_Solver<n>::cdens, &DFT_DFT_Solver<n>::dens, k, b);
+            if( potential[l])
+                c2r( &DFT_DFT_Solver<n>::cphi, &DFT_DFT_Solver<n>::phi, k, b);
+            else
+                for( unsigned m=b*B; m<std::min( (b+1)*B, M); m++)
+                    if( !members[m]->alias[k])
+                        members[m]->dft_dft->c2r( members[m]->cphi[k], members[m]->phi[k]);
+        }
+    }
+    }
+    for( unsigned m=0; m<M; m++)
+        members[m]->copy_aliased();
+    time += omp_get_wtime() - start;
+    member_steps += (unsigned long)N*M;
+    return true;
+}
+
+template< class Solver>
+template< class F>
+void Ensemble<Solver>::for_each( const F& f, const unsigned steps)
+{
+    const double start = omp_get_wtime();
+#pragma omp parallel for schedule( dynamic)
+    for( unsigned m=0; m<members.size(); m++)
+    {
+        omp_set_num_threads( 1); //only affects nested regions of this thread
+        f( *members[m]);
+    }
+    time += omp_get_wtime() - start;
+    member_steps += (unsigned long)steps*members.size();
+}
+
+} //namespace spectral
+
+#endif //_TL_ENSEMBLE_
@@ -0,0 +1,59 @@
+#include <iostream>
+#include <omp.h>
+
+#include "spectral/spectral.h"
+#include "file/read_input.h"
+#include "dft_dft_solver.h"
+#include "ensemble.h"
+
+using namespace std;
+using namespace spectral;
+
+//member-steps per second of M members advanced one after the other
+//(like M separate processes) and of an ensemble of M members
+const unsigned n = 2;
+typedef DFT_DFT_Solver<n> Sol;
+typedef Sol::Matrix_Type Mat;
+
+const unsigned M = 8, steps = 20;
+
+void init( Sol& solver, const Blueprint& bp, const unsigned seed)
+{
+    const Algorithmic& alg = bp.algorithmic();
+    Mat ne{ alg.ny, alg.nx, 0.}, phi{ ne};
+    init_gaussian( ne, 0.3 + 0.05*seed, 0.5, 0.1, 0.1, 0.5);
+    std::array< Mat, n> arr{{ ne, phi}};
+    solver.init( arr, TL_IONS);
+}
+
+int main( int argc, char* argv[])
+{
+    std::vector<double> para;
+    try{ para = file::read_input( argc > 1 ? argv[1] : "input/default.in"); }
+    catch (Message& m) {  m.display(); return -1;}
+    const Blueprint bp( para);
+    cout << "With "<<omp_get_max_threads()<<" threads, "<<M<<" members of "<<bp.algorithmic().nx<<"x"<<bp.algorithmic().ny<<" points\n";
+    Timer t;
+    t.tic();
+    for( unsigned m=0; m<M; m++)
+    {
+        Sol solver( bp);
+        init( solver, bp, m);
+        solver.first_step();
+        solver.second_step();
+        solver.step( steps);
+    }
+    t.toc();
+    cout << "Separate solvers: "<<(double)(M*(steps+2))/t.diff()<<" member-steps/s (including construction)\n";
+    t.tic();
+    Ensemble<Sol> ensemble( bp, M);
+    for( unsigned m=0; m<M; m++)
+        init( ensemble[m], bp, m);
+    ensemble.first_step();
+    ensemble.second_step();
+    ensemble.step( steps);
+    t.toc();
+    cout << "Ensemble:         "<<(double)(M*(steps+2))/t.diff()<<" member-steps/s (including construction)\n";
+    cout << "Ensemble steps:   "<<ensemble.throughput()<<" member-steps/s\n";
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <iostream>
+#include <omp.h>
+
+#include "spectral/spectral.h"
+#include "file/read_input.h"
+#include "dft_dft_solver.h"
+#include "drt_dft_solver.h"
+#include "ensemble.h"
+
+using namespace std;
+using namespace spectral;
+
+//every member of an ensemble must compute bitwise the same as a standalone solver
+template< class Sol>
+void init( Sol& solver, const Blueprint& bp, const unsigned seed)
+{
+    const Algorithmic& alg = bp.algorithmic();
+    typename Sol::Matrix_Type ne{ alg.ny, alg.nx, 0.}, phi{ ne};
+    init_gaussian( ne, 0.3 + 0.05*seed, 0.5, 0.1, 0.1, 0.5);
+    std::array< typename Sol::Matrix_Type, 2> arr{{ ne, phi}};
+    solver.init( arr, TL_IONS);
+}
+
+template< class Sol>
+bool equal( const Sol& s1, const Sol& s2)
+{
+    return s1.getField( TL_ELECTRONS) == s2.getField( TL_ELECTRONS) && s1.getField( TL_IONS) == s2.getField( TL_IONS)
+        && s1.getField( TL_POTENTIAL) == s2.getField( TL_POTENTIAL);
+}
+
+template< class Sol>
+bool test( const std::vector< Blueprint>& bps)
+{
+    Ensemble< Sol> ensemble( bps);
+    for( unsigned m=0; m<bps.size(); m++)
+        init( ensemble[m], bps[m], m);
+    ensemble.first_step(), ensemble.second_step();
+    ensemble.step( 4), ensemble.step();
+    bool passed = true;
+    for( unsigned m=0; m<bps.size(); m++)
+    {
+        Sol solver( bps[m]);
+        init( solver, bps[m], m);
+        solver.first_step(), solver.second_step();
+        solver.step( 4), solver.step();
+        passed = passed && equal( solver, ensemble[m]);
+    }
+    return passed;
+}
+
+int main( int argc, char* argv[])
+{
+    vector<double> para;
+    try{ para = file::read_input( argc > 1 ? argv[1] : "input/default.in"); }
+    catch (Message& m) {  m.display(); return -1;}
+    Blueprint bp( para);
+    bp.algorithmic().nx = bp.algorithmic().ny = 32;
+    bp.algorithmic().h = bp.boundary().ly/32.;
+    bp.boundary().lx = bp.boundary().ly;
+    bp.physical().tau[0] = 0; //the ion potential is the electron potential
+    omp_set_num_threads( 3); //batches of 2 members
+
+    cout << "Test whether the members equal standalone solvers...\n";
+    cout << ( test< DFT_DFT_Solver<2> >( std::vector< Blueprint>( 8, bp)) ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    cout << "Test whether the members of a parameter sweep equal standalone solvers...\n";
+    {
+        std::vector< Blueprint> bps( 11, bp); //a last batch of 2 members
+        for( unsigned m=0; m<bps.size(); m+=3)
+            bps[m].physical().tau[0] = 1., bps[m].physical().kappa = -0.0005;
+        cout << ( test< DFT_DFT_Solver<2> >( bps) ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether the members of a DRT_DFT_Solver ensemble equal standalone solvers...\n";
+    bp.boundary().bc_x = TL_DST10;
+    cout << ( test< DRT_DFT_Solver<2> >( std::vector< Blueprint>( 4, bp)) ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    return 0;
+}
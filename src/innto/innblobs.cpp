@@ -5,6 +5,7 @@
 
 #include "spectral/spectral.h"
 #include "file/read_input.h"
+#include "file/checkpoint.h"
 #include "draw/host_window.h"
 #include "particle_density.h"
 #include "dft_dft_solver.h"
@@ -16,6 +17,8 @@
  * Inititalizes dft_dft_solver (only periodic BC possible!)
  * visualizes results directly on the screen
  * (difference to innto.cpp lies in the initial condition (blob))
+ * An optional checkpoint file is restored at the start (if it exists)
+ * and written at the end or when C is hit.
  */
 
 using namespace std;
@@ -141,13 +144,13 @@ int main( int argc, char* argv[])
     {
         bp_mod = read("blobs.in");
     }
-    else if( argc == 2)
+    else if( argc == 2 || argc == 3)
     {
         bp_mod = read( argv[1]);
     }
     else
     {
-        cerr << "ERROR: Too many arguments!\nUsage: "<< argv[0]<<" [filename]\n";
+        cerr << "ERROR: Too many arguments!\nUsage: "<< argv[0]<<" [filename [checkpoint]]\n";
         return -1;
     }
     const Blueprint bp = bp_mod;
@@ -205,10 +208,22 @@ int main( int argc, char* argv[])
     cout<< "HIT ESC to terminate program \n"
         << "HIT S   to stop simulation \n"
         << "HIT R   to continue simulation!\n";
+    if( argc == 3)
+        cout<< "HIT C   to write a checkpoint\n";
     target targ = TL_ALL;
-    solver.first_step();
-    solver.second_step();
-    t+= 2*alg.dt;
+    file::Checkpoint checkpoint( argc == 3 ? argv[2] : "");
+    if( argc == 3 && std::ifstream( argv[2]).good())
+    {
+        try{ t = file::restart( argv[2], solver); }
+        catch( Message& m){m.display(); return -1;}
+        std::cout << "Restart from "<<argv[2]<<" at time "<<t<<"\n";
+    }
+    else
+    {
+        solver.first_step();
+        solver.second_step();
+        t+= 2*alg.dt;
+    }
     while( !glfwWindowShouldClose(w))
     {
         overhead.tic();
@@ -229,6 +244,8 @@ int main( int argc, char* argv[])
         else if( glfwGetKey(w, '3')) targ = TL_IMPURITIES;
         else if( glfwGetKey(w, '4')) targ = TL_POTENTIAL;
         else if( glfwGetKey(w, '0')) targ = TL_ALL;
+        if( argc == 3 && glfwGetKey(w, 'C'))
+            checkpoint.write( solver, t);
         drawScene(solver, targ, render);
         window_str << setprecision(2) << fixed;
         window_str << " &&   time = "<<t;
@@ -236,15 +253,14 @@ int main( int argc, char* argv[])
         window_str.str("");
         glfwSwapBuffers(w);
         timer.tic();
-        for(unsigned i=0; i<N; i++)
-        {
-            solver.step();
-            t+= alg.dt;
-        }
+        solver.step( N);
+        t+= N*alg.dt;
         timer.toc();
         overhead.toc();
     }
     glfwTerminate();
+    if( argc == 3)
+        checkpoint.write( solver, t);
     cout << "Average time for one step = "<<timer.diff()/(double)N<<"s\n";
     cout << "Overhead for visualisation, etc. per step = "<<(overhead.diff()-timer.diff())/(double)N<<"s\n";
     }
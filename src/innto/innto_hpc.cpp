@@ -9,29 +9,27 @@
 #include "file/file.h"
 #include "dg/backend/grid.h"
 #include "file/nc_utilities.h"
+#include "file/checkpoint.h"
 
 #include "particle_density.h"
-#include "dft_dft_solver.h"
-#include "drt_dft_solver.h"
 #include "blueprint.h"
+#include "solver.h"
 /*
  * Same as innblobs but outputs results in netcdf - file
+ * After a restart from the checkpoint the outputs are appended to the existing file
  */
 
 using namespace std;
 using namespace spectral;
 
-const unsigned n = 2;
-typedef DFT_DFT_Solver<n> Sol;
-typedef DRT_DFT_Solver<n> SolDIR;
-typedef Sol::Matrix_Type Mat;
-typedef SolDIR::Matrix_Type MatDIR;
+typedef Solver::Matrix_Type Mat;
     
 unsigned itstp; //initialized by init function
 unsigned max_out;
 double amp, imp_amp; //
 double blob_width, posX, posY;
 unsigned reduction;
+const double checkpoint_interval = 600; //seconds between two checkpoints
 
 
 Blueprint read( char const * file)
@@ -58,13 +56,14 @@ Blueprint read( char const * file)
     return bp;
 }
 
-void copyAndReduceMatrix( const Mat& src, std::vector<double> & dst)
+//src is a field of rows x cols points in row major order
+void copyAndReduceMatrix( const std::vector<double>& src, const unsigned rows, const unsigned cols, std::vector<double> & dst)
 {
     unsigned num = 0;
-    for( unsigned i=0; i<src.rows(); i+= reduction)
-        for( unsigned j=0; j<src.cols(); j+= reduction)
+    for( unsigned i=0; i<rows; i+= reduction)
+        for( unsigned j=0; j<cols; j+= reduction)
         {
-            dst[num] = src(i,j);
+            dst[num] = src[i*cols+j];
             num ++;
         }
 }
@@ -76,24 +75,6 @@ double integral( const Mat& src, double h)
             sum+=h*h*src(i,j);
     return sum;
 }
-void copyAndReduceMatrix( const MatDIR& src, std::vector<double> & dst)
-{
-    unsigned num = 0;
-    for( unsigned i=0; i<src.rows(); i+= reduction)
-        for( unsigned j=0; j<src.cols(); j+= reduction)
-        {
-            dst[num] = src(i,j);
-            num ++;
-        }
-}
-double integral( const MatDIR& src, double h)
-{
-    double sum=0;
-    for( unsigned i=0; i<src.rows(); i++)
-        for( unsigned j=0; j<src.cols(); j++)
-            sum+=h*h*src(i,j);
-    return sum;
-}
 
 void xpa( std::vector<double>& x, double a)
 {
@@ -109,9 +90,9 @@ int main( int argc, char* argv[])
     Blueprint bp_mod;
     std::vector<double> v;
     std::string input;
-    if( argc != 3)
+    if( argc != 3 && argc != 4)
     {
-        cerr << "ERROR: Wrong number of arguments!\nUsage: "<< argv[0]<<" [inputfile] [outputfile]\n";
+        cerr << "ERROR: Wrong number of arguments!\nUsage: "<< argv[0]<<" [inputfile] [outputfile] ([checkpoint])\n";
         return -1;
     }
     else 
@@ -121,74 +102,93 @@ int main( int argc, char* argv[])
     }
     const Blueprint bp = bp_mod;
     bp.display( );
-    //construct solvers 
-    try{
-        Sol solver( bp);
-        if( bp.boundary().bc_x == TL_PERIODIC)
-            bp_mod.boundary().bc_x = TL_DST10;
-        SolDIR drt_solver( bp_mod);
-    }catch( Message& m){m.display();}
-    Sol solver (bp);
-    SolDIR drt_solver (bp_mod);
+    //construct the solver (two species, impurities are neither initialized nor written)
+    std::unique_ptr<Solver> solver;
+    try{ solver = make_solver<2>( bp);}
+    catch( Message& m){m.display(); return -1;}
 
     const Algorithmic& alg = bp.algorithmic();
     Mat ne{ alg.ny, alg.nx, 0.}, phi{ ne};
-    MatDIR ne_{ alg.ny, alg.nx, 0.}, phi_{ ne_};
     const Boundary& bound = bp.boundary();
     // place some gaussian blobs in the field
     try{
         init_gaussian( ne, posX, posY, blob_width/bound.lx, blob_width/bound.ly, amp);
-        init_gaussian( ne_, posX, posY, blob_width/bound.lx, blob_width/bound.ly, amp);
-        std::array< Mat, n> arr{{ ne, phi}};
-        std::array< MatDIR, n> arr_{{ ne_, phi_}};
+        std::vector< Mat> v{ ne, phi};
         //now set the field to be computed
-        if( bp.boundary().bc_x == TL_PERIODIC)
-            solver.init( arr, TL_IONS);
-        else
-            drt_solver.init( arr_, TL_IONS);
+        solver->init( v, TL_IONS);
     }catch( Message& m){m.display();}
     double meanMassE = integral( ne, alg.h)/bound.lx/bound.ly;
+    //continue from the checkpoint if there is one 
+    double time = 0.0;
+    unsigned restarted = 0; //number of outputs before the restart
+    const bool resume = argc == 4 && std::ifstream( argv[3]).good();
+    if( resume)
+    {
+        try{ time = file::restart( argv[3], *solver); }
+        catch( Message& m){m.display(); return -1;}
+        restarted = (unsigned)round( time/(itstp*alg.dt));
+        std::cout << "Restart from "<<argv[3]<<" at time "<<time<<"\n";
+    }
+    file::Checkpoint checkpoint( argc == 4 ? argv[3] : "");
+    Timer checkpoint_timer;
+    checkpoint_timer.tic();
     //Energetics<n> energetics( bp);
 
     /////////////////////////////////////////////////////////////////////////
-    int ncid;
+    int ncid, tvarID, id_ne, id_ni, id_phi;
     file::NC_Error_Handle err;
-    err = nc_create( argv[2], NC_NETCDF4|NC_CLOBBER, &ncid);
-    err = nc_put_att_text( ncid, NC_GLOBAL, "input", input.size(), input.data());
-    int dim_ids[3], tvarID;
-    dg::Grid1d gx( 0, bound.lx, 1, alg.nx/reduction);
-    dg::Grid1d gy( 0, bound.ly, 1, alg.ny/reduction);
-    dg::Grid2d g2d( gx, gy);
-    err = file::define_dimensions( ncid, dim_ids, &tvarID, g2d);
-    int id_ne, id_ni, id_phi;
-    err = nc_def_var( ncid, "n_e", NC_DOUBLE, 3, dim_ids, &id_ne);
-    err = nc_def_var( ncid, "n_i", NC_DOUBLE, 3, dim_ids, &id_ni);
-    err = nc_def_var( ncid, "phi", NC_DOUBLE, 3, dim_ids, &id_phi);
-    err = nc_enddef( ncid);
+    if( resume) //append to the outputs of the interrupted run
+    {
+        int time_id;
+        size_t written;
+        try{
+            err = nc_open( argv[2], NC_WRITE, &ncid);
+            err = nc_inq_dimid( ncid, "time", &time_id);
+            err = nc_inq_dimlen( ncid, time_id, &written);
+            err = nc_inq_varid( ncid, "time", &tvarID);
+            err = nc_inq_varid( ncid, "n_e", &id_ne);
+            err = nc_inq_varid( ncid, "n_i", &id_ni);
+            err = nc_inq_varid( ncid, "phi", &id_phi);
+        }
+        catch( file::NC_Error& e)
+        {
+            cerr << "ERROR: Cannot continue the output in "<<argv[2]<<": "<<e.what()<<"\n";
+            return -1;
+        }
+        if( written < restarted)
+        {
+            cerr << "ERROR: "<<argv[2]<<" lacks outputs before the checkpoint!\n";
+            nc_close( ncid);
+            return -1;
+        }
+    }
+    else
+    {
+        err = nc_create( argv[2], NC_NETCDF4|NC_CLOBBER, &ncid);
+        err = nc_put_att_text( ncid, NC_GLOBAL, "input", input.size(), input.data());
+        int dim_ids[3];
+        dg::Grid1d gx( 0, bound.lx, 1, alg.nx/reduction);
+        dg::Grid1d gy( 0, bound.ly, 1, alg.ny/reduction);
+        dg::Grid2d g2d( gx, gy);
+        err = file::define_dimensions( ncid, dim_ids, &tvarID, g2d);
+        err = nc_def_var( ncid, "n_e", NC_DOUBLE, 3, dim_ids, &id_ne);
+        err = nc_def_var( ncid, "n_i", NC_DOUBLE, 3, dim_ids, &id_ni);
+        err = nc_def_var( ncid, "phi", NC_DOUBLE, 3, dim_ids, &id_phi);
+        err = nc_enddef( ncid);
+    }
     size_t count[3] = {1, alg.ny/reduction, alg.nx/reduction};
     size_t start[3] = {0, 0, 0};
 
     //file::T5trunc t5file( argv[2], input);
-    double time = 0.0;
     std::vector<double> out( alg.nx/reduction*alg.ny/reduction);
     std::vector<double> output[3] = {out, out, out};
-    for( unsigned i=0; i<max_out; i++)
+    for( unsigned i=restarted; i<max_out; i++)
     {
         //output all three fields
-        if( bp.boundary().bc_x == TL_PERIODIC)
-        {
-            copyAndReduceMatrix( solver.getField( TL_ELECTRONS), output[0]);
-            xpa( output[0], meanMassE); //mean mass gets lost through the timestep
-            copyAndReduceMatrix( solver.getField( TL_IONS), output[1]);
-            copyAndReduceMatrix( solver.getField( TL_POTENTIAL), output[2]);
-        }
-        else
-        {
-            copyAndReduceMatrix( drt_solver.getField( TL_ELECTRONS), output[0]);
-            xpa( output[0], meanMassE); //mean mass gets lost through the timestep
-            copyAndReduceMatrix( drt_solver.getField( TL_IONS), output[1]);
-            copyAndReduceMatrix( drt_solver.getField( TL_POTENTIAL), output[2]);
-        }
+        copyAndReduceMatrix( solver->copyField( TL_ELECTRONS), alg.ny, alg.nx, output[0]);
+        xpa( output[0], meanMassE); //mean mass gets lost through the timestep
+        copyAndReduceMatrix( solver->copyField( TL_IONS), alg.ny, alg.nx, output[1]);
+        copyAndReduceMatrix( solver->copyField( TL_POTENTIAL), alg.ny, alg.nx, output[2]);
         //t5file.write( output[0], output[1], output[2], time, alg.nx/reduction, alg.ny/reduction);
         start[0] = i;
         err = nc_put_vara_double( ncid, id_ne, start, count, output[0].data());
@@ -201,51 +201,24 @@ int main( int argc, char* argv[])
         //std::cout<< thermal[0] << " "<< thermal[1]<<" "<<exb[0]<<"\n";
         //t5file.append( meanMassE, 0, exb[0]+thermal[0]+thermal[1], 0);
         std::cout << "time = " << time << std::endl;
-        for( unsigned j=0; j<itstp; j++)
+        //the first two steps initialize the karniadakis scheme
+        const unsigned init = ( i==0) ? std::min( itstp, 2u) : 0;
+        if( init > 0) solver->first_step();
+        if( init > 1) solver->second_step();
+        solver->step( itstp - init);
+        time += itstp*alg.dt;
+        //write a checkpoint in the background every few minutes
+        checkpoint_timer.toc();
+        if( argc == 4 && checkpoint_timer.diff() > checkpoint_interval)
         {
-            if( bp.boundary().bc_x == TL_PERIODIC)
-            {
-                if( i==0 && j==0)
-                {
-                    solver.first_step();
-                }
-                else if( i==0 && j==1)
-                {
-                    solver.second_step();
-                }
-                else 
-                    solver.step();
-            }
-            else
-            {
-                if( i==0 && j==0)
-                {
-                    drt_solver.first_step();
-                }
-                else if( i==0 && j==1)
-                {
-                    drt_solver.second_step();
-                }
-                else 
-                    drt_solver.step();
-            }
-            time += alg.dt;
+            checkpoint.write( *solver, time);
+            checkpoint_timer.tic();
         }
     }
-    if( bp.boundary().bc_x == TL_PERIODIC)
-    {
-        copyAndReduceMatrix( solver.getField( TL_ELECTRONS), output[0]);
-        xpa( output[0], meanMassE);
-        copyAndReduceMatrix( solver.getField( TL_IONS), output[1]);
-        copyAndReduceMatrix( solver.getField( TL_POTENTIAL), output[2]);
-    }
-    else
-    {
-        copyAndReduceMatrix( drt_solver.getField( TL_ELECTRONS), output[0]);
-        xpa( output[0], meanMassE);
-        copyAndReduceMatrix( drt_solver.getField( TL_IONS), output[1]);
-        copyAndReduceMatrix( drt_solver.getField( TL_POTENTIAL), output[2]);
-    }
+    copyAndReduceMatrix( solver->copyField( TL_ELECTRONS), alg.ny, alg.nx, output[0]);
+    xpa( output[0], meanMassE);
+    copyAndReduceMatrix( solver->copyField( TL_IONS), alg.ny, alg.nx, output[1]);
+    copyAndReduceMatrix( solver->copyField( TL_POTENTIAL), alg.ny, alg.nx, output[2]);
     start[0] = max_out;
     err = nc_put_vara_double( ncid, id_ne, start, count, output[0].data());
     err = nc_put_vara_double( ncid, id_ni, start, count, output[1].data());
@@ -8,6 +8,7 @@
 #include "spectral/timer.h"
 #include "file/read_input.h"
 #include "file/file.h"
+#include "file/checkpoint.h"
 #include "particle_density.h"
 #include "dft_dft_solver.h"
 
@@ -24,6 +25,7 @@ typedef DFT_DFT_Solver<n> Sol;
 typedef Sol::Matrix_Type Mat;
     
 unsigned itstp, itstp2; //initialized by init function
+const double checkpoint_interval = 600; //seconds between two checkpoints
 unsigned max_out;
 double amp, imp_amp; //
 double blob_width, posX, posY;
@@ -147,9 +149,9 @@ int main( int argc, char* argv[])
     Blueprint bp_mod;
     std::vector<double> v;
     std::string input;
-    if( argc != 4)
+    if( argc != 4 && argc != 5)
     {
-        cerr << "ERROR: Wrong number of arguments!\nUsage: "<< argv[0]<<" [inputfile] [fields.h5] [probe.h5] \n";
+        cerr << "ERROR: Wrong number of arguments!\nUsage: "<< argv[0]<<" [inputfile] [fields.h5] [probe.h5] ([checkpoint])\n";
         return -1;
     }
     else 
@@ -170,8 +172,10 @@ int main( int argc, char* argv[])
         return -1;
     }
     //construct solvers 
-    try{ Sol solver( bp); }catch( Message& m){m.display();}
-    Sol solver (bp);
+    std::unique_ptr<Sol> construct;
+    try{ construct.reset( new Sol( bp)); }
+    catch( Message& m){m.display(); return -1;}
+    Sol& solver = *construct;
     unsigned rows = bp.algorithmic().ny, cols = bp.algorithmic().nx;
     DFT_DFT dft_dft(rows, cols);
     unsigned crows = rows, ccols = cols/2+1;
@@ -188,6 +192,19 @@ int main( int argc, char* argv[])
         //now set the field to be computed
         solver.init( arr, TL_IONS);
     }catch( Message& m){m.display();}
+    //continue from the checkpoint if there is one
+    double time = 0.0;
+    unsigned restarted = 0; //number of outputs before the restart
+    if( argc == 5 && std::ifstream( argv[4]).good())
+    {
+        try{ time = file::restart( argv[4], solver); }
+        catch( Message& m){m.display(); return -1;}
+        restarted = (unsigned)round( time/(itstp*alg.dt));
+        std::cout << "Restart from "<<argv[4]<<" at time "<<time<<"\n";
+    }
+    file::Checkpoint checkpoint( argc == 5 ? argv[4] : "");
+    spectral::Timer checkpoint_timer;
+    checkpoint_timer.tic();
     //double meanMassE = integral( ne, alg.h)/bound.lx/bound.ly;
     //std::cout << setprecision(6) <<meanMassE<<std::endl;
     
@@ -197,14 +214,13 @@ int main( int argc, char* argv[])
     //std::ofstream  os( argv[4]);
     //os << "#Time(1) Ue(2) Ui(3) Uj(4) Ei(5) Ej(6) M(Ei)(7) M(Ej)(8) F_e(9) F_i(10) F_j(11) R_i(12) R_j(13) Diff(14) M(Diff)(15) A(16) J(17)\n";
     //os << std::setprecision(14);
-    double time = 0.0;
     std::vector<double> probe_array( 64), probe_fluct( 64);
     std::vector<double> average(8,0);
     std::vector<double> out( alg.nx*alg.ny);
     std::vector<double> output[n+1] = {out, out, out, out};
     spectral::Timer t, t2, t3;
     t.tic();
-    file::Probe probe( argv[3], input, max_out*itstp/itstp2);
+    file::Probe probe( argv[3], input, (max_out-restarted)*itstp/itstp2);
           probe.createSet( "ne", 8, 8);
           probe.createSet( "ne_fluc", 8, 8);
           probe.createSet( "ni", 8, 8);
@@ -234,7 +250,7 @@ int main( int argc, char* argv[])
           probe.createDataSet( "A");
           probe.createDataSet( "J");
 
-    for( unsigned i=0; i<max_out; i++)
+    for( unsigned i=restarted; i<max_out; i++)
     {
         std::vector<double> times, ue, ui, uj, ei, ej, mi, mj, fe, fi, fj, ri, rj, diff, mdiff, capital_a, capital_jot;
         std::vector<double> probe_ne[64], probe_ne_fluc[64];
@@ -296,40 +312,47 @@ int main( int argc, char* argv[])
 
         }
         //write Probe file
-        probe.writeSubset( times,"time", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( ue, "Ue", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( ui, "Ui", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( uj, "Uj", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( ei, "Ei", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( ej, "Ej", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( mi, "Mi", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( mj, "Mj", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( fe, "Fe", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( fi, "Fi", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( fj, "Fj", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( ri, "Ri", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( rj, "Rj", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( diff, "Diff", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( mdiff, "MDiff", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( capital_a, "A", itstp/itstp2, i*itstp/itstp2);
-        probe.writeSubset( capital_jot, "J", itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "ne", probe_ne, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "ni", probe_ni, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "nj", probe_nz, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "ne_fluc", probe_ne_fluc, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "ni_fluc", probe_ni_fluc, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "nj_fluc", probe_nz_fluc, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "phi", probe_phi, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "phi_fluc", probe_phi_fluc, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "vx", probe_vx, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "vy", probe_vy, itstp/itstp2, i*itstp/itstp2);
-        write_probe_to_file( probe, "vy_fluc", probe_vy_fluc, itstp/itstp2, i*itstp/itstp2);
+        probe.writeSubset( times,"time", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( ue, "Ue", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( ui, "Ui", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( uj, "Uj", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( ei, "Ei", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( ej, "Ej", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( mi, "Mi", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( mj, "Mj", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( fe, "Fe", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( fi, "Fi", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( fj, "Fj", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( ri, "Ri", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( rj, "Rj", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( diff, "Diff", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( mdiff, "MDiff", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( capital_a, "A", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        probe.writeSubset( capital_jot, "J", itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "ne", probe_ne, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "ni", probe_ni, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "nj", probe_nz, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "ne_fluc", probe_ne_fluc, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "ni_fluc", probe_ni_fluc, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "nj_fluc", probe_nz_fluc, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "phi", probe_phi, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "phi_fluc", probe_phi_fluc, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "vx", probe_vx, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "vy", probe_vy, itstp/itstp2, (i-restarted)*itstp/itstp2);
+        write_probe_to_file( probe, "vy_fluc", probe_vy_fluc, itstp/itstp2, (i-restarted)*itstp/itstp2);
 
         t2.toc();
         std::cout << "\n\t Time "<<time <<" / "<<alg.dt*itstp*max_out;
         std::cout << "\n\t Average time for one step: "<<t2.diff()/(double)itstp<<"s"<<std::flush;
         std::cout << "\n\t        Time for one probe: "<<t3.diff()<<"s"<<std::flush;
         std::cout << "\n\t    Percent time for probe: "<<itstp/itstp2*t3.diff()/t2.diff()<<"s\n"<<std::flush;
+        //write a checkpoint in the background every few minutes
+        checkpoint_timer.toc();
+        if( argc == 5 && checkpoint_timer.diff() > checkpoint_interval)
+        {
+            checkpoint.write( solver, time);
+            checkpoint_timer.tic();
+        }
     }
     output[0] = solver.getField( TL_ELECTRONS).copy();
     //xpa( output[0], meanMassE);
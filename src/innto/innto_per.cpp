@@ -6,8 +6,8 @@
 #include "spectral/spectral.h"
 #include "file/read_input.h"
 #include "draw/host_window.h"
-#include "dft_dft_solver.h"
 #include "blueprint.h"
+#include "solver.h"
 #include "particle_density.h"
 
 /*
@@ -26,8 +26,7 @@ unsigned width = 960, height = 1080; //initial window width & height
 std::stringstream window_str;  //window name
 std::vector<double> visual;
 draw::ColorMapRedBlueExt map;
-typedef DFT_DFT_Solver<2> Sol;
-typedef typename Sol::Matrix_Type Mat;
+typedef Matrix<double, TL_DFT> Mat;
 
 void WindowResize( GLFWwindow* win, int w, int h)
 {
@@ -62,49 +61,47 @@ Blueprint read( char const * file)
 }
     
 
-// The solver has to have the getField( target) function returing M
-// and the blueprint() function
-template<class Solver>
 void drawScene( const Solver& solver, draw::RenderHostData& rend)
 {
-    ParticleDensity particle( solver.getField( TL_POTENTIAL), solver.blueprint());
-    const typename Solver::Matrix_Type * field;
+    const Algorithmic& alg = solver.blueprint().algorithmic();
+    Mat phi( alg.ny, alg.nx);
+    ParticleDensity particle( phi, solver.blueprint());
     
     { //draw electrons
-    field = &solver.getField( TL_ELECTRONS);
-    visual = field->copy(); 
+    visual = solver.copyField( TL_ELECTRONS);
     map.scale() = fabs(*std::max_element(visual.begin(), visual.end()));
-    rend.renderQuad( visual, field->cols(), field->rows(), map);
+    rend.renderQuad( visual, alg.nx, alg.ny, map);
     window_str << scientific;
     window_str <<"ne / "<<map.scale()<<"\t";
     }
 
     { //draw Ions
-    field = &solver.getField( TL_IONS);
-    visual = field->copy();
+    visual = solver.copyField( TL_IONS);
     //upper right
-    rend.renderQuad( visual, field->cols(), field->rows(), map);
+    rend.renderQuad( visual, alg.nx, alg.ny, map);
     window_str <<" ni / "<<map.scale()<<"\t";
     }
 
     if( solver.blueprint().isEnabled( TL_IMPURITY))
     {
-        field = &solver.getField( TL_IMPURITIES); 
-        visual = field->copy();
+        visual = solver.copyField( TL_IMPURITIES);
         map.scale() = fabs(*std::max_element(visual.begin(), visual.end()));
         //lower left
-        rend.renderQuad( visual, field->cols(), field->rows(), map);
+        rend.renderQuad( visual, alg.nx, alg.ny, map);
         window_str <<" nz / "<<map.scale()<<"\t";
     }
     else
         rend.renderEmptyQuad( );
 
     { //draw potential
-    typename Solver::Matrix_Type phi = solver.getField( TL_POTENTIAL);
+    visual = solver.copyField( TL_POTENTIAL);
+    for( unsigned i=0; i<alg.ny; i++)
+        for( unsigned j=0; j<alg.nx; j++)
+            phi( i,j) = visual[i*alg.nx+j];
     particle.laplace( phi );
     visual = phi.copy(); 
     map.scale() = fabs(*std::max_element(visual.begin(), visual.end()));
-    rend.renderQuad( visual, field->cols(), field->rows(), map);
+    rend.renderQuad( visual, alg.nx, alg.ny, map);
     window_str <<" phi / "<<map.scale()<<"\t";
     }
         
@@ -130,14 +127,18 @@ int main( int argc, char* argv[])
     const Blueprint bp = bp_mod;
     
     bp.display(cout);
-    //construct solvers 
-    DFT_DFT_Solver<2> solver2( bp);
-    DFT_DFT_Solver<3> solver3( bp);
-    if( bp.boundary().bc_x == TL_PERIODIC)
-        bp_mod.boundary().bc_x = TL_DST10;
+    if( bp.boundary().bc_x != TL_PERIODIC)
+    {
+        cerr << "ERROR: Only periodic boundaries allowed!\n";
+        return -1;
+    }
+    //construct the solver 
+    std::unique_ptr<Solver> solver;
+    try{ solver = make_solver( bp);}
+    catch( Message& m){m.display(); return -1;}
 
     const Algorithmic& alg = bp.algorithmic();
-    Matrix<double, TL_DFT> ne{ alg.ny, alg.nx, 0.}, nz{ ne}, phi{ ne};
+    Matrix<double, TL_NONE> ne{ alg.ny, alg.nx, 0.}, nz{ ne}, phi{ ne};
     // place some gaussian blobs in the field
     try{
         //init_gaussian( ne, 0.1,0.2, 10./128./field_ratio, 10./128., amp);
@@ -145,37 +146,15 @@ int main( int argc, char* argv[])
         init_gaussian( ne, 0.5,0.5, 10./128./field_ratio, 10./128., amp);
         //init_gaussian( ne, 0.1,0.8, 10./128./field_ratio, 10./128., -amp);
         //init_gaussian( ni, 0.1,0.5, 0.05/field_ratio, 0.05, amp);
+        std::vector< Matrix<double, TL_NONE> > v{ ne, phi};
         if( bp.isEnabled( TL_IMPURITY))
         {
             //init_gaussian( nz, 0.8,0.4, 0.05/field_ratio, 0.05, -imp_amp);
             init_gaussian_column( nz, 0.6, 0.05/field_ratio, imp_amp);
+            v.insert( v.begin() + 1, nz);
         }
-        std::array< Matrix<double, TL_DFT>,2> arr2{{ ne, phi}};
-        std::array< Matrix<double, TL_DFT>,3> arr3{{ ne, nz, phi}};
-        Matrix<double, TL_DRT_DFT> ne_{ alg.ny, alg.nx, 0.}, nz_{ ne_}, phi_{ ne_};
-        init_gaussian( ne_, 0.5,0.5, 0.05/field_ratio, 0.05, amp);
-        //init_gaussian( ne_, 0.2,0.2, 0.05/field_ratio, 0.05, -amp);
-        //init_gaussian( ne_, 0.6,0.6, 0.05/field_ratio, 0.05, -amp);
-        //init_gaussian( ni_, 0.5,0.5, 0.05/field_ratio, 0.05, amp);
-        if( bp.isEnabled( TL_IMPURITY))
-        {
-            init_gaussian( nz_, 0.5,0.5, 0.05/field_ratio, 0.05, -imp_amp);
-            //init_gaussian( nz_, 0.2,0.2, 0.05/field_ratio, 0.05, -imp_amp);
-            //init_gaussian( nz_, 0.6,0.6, 0.05/field_ratio, 0.05, -imp_amp);
-        }
-        std::array< Matrix<double, TL_DRT_DFT>,2> arr2_{{ ne_, phi_}};
-        std::array< Matrix<double, TL_DRT_DFT>,3> arr3_{{ ne_, nz_, phi_}};
         //now set the field to be computed
-        if( !bp.isEnabled( TL_IMPURITY))
-        {
-            if( bp.boundary().bc_x == TL_PERIODIC)
-                solver2.init( arr2, TL_IONS);
-        }
-        else
-        {
-            if( bp.boundary().bc_x == TL_PERIODIC)
-                solver3.init( arr3, TL_IONS);
-        }
+        solver->init( v, TL_IONS);
     }catch( Message& m){m.display();}
 
     ////////////////////////////////glfw//////////////////////////////
@@ -209,16 +188,7 @@ int main( int argc, char* argv[])
         }
         
         //draw scene
-        if( !bp.isEnabled( TL_IMPURITY))
-        {
-            if( bp.boundary().bc_x == TL_PERIODIC)
-                drawScene( solver2, render);
-        }
-        else
-        {
-            if( bp.boundary().bc_x == TL_PERIODIC)
-                drawScene( solver3, render);
-        }
+        drawScene( *solver, render);
         window_str << setprecision(2) << fixed;
         window_str << " &&   time = "<<t;
         glfwSetWindowTitle(w, (window_str.str()).c_str() );
@@ -230,20 +200,8 @@ int main( int argc, char* argv[])
         {
 #endif
         timer.tic();
-        for(unsigned i=0; i<N; i++)
-        {
-            if( !bp.isEnabled( TL_IMPURITY))
-            {
-                if( bp.boundary().bc_x == TL_PERIODIC)
-                    solver2.step( );
-            }
-            else
-            {
-                if( bp.boundary().bc_x == TL_PERIODIC)
-                    solver3.step( );
-            }
-            t+= alg.dt;
-        }
+        solver->step( N);
+        t+= N*alg.dt;
         timer.toc();
 #ifdef TL_DEBUG
             cout << "Next "<<N<<" Steps\n";
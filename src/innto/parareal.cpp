@@ -0,0 +1,128 @@
+#include <iostream>
+#include <iomanip>
+#include <omp.h>
+
+#include "spectral/spectral.h"
+#include "file/read_input.h"
+#include "blueprint.h"
+#include "dft_dft_solver.h"
+#include "parareal.h"
+/*
+ * Runs a blob of an innto input file in time slices with the parareal algorithm
+ * and compares convergence and speed to the serial run of the same slices.
+ * Since every slice starts anew with first_step and second_step the serial 
+ * run of the slices differs from an uninterrupted run of the solver,
+ * the difference at the end is printed as well.
+ */
+
+using namespace std;
+using namespace spectral;
+
+const unsigned n = 2;
+typedef Parareal<n>::State State;
+typedef Parareal<n>::Matrix_Type Mat;
+
+const double tolerance = 1e-8; //relative change of the states to stop the iteration
+
+double difference( const State& x, const State& y)
+{
+    double diff = 0, max = 0;
+    for( unsigned q=0; q<n; q++)
+        for( size_t i=0; i<x[q].rows(); i++)
+            for( size_t j=0; j<x[q].cols(); j++)
+            {
+                diff = std::max( diff, fabs( x[q](i,j) - y[q](i,j)));
+                max = std::max( max, fabs( y[q](i,j)));
+            }
+    return max > 0 ? diff/max : diff;
+}
+
+int main( int argc, char* argv[])
+{
+    if( argc > 4)
+    {
+        cerr << "ERROR: Too many arguments!\nUsage: "<< argv[0]<<" [inputfile] [slices] [steps per slice]\n";
+        return -1;
+    }
+    const char* file = argc > 1 ? argv[1] : "input/default.in";
+    std::cout << "Reading from "<<file<<"\n";
+    std::vector<double> para;
+    try{ para = file::read_input( file); }
+    catch (Message& m) {  m.display(); return -1;}
+    const Blueprint fine_bp( para);
+    if( fine_bp.isEnabled( TL_IMPURITY) || fine_bp.boundary().bc_x != TL_PERIODIC)
+    {
+        cerr << "ERROR: Parareal runs only without impurities and with periodic boundaries!\n";
+        return -1;
+    }
+    omp_set_num_threads( para[20]);
+    const unsigned slices = argc > 2 ? atoi( argv[2]) : omp_get_max_threads();
+    const unsigned steps = argc > 3 ? atoi( argv[3]) : 10*(unsigned)para[19];
+    //the coarse solver has half the resolution and twice the timestep
+    Blueprint coarse_bp( fine_bp);
+    coarse_bp.algorithmic().nx /= 2, coarse_bp.algorithmic().ny /= 2;
+    coarse_bp.algorithmic().h *= 2., coarse_bp.algorithmic().dt *= 2.;
+    const Algorithmic& alg = fine_bp.algorithmic();
+    const Boundary& bound = fine_bp.boundary();
+    std::cout << "With "<<omp_get_max_threads()<<" threads, "<<slices<<" slices of "<<steps<<" steps on "<<alg.nx<<"x"<<alg.ny<<" points\n";
+    std::cout << "Coarse solver on "<<coarse_bp.algorithmic().nx<<"x"<<coarse_bp.algorithmic().ny<<" points with dt = "<<coarse_bp.algorithmic().dt<<"\n";
+
+    State init{{ Mat( alg.ny, alg.nx, 0.), Mat( alg.ny, alg.nx, 0.)}};
+    init_gaussian( init[0], para[23], para[24], para[21]/bound.lx, para[21]/bound.ly, para[10]);
+    //the serial run of the slices
+    std::vector< State> reference( slices + 1, init);
+    Timer t;
+    try{
+        DFT_DFT_Solver<n> solver( fine_bp);
+        t.tic();
+        for( unsigned s=0; s<slices; s++)
+        {
+            State temp( reference[s]);
+            solver.init( temp, TL_IONS);
+            solver.first_step();
+            solver.second_step();
+            solver.step( steps - 2);
+            reference[s+1][0] = solver.getField( TL_ELECTRONS);
+            reference[s+1][1] = solver.getField( TL_POTENTIAL);
+        }
+        t.toc();
+    }
+    catch( Message& m) { m.display(); return -1;}
+    const double serial = t.diff();
+    std::cout << "Serial run took "<<serial<<"s\n";
+    //the uninterrupted run, i.e. without the restarts at the slice boundaries
+    State uninterrupted( init);
+    try{
+        DFT_DFT_Solver<n> solver( fine_bp);
+        State temp( init);
+        solver.init( temp, TL_IONS);
+        solver.first_step();
+        solver.second_step();
+        solver.step( slices*steps - 2);
+        uninterrupted[0] = solver.getField( TL_ELECTRONS);
+        uninterrupted[1] = solver.getField( TL_POTENTIAL);
+    }
+    catch( Message& m) { m.display(); return -1;}
+    std::cout << "Serial run of the slices differs from the uninterrupted run by "<<difference( reference[slices], uninterrupted)<<"\n";
+
+    try{
+        Parareal<n> parareal( fine_bp, coarse_bp, slices, steps);
+        parareal.init( init);
+        std::cout << "Iteration 0 (coarse prediction): error "<<difference( parareal[slices], reference[slices])<<"\n";
+        std::cout << setw(10)<<"iteration"<<setw(14)<<"change"<<setw(14)<<"error"<<setw(12)<<"time/s"<<setw(10)<<"speedup"<<"\n";
+        double change = 1;
+        while( change > tolerance && parareal.iterations() < slices)
+        {
+            change = parareal.iterate();
+            double error = 0;
+            for( unsigned s=1; s<=slices; s++)
+                error = std::max( error, difference( parareal[s], reference[s]));
+            std::cout << setw(10)<<parareal.iterations()<<setw(14)<<change<<setw(14)<<error
+                      << setw(12)<<parareal.elapsed()<<setw(10)<<serial/parareal.elapsed()<<"\n";
+        }
+        std::cout << "Parareal differs from the uninterrupted run by "<<difference( parareal[slices], uninterrupted)<<"\n";
+        std::cout << "Time in fine slices "<<parareal.fine_time()<<"s ("<<parareal.fine_time()/parareal.elapsed()<<" threads busy on average)\n";
+    }
+    catch( Message& m) { m.display(); return -1;}
+    return 0;
+}
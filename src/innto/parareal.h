@@ -0,0 +1,240 @@
+#ifndef _TL_PARAREAL_
+#define _TL_PARAREAL_
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <cmath>
+#include <omp.h>
+
+#include "spectral/spectral.h"
+#include "blueprint.h"
+#include "dft_dft_solver.h"
+
+namespace spectral
+{
+/*! @brief Parallelize a run in time with the parareal algorithm
+ *
+ * @ingroup solvers
+ * The time of the run is divided into slices. A cheap coarse solver (coarser grid
+ * and/or larger timestep) predicts the state at the beginning of every slice,
+ * the fine solvers then correct the prediction concurrently, one thread per slice:
+ * \f[ U_{s+1}^{k+1} = G(U_s^{k+1}) + F(U_s^k) - G(U_s^k) \f]
+ * After k iterations the first k slices equal the serial fine run of the slices, i.e.
+ * the iteration is exact after as many iterations as slices and pays off
+ * only if it converges much earlier.
+ * A state consists of the fields given to DFT_DFT_Solver::init
+ * (the densities except the last and the potential). The fine and the coarse
+ * solver start every slice anew, i.e. with first_step() and second_step().
+ * @note The multistep history is not part of the state, so the serial 
+ * run of the slices is not an uninterrupted run of the DFT_DFT_Solver: 
+ * it takes a first and a second order step at every slice boundary and
+ * differs from the uninterrupted run by their error (cf. the parareal driver).
+ * The states of the coarse grid are transferred by resize_spectrum.
+ * @tparam n The number of species of the DFT_DFT_Solver
+ */
+template< size_t n>
+class Parareal
+{
+  public:
+    typedef Matrix< double, TL_DFT> Matrix_Type;
+    typedef std::array< Matrix_Type, n> State; //!< The first n-1 densities and the potential
+    /*! @brief Construct the solvers
+     *
+     * @param fine The parameters of the fine solver
+     * @param coarse The parameters of the coarse solver (same box and physics)
+     * @param slices The number of time slices
+     * @param steps The number of fine steps in a slice
+     * @throw Message If the boxes differ, a timestep is adaptive or the
+     *  coarse timestep does not divide the length of a slice
+     */
+    Parareal( const Blueprint& fine, const Blueprint& coarse, const unsigned slices, const unsigned steps);
+    /*! @brief Set the initial state and predict the others with the coarse solver
+     *
+     * @param init The state at the beginning of the first slice
+     */
+    void init( const State& init);
+    /*! @brief Perform one parareal iteration
+     *
+     * The fine solvers of all slices that are not yet exact run concurrently.
+     * @return The maximum change of the states relative to their maximum value
+     */
+    double iterate();
+    /*! @brief The state at the beginning of a slice
+     *
+     * @param s The index of the slice (s = slices() is the end of the run)
+     * @return The state of the current iteration
+     */
+    const State& operator[]( const unsigned s) const { return U[s];}
+    /*! @brief The number of slices
+     *
+     * @return The number of slices
+     */
+    unsigned slices() const { return fine.size();}
+    /*! @brief The number of iterations performed so far
+     *
+     * @return The number of iterations
+     */
+    unsigned iterations() const { return k;}
+    /*! @brief The time a thread spent in fine slices so far
+     *
+     * The sum of the times of all fine slices, i.e. the time the
+     * fine solver would need for all of them in serial.
+     * @return The time in seconds
+     */
+    double fine_time() const { return t_fine;}
+    /*! @brief The wall time of init() and all iterations
+     *
+     * @return The time in seconds
+     */
+    double elapsed() const { return t_wall;}
+  private:
+    typedef std::complex<double> complex;
+    void fine_propagate( DFT_DFT_Solver<n>& solver, const State& in, State& out);
+    void coarse_propagate( const State& in, State& out);
+    void transfer( DFT_DFT& from_dft, const Matrix_Type& from, Matrix_Type& from_temp, Matrix< complex>& cfrom,
+                   Matrix< complex>& cto, DFT_DFT& to_dft, Matrix_Type& to);
+    static void propagate( DFT_DFT_Solver<n>& solver, const State& in, State& out, const unsigned steps);
+    std::vector< std::unique_ptr< DFT_DFT_Solver<n> > > fine; //one for every slice
+    DFT_DFT_Solver<n> coarse;
+    const unsigned steps, coarse_steps;
+    const bool same_grid;
+    std::vector< State> U, F, G; //the states, the fine and the coarse propagations of the last iteration
+    State coarse_in, coarse_out; //on the coarse grid
+    DFT_DFT fine_dft, coarse_dft;
+    Matrix_Type fine_temp, coarse_temp;
+    Matrix< complex> cfine, ccoarse;
+    unsigned k;
+    double t_fine, t_wall;
+};
+
+template< size_t n>
+Parareal<n>::Parareal( const Blueprint& fine_bp, const Blueprint& coarse_bp, const unsigned slices, const unsigned steps):
+    fine( slices), coarse( coarse_bp), steps( steps),
+    coarse_steps( (unsigned)floor( steps*fine_bp.algorithmic().dt/coarse_bp.algorithmic().dt + 0.5)),
+    same_grid( fine_bp.algorithmic().nx == coarse_bp.algorithmic().nx && fine_bp.algorithmic().ny == coarse_bp.algorithmic().ny),
+    U( slices + 1, MatrixArray< double, TL_DFT, n>::construct( fine_bp.algorithmic().ny, fine_bp.algorithmic().nx)),
+    F( slices, U[0]), G( slices, U[0]),
+    coarse_in( MatrixArray< double, TL_DFT, n>::construct( coarse_bp.algorithmic().ny, coarse_bp.algorithmic().nx)), coarse_out( coarse_in),
+    fine_dft( fine_bp.algorithmic().ny, fine_bp.algorithmic().nx, FFTW_ESTIMATE),
+    coarse_dft( coarse_bp.algorithmic().ny, coarse_bp.algorithmic().nx, FFTW_ESTIMATE),
+    fine_temp( fine_bp.algorithmic().ny, fine_bp.algorithmic().nx),
+    coarse_temp( coarse_bp.algorithmic().ny, coarse_bp.algorithmic().nx),
+    cfine( fine_bp.algorithmic().ny, fine_bp.algorithmic().nx/2+1),
+    ccoarse( coarse_bp.algorithmic().ny, coarse_bp.algorithmic().nx/2+1),
+    k( 0), t_fine( 0), t_wall( 0)
+{
+    if( fine_bp.boundary().lx != coarse_bp.boundary().lx || fine_bp.boundary().ly != coarse_bp.boundary().ly)
+        throw Message( "Fine and coarse solver must have the same box!", _ping_);
+    if( fine_bp.isEnabled( TL_ADAPTIVE_DT) || coarse_bp.isEnabled( TL_ADAPTIVE_DT))
+        throw Message( "Parareal needs fixed timesteps!", _ping_);
+    if( fabs( coarse_steps*coarse_bp.algorithmic().dt - steps*fine_bp.algorithmic().dt) > 1e-10*steps*fine_bp.algorithmic().dt)
+        throw Message( "Coarse timestep must divide the length of a slice!", _ping_);
+    if( steps < 2 || coarse_steps < 2)
+        throw Message( "A slice needs at least two steps!", _ping_);
+    //the plans of the later solvers are found in the wisdom of the first
+    for( unsigned s=0; s<slices; s++)
+        fine[s].reset( new DFT_DFT_Solver<n>( fine_bp));
+}
+
+template< size_t n>
+void Parareal<n>::init( const State& init)
+{
+    const double start = omp_get_wtime();
+    U[0] = init;
+    for( unsigned s=0; s<slices(); s++)
+    {
+        coarse_propagate( U[s], G[s]);
+        U[s+1] = G[s];
+    }
+    k = 0;
+    t_wall = omp_get_wtime() - start;
+    t_fine = 0;
+}
+
+template< size_t n>
+double Parareal<n>::iterate()
+{
+    if( k == slices()) //all slices are exact
+        return 0;
+    const double start = omp_get_wtime();
+    double time = 0;
+#pragma omp parallel for schedule( dynamic) reduction( +: time)
+    for( unsigned s=k; s<slices(); s++)
+    {
+        omp_set_num_threads( 1); //only affects nested regions of this thread
+        const double t = omp_get_wtime();
+        fine_propagate( *fine[s], U[s], F[s]);
+        time += omp_get_wtime() - t;
+    }
+    t_fine += time;
+    //the correction sweep is serial, U[k] is exact and stays
+    State g( U[0]);
+    double change = 0, max = 0;
+    for( unsigned s=k; s<slices(); s++)
+    {
+        coarse_propagate( U[s], g);
+        for( unsigned q=0; q<n; q++)
+            for( size_t i=0; i<g[q].rows(); i++)
+                for( size_t j=0; j<g[q].cols(); j++)
+                {
+                    const double u = g[q](i,j) + F[s][q](i,j) - G[s][q](i,j);
+                    change = std::max( change, fabs( u - U[s+1][q](i,j)));
+                    max = std::max( max, fabs( u));
+                    U[s+1][q](i,j) = u;
+                }
+        for( unsigned q=0; q<n; q++)
+            swap_fields( G[s][q], g[q]);
+    }
+    k++;
+    t_wall += omp_get_wtime() - start;
+    return max > 0 ? change/max : 0;
+}
+
+template< size_t n>
+void Parareal<n>::propagate( DFT_DFT_Solver<n>& solver, const State& in, State& out, const unsigned steps)
+{
+    const enum target species[3] = { TL_ELECTRONS, TL_IONS, TL_IMPURITIES};
+    solver.init( in, species[n-1]);
+    solver.first_step();
+    solver.second_step();
+    solver.step( steps - 2);
+    for( unsigned q=0; q<n-1; q++)
+        out[q] = solver.getField( species[q]);
+    out[n-1] = solver.getField( TL_POTENTIAL);
+}
+
+template< size_t n>
+void Parareal<n>::fine_propagate( DFT_DFT_Solver<n>& solver, const State& in, State& out)
+{
+    propagate( solver, in, out, steps);
+}
+
+template< size_t n>
+void Parareal<n>::coarse_propagate( const State& in, State& out)
+{
+    if( same_grid)
+    {
+        propagate( coarse, in, out, coarse_steps);
+        return;
+    }
+    for( unsigned q=0; q<n; q++)
+        transfer( fine_dft, in[q], fine_temp, cfine, ccoarse, coarse_dft, coarse_in[q]);
+    propagate( coarse, coarse_in, coarse_out, coarse_steps);
+    for( unsigned q=0; q<n; q++)
+        transfer( coarse_dft, coarse_out[q], coarse_temp, ccoarse, cfine, fine_dft, out[q]);
+}
+
+template< size_t n>
+void Parareal<n>::transfer( DFT_DFT& from_dft, const Matrix_Type& from, Matrix_Type& from_temp, Matrix< complex>& cfrom,
+                            Matrix< complex>& cto, DFT_DFT& to_dft, Matrix_Type& to)
+{
+    from_temp = from;
+    from_dft.r2c( from_temp, cfrom);
+    resize_spectrum( cfrom, cto);
+    to_dft.c2r( cto, to); //the transforms swap the memory of equally sized matrices only
+}
+
+} //namespace spectral
+
+#endif //_TL_PARAREAL_
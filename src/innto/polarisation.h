@@ -0,0 +1,224 @@
+#ifndef _TL_POLARISATION_
+#define _TL_POLARISATION_
+
+#include <array>
+#include <complex>
+#include <cmath>
+
+#include "spectral/spectral.h"
+#include "blueprint.h"
+
+namespace spectral
+{
+/*! @brief Solve the global polarisation equation for periodic boundaries
+ *
+ * @ingroup solvers
+ * The global polarisation equation
+ * \f[ \nabla\cdot\left(\epsilon\nabla\phi\right) = n_e - a_i\Gamma_1 n_i - a_z\Gamma_1 n_z \f]
+ * with \f$ \epsilon = a_i\mu_i(1+n_i) + a_z\mu_z(1+n_z)\f$ depends on the densities,
+ * so it cannot be solved mode by mode. It is solved by the conjugate gradient method
+ * matrix free in fourier space, i.e. the derivatives are spectral and the product with
+ * \f$ \epsilon\f$ is done in x-space. One iteration costs two pairs of fourier transforms.
+ * The local equation (\f$ \epsilon_0 = a_i\mu_i + a_z\mu_z\f$) is the preconditioner,
+ * so the right hand side is the potential of the local equation.
+ * Every solve starts from the linear extrapolation of the last two solutions
+ * (or from the last one), so with small timesteps only a few iterations are needed.
+ * @note The gyrocenter densities enter \f$ \epsilon\f$, which must be positive everywhere.
+ */
+class Polarisation
+{
+  public:
+    typedef std::complex<double> complex;
+    /*! @brief Allocate the fields and create the fourier transforms
+     *
+     * @param rows The number of points in y
+     * @param cols The number of points in x
+     * @param lx The length of the box in x
+     * @param ly The length of the box in y
+     * @param phys The physical parameters (a and mu)
+     * @param eps The tolerance of the residual relative to the right hand side
+     */
+    Polarisation( const size_t rows, const size_t cols, const double lx, const double ly, const Physical& phys, const double eps = 1e-8);
+    /*! @brief Change the physical parameters
+     *
+     * @param phys The new parameters
+     */
+    void set_physical( const Physical& phys) { pol_i = phys.a[0]*phys.mu[0], pol_z = phys.a[1]*phys.mu[1];}
+    /*! @brief Solve the global equation
+     *
+     * @tparam n The number of species (ions are 1, impurities 2)
+     * @param cdens The normalized fourier coefficients of the densities
+     * @param cphi Contains the (normalized) potential of the local equation on input
+     *  and the one of the global equation on output
+     * @param extrapolate Start from the extrapolation of the last two solutions
+     *  (use it if the solves are equidistant in time), else from the last one
+     * @return The number of iterations
+     * @throw Message If the iteration does not converge
+     */
+    template< size_t n>
+    unsigned operator()( const std::array< Matrix< complex>, n>& cdens, Matrix< complex>& cphi, const bool extrapolate = true);
+    /*! @brief The number of iterations of the last solve
+     *
+     * @return The number of iterations
+     */
+    unsigned iterations() const { return iter;}
+  private:
+    void apply( const Matrix< complex>& in, Matrix< complex>& out); //out = -div( eps grad in)
+    double dot( const Matrix< complex>& x, const Matrix< complex>& y) const;
+    double laplace( const size_t i, const size_t j) const
+    {
+        const int ik = (i>rows/2) ? (int)i-(int)rows : (int)i;
+        return -kxmin2*(double)(j*j) - kymin2*(double)(ik*ik);
+    }
+    const size_t rows, cols, crows, ccols;
+    const double kxmin, kymin, kxmin2, kymin2;
+    double pol_i, pol_z, pol_0; //a*mu and their sum
+    const double eps;
+    const unsigned max_iter;
+    DFT_DFT dft_dft;
+    Matrix< complex> x, x_old, r, z, p, ap, cdx, cdy; //x and x_old are the last two solutions
+    Matrix< double, TL_DFT> dx, dy, deps; //deps = eps - eps_0 in x-space
+    unsigned solutions; //number of solves so far
+    unsigned iter;
+};
+
+Polarisation::Polarisation( const size_t rows, const size_t cols, const double lx, const double ly, const Physical& phys, const double eps):
+    rows( rows), cols( cols), crows( rows), ccols( cols/2+1),
+    kxmin( 2.*M_PI/lx), kymin( 2.*M_PI/ly), kxmin2( kxmin*kxmin), kymin2( kymin*kymin),
+    pol_i( phys.a[0]*phys.mu[0]), pol_z( phys.a[1]*phys.mu[1]), pol_0( 0), eps( eps), max_iter( 100),
+    dft_dft( rows, cols, FFTW_MEASURE),
+    x( crows, ccols, complex( 0)), x_old( x), r( x), z( x), p( x), ap( x), cdx( x), cdy( x),
+    dx( rows, cols), dy( dx), deps( dx), solutions( 0), iter( 0)
+{
+}
+
+template< size_t n>
+unsigned Polarisation::operator()( const std::array< Matrix< complex>, n>& cdens, Matrix< complex>& cphi, const bool extrapolate)
+{
+    const double pol[2] = { pol_i, n == 3 ? pol_z : 0.};
+    pol_0 = pol[0] + pol[1];
+    //eps - eps_0 in x-space
+    deps.zero();
+    for( unsigned k=1; k<n; k++)
+    {
+        cdx = cdens[k];
+        dft_dft.c2r( cdx, dx);
+#pragma omp parallel for
+        for( size_t i=0; i<rows; i++)
+            for( size_t j=0; j<cols; j++)
+                deps(i,j) += pol[k-1]*dx(i,j);
+    }
+    //b = -eps_0 L phi_local, the preconditioner is -eps_0 L
+    if( solutions == 0) //start with the local potential
+        x = cphi;
+    else if( extrapolate && solutions > 1)
+    {
+#pragma omp parallel for
+        for( size_t i=0; i<crows; i++)
+            for( size_t j=0; j<ccols; j++)
+            {
+                const complex last = x(i,j);
+                x(i,j) = 2.*last - x_old(i,j);
+                x_old(i,j) = last;
+            }
+    }
+    else 
+        x_old = x;
+    apply( x, ap);
+#pragma omp parallel for
+    for( size_t i=0; i<crows; i++)
+        for( size_t j=0; j<ccols; j++)
+        {
+            const double m = -pol_0*laplace( i, j);
+            r(i,j) = m*cphi(i,j) - ap(i,j);
+            z(i,j) = ( m != 0) ? r(i,j)/m : 0;
+            p(i,j) = z(i,j);
+        }
+    const double b_norm = sqrt( fabs( dot( cphi, cphi)));
+    double rz = dot( r, z);
+    for( iter = 0; sqrt( fabs( dot( z, z))) > eps*b_norm; iter++)
+    {
+        if( iter == max_iter)
+            throw Message( "Global polarisation equation did not converge!", _ping_);
+        apply( p, ap);
+        const double alpha = rz/dot( p, ap);
+#pragma omp parallel for
+        for( size_t i=0; i<crows; i++)
+            for( size_t j=0; j<ccols; j++)
+            {
+                x(i,j) += alpha*p(i,j);
+                r(i,j) -= alpha*ap(i,j);
+                const double m = -pol_0*laplace( i, j);
+                z(i,j) = ( m != 0) ? r(i,j)/m : 0;
+            }
+        const double rz_new = dot( r, z);
+        const double beta = rz_new/rz;
+        rz = rz_new;
+#pragma omp parallel for
+        for( size_t i=0; i<crows; i++)
+            for( size_t j=0; j<ccols; j++)
+                p(i,j) = z(i,j) + beta*p(i,j);
+    }
+    cphi = x;
+    solutions++;
+    return iter;
+}
+
+void Polarisation::apply( const Matrix< complex>& in, Matrix< complex>& out)
+{
+    const complex I( 0, 1);
+    //the Nyquist modes have no first derivative
+#pragma omp parallel for
+    for( size_t i=0; i<crows; i++)
+    {
+        const int ik = (i>rows/2) ? (int)i-(int)rows : (int)i;
+        const double ky = ( 2*i == rows) ? 0 : kymin*(double)ik;
+        for( size_t j=0; j<ccols; j++)
+        {
+            const double kx = ( 2*j == cols) ? 0 : kxmin*(double)j;
+            cdx(i,j) = I*kx*in(i,j);
+            cdy(i,j) = I*ky*in(i,j);
+        }
+    }
+    dft_dft.c2r( cdx, dx);
+    dft_dft.c2r( cdy, dy);
+#pragma omp parallel for
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            dx(i,j) *= deps(i,j);
+            dy(i,j) *= deps(i,j);
+        }
+    dft_dft.r2c( dx, cdx);
+    dft_dft.r2c( dy, cdy);
+    const double norm = (double)(rows*cols);
+#pragma omp parallel for
+    for( size_t i=0; i<crows; i++)
+    {
+        const int ik = (i>rows/2) ? (int)i-(int)rows : (int)i;
+        const double ky = ( 2*i == rows) ? 0 : kymin*(double)ik;
+        for( size_t j=0; j<ccols; j++)
+        {
+            const double kx = ( 2*j == cols) ? 0 : kxmin*(double)j;
+            out(i,j) = -pol_0*laplace( i, j)*in(i,j) - ( I*kx*cdx(i,j) + I*ky*cdy(i,j))/norm;
+        }
+    }
+}
+
+//the scalar product in x-space (up to a factor), the negative kx are not stored
+double Polarisation::dot( const Matrix< complex>& a, const Matrix< complex>& b) const
+{
+    double sum = 0;
+#pragma omp parallel for reduction( +: sum)
+    for( size_t i=0; i<crows; i++)
+        for( size_t j=0; j<ccols; j++)
+        {
+            const double w = ( j == 0 || 2*j == cols) ? 1. : 2.;
+            sum += w*( a(i,j).real()*b(i,j).real() + a(i,j).imag()*b(i,j).imag());
+        }
+    return sum;
+}
+
+} //namespace spectral
+
+#endif //_TL_POLARISATION_
@@ -0,0 +1,69 @@
+#include <iostream>
+#include <cmath>
+#include "polarisation.h"
+
+using namespace std;
+using namespace spectral;
+typedef Polarisation::complex Complex;
+
+const size_t rows = 32, cols = 64;
+const double lx = 4.*M_PI, ly = 2.*M_PI;
+const double kx = 2.*M_PI/lx, ky = 3.*2.*M_PI/ly;
+const double amp = 0.5; //ion density amplitude
+
+//phi = sin( kx x) + cos( ky y) and n_i = amp*cos( kx x) with a_i = mu_i = 1
+double phi( double x, double y){ return sin( kx*x) + cos( ky*y);}
+double ni( double x, double y){ return amp*cos( kx*x);}
+double div_eps_grad_phi( double x, double y)
+{
+    const double eps = 1. + amp*cos( kx*x), deps_x = -amp*kx*sin( kx*x);
+    return deps_x*kx*cos( kx*x) + eps*( -kx*kx*sin( kx*x) - ky*ky*cos( ky*y));
+}
+
+int main()
+{
+    Physical phys;
+    phys.a[0] = 1., phys.mu[0] = 1., phys.a[1] = 0., phys.mu[1] = 0.;
+    const double hx = lx/(double)cols, hy = ly/(double)rows;
+    Matrix< double, TL_DFT> rhs( rows, cols), ions( rows, cols), exact( rows, cols);
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+        {
+            const double x = ((double)j+0.5)*hx, y = ((double)i+0.5)*hy;
+            rhs(i,j) = div_eps_grad_phi( x, y);
+            ions(i,j) = ni( x, y);
+            exact(i,j) = phi( x, y);
+        }
+    DFT_DFT dft_dft( rows, cols);
+    std::array< Matrix< Complex>, 2> cdens{{ Matrix<Complex>( rows, cols/2+1), Matrix<Complex>( rows, cols/2+1)}};
+    Matrix< Complex> cphi( rows, cols/2+1);
+    dft_dft.r2c( ions, cdens[1]);
+    dft_dft.r2c( rhs, cphi);
+    //the potential of the local equation
+    const double norm = (double)(rows*cols);
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols/2+1; j++)
+        {
+            const int ik = (i>rows/2) ? (int)i-(int)rows : (int)i;
+            const double laplace = -(2.*M_PI/lx)*(2.*M_PI/lx)*(double)(j*j) - (2.*M_PI/ly)*(2.*M_PI/ly)*(double)(ik*ik);
+            cdens[1](i,j) /= norm;
+            cphi(i,j) = ( laplace == 0) ? 0 : cphi(i,j)/laplace/norm;
+        }
+    cout << "Test whether the global polarisation equation is solved...\n";
+    Polarisation polarisation( rows, cols, lx, ly, phys, 1e-12);
+    Matrix< Complex> cphi2( cphi);
+    const unsigned iter = polarisation( cdens, cphi);
+    Matrix< double, TL_DFT> result( rows, cols);
+    dft_dft.c2r( cphi, result);
+    double diff = 0;
+    for( size_t i=0; i<rows; i++)
+        for( size_t j=0; j<cols; j++)
+            diff = std::max( diff, fabs( result(i,j) - exact(i,j)));
+    cout << "Iterations "<<iter<<", max error "<<diff<<"\n";
+    cout << ( diff < 1e-8 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    cout << "Test whether the solve starts from the last solution...\n";
+    const unsigned warm = polarisation( cdens, cphi2);
+    cout << "Iterations "<<warm<<"\n";
+    cout << ( warm == 0 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    return 0;
+}
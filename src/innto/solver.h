@@ -0,0 +1,166 @@
+#ifndef _TL_SOLVER_
+#define _TL_SOLVER_
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <iostream>
+
+#include "spectral/spectral.h"
+#include "blueprint.h"
+#include "dft_dft_solver.h"
+#include "drt_dft_solver.h"
+
+namespace spectral
+{
+/*! @brief Common interface of the innto solvers
+ *
+ * @ingroup solvers
+ * Use make_solver to construct the one solver that fits
+ * the boundary conditions and the number of species of a blueprint.
+ * The fields are exchanged in matrices without padding, so the
+ * drivers do not depend on the transformation of the solver.
+ */
+class Solver
+{
+  public:
+    typedef Matrix<double, TL_NONE> Matrix_Type;
+    virtual ~Solver(){}
+    /*! @brief The number of fields (species and potential)
+     *
+     * @return 2 without and 3 with impurities
+     */
+    virtual unsigned size() const = 0;
+    /*! @brief Prepare the solver for execution
+     *
+     * @param v size() non void matrices of ny times nx points
+     * @param t which Matrix is missing?
+     * @throw Message if v has the wrong size or a matrix of v is not ny times nx
+     */
+    virtual void init( std::vector< Matrix_Type>& v, enum target t) = 0;
+    /*! @brief Perform the first initializing step
+     */
+    virtual void first_step() = 0;
+    /*! @brief Perform the second initializing step
+     */
+    virtual void second_step() = 0;
+    /*! @brief Perform a step
+     */
+    virtual void step() = 0;
+    /*! @brief Perform N steps
+     *
+     * @param N The number of steps
+     */
+    virtual void step( const unsigned N) = 0;
+    /*! @brief Copy a field of the current timestep
+     *
+     * @param t The field you want
+     * @return The field without padding in row major order
+     */
+    virtual std::vector<double> copyField( enum target t) const = 0;
+    /*! @brief Write the state of the solver (cf. DFT_DFT_Solver::checkpoint)
+     *
+     * @param os The (binary) outstream
+     * @param time The time of the current fields
+     */
+    virtual void checkpoint( std::ostream& os, const double time) const = 0;
+    /*! @brief Restore the state of the solver (cf. DFT_DFT_Solver::restart)
+     *
+     * @param is The (binary) instream
+     * @return The time of the stored fields
+     */
+    virtual double restart( std::istream& is) = 0;
+    /*! @brief Change the physical parameters (cf. DFT_DFT_Solver::set_physical)
+     *
+     * @param phys The new physical parameters
+     */
+    virtual void set_physical( const Physical& phys) = 0;
+    /*! @brief The parameters of the solver
+     *
+     * @return The blueprint
+     */
+    virtual const Blueprint& blueprint() const = 0;
+};
+
+/*! @brief Implement the Solver interface by one of the solvers
+ *
+ * @ingroup solvers
+ * @tparam Sol DFT_DFT_Solver<n> or DRT_DFT_Solver<n>
+ * @tparam n The number of fields of Sol
+ * @tparam P The padding of Sol::Matrix_Type
+ */
+template< class Sol, size_t n, enum Padding P>
+class SolverAdapter : public Solver
+{
+  public:
+    typedef Matrix<double, P> Padded;
+    /*! @brief Construct the solver
+     *
+     * @param bp The parameters
+     */
+    SolverAdapter( const Blueprint& bp): solver( bp){}
+    unsigned size() const { return n;}
+    void init( std::vector< Matrix_Type>& v, enum target t)
+    {
+        if( v.size() != n)
+            throw Message( "Wrong number of fields for this solver!", _ping_);
+        const Algorithmic& alg = solver.blueprint().algorithmic();
+        for( unsigned k=0; k<n; k++)
+            if( v[k].isVoid() || v[k].rows() != alg.ny || v[k].cols() != alg.nx)
+                throw Message( "A field has the wrong size for this solver!", _ping_);
+        std::array< Padded, n> arr = MatrixArray< double, P, n>::construct( alg.ny, alg.nx);
+        for( unsigned k=0; k<n; k++)
+            for( size_t i=0; i<alg.ny; i++)
+                for( size_t j=0; j<alg.nx; j++)
+                    arr[k](i,j) = v[k](i,j);
+        solver.init( arr, t);
+    }
+    void first_step() { solver.first_step();}
+    void second_step() { solver.second_step();}
+    void step() { solver.step();}
+    void step( const unsigned N) { solver.step( N);}
+    std::vector<double> copyField( enum target t) const { return solver.getField( t).copy();}
+    void checkpoint( std::ostream& os, const double time) const { solver.checkpoint( os, time);}
+    double restart( std::istream& is) { return solver.restart( is);}
+    void set_physical( const Physical& phys) { solver.set_physical( phys);}
+    const Blueprint& blueprint() const { return solver.blueprint();}
+  private:
+    Sol solver;
+};
+
+/*! @brief Construct the solver with n fields that fits the boundary of a blueprint
+ *
+ * @ingroup solvers
+ * Periodic boundaries in x give a DFT_DFT_Solver, all others a DRT_DFT_Solver.
+ * Only this one solver is constructed (and its plans created).
+ * @tparam n The number of fields (2 or 3) regardless of TL_IMPURITY
+ * @param bp The parameters
+ * @return The solver
+ * @throw Message If the parameters are inconsistent
+ */
+template< size_t n>
+std::unique_ptr<Solver> make_solver( const Blueprint& bp)
+{
+    if( bp.boundary().bc_x == TL_PERIODIC)
+        return std::unique_ptr<Solver>( new SolverAdapter< DFT_DFT_Solver<n>, n, TL_DFT>( bp));
+    return std::unique_ptr<Solver>( new SolverAdapter< DRT_DFT_Solver<n>, n, TL_DRT_DFT>( bp));
+}
+
+/*! @brief Construct the solver that fits the blueprint
+ *
+ * @ingroup solvers
+ * Same as above with three fields if impurities are enabled, else two.
+ * @param bp The parameters
+ * @return The solver
+ * @throw Message If the parameters are inconsistent
+ */
+inline std::unique_ptr<Solver> make_solver( const Blueprint& bp)
+{
+    if( bp.isEnabled( TL_IMPURITY))
+        return make_solver<3>( bp);
+    return make_solver<2>( bp);
+}
+
+} //namespace spectral
+
+#endif //_TL_SOLVER_
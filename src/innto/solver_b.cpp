@@ -0,0 +1,81 @@
+#include <iostream>
+#include <iomanip>
+#include <cstdlib>
+#include <omp.h>
+
+#include "spectral/spectral.h"
+#include "file/read_input.h"
+#include "solver.h"
+
+using namespace std;
+using namespace spectral;
+
+//milliseconds per step of the solvers with 2 and 3 species
+//without and with the task graph for 1, 2, 4, ... threads
+//(up to the number of processors or the second argument)
+const unsigned steps = 20, repeat = 3;
+
+template< size_t n>
+double ms_per_step( const Blueprint& bp)
+{
+    const Algorithmic& alg = bp.algorithmic();
+    std::unique_ptr<Solver> solver = make_solver<n>( bp);
+    Matrix<double, TL_NONE> ne( alg.ny, alg.nx, 0.), nz( ne), phi( ne);
+    init_gaussian( ne, 0.4, 0.55, 0.1, 0.1, 0.5);
+    init_gaussian( nz, 0.6, 0.45, 0.1, 0.1, 0.3);
+    std::vector< Matrix<double, TL_NONE> > v{ ne, phi};
+    if( n == 3)
+        v.insert( v.begin() + 1, nz);
+    solver->init( v, TL_IONS);
+    solver->first_step();
+    solver->second_step();
+    solver->step( steps); //warm up
+    Timer t;
+    double best = 1e300;
+    for( unsigned r=0; r<repeat; r++)
+    {
+        t.tic();
+        solver->step( steps);
+        t.toc();
+        best = std::min( best, t.diff());
+    }
+    return 1e3*best/(double)steps;
+}
+
+template< size_t n>
+void benchmark( const Blueprint& bp, const int max_threads)
+{
+    cout << n << " species on "<<bp.algorithmic().nx<<"x"<<bp.algorithmic().ny<<" points\n";
+    cout << setw(8)<<"threads"<<setw(14)<<"ms/step"<<setw(14)<<"task graph"<<setw(10)<<"speedup"<<"\n";
+    Blueprint graph( bp);
+    graph.enable( TL_TASK_GRAPH);
+    for( int threads = 1; threads <= max_threads; threads *= 2)
+    {
+        omp_set_num_threads( threads);
+        const double loops = ms_per_step<n>( bp);
+        const double tasks = ms_per_step<n>( graph);
+        cout << setw(8)<<threads<<setw(14)<<loops<<setw(14)<<tasks<<setw(10)<<loops/tasks<<"\n";
+    }
+}
+
+int main( int argc, char* argv[])
+{
+    if( argc > 3)
+    {
+        cerr << "ERROR: Too many arguments!\nUsage: "<< argv[0]<<" [inputfile [max threads]]\n";
+        return -1;
+    }
+    std::vector<double> para;
+    try{ para = file::read_input( argc > 1 ? argv[1] : "input/default.in"); }
+    catch (Message& m) {  m.display(); return -1;}
+    const int max_threads = argc > 2 ? atoi( argv[2]) : omp_get_num_procs();
+    cout << "Up to "<<max_threads<<" threads, best of "<<repeat<<" runs of "<<steps<<" steps\n";
+    try{
+        para[13] = 0; //no impurities
+        benchmark<2>( Blueprint( para), max_threads);
+        para[13] = 1;
+        benchmark<3>( Blueprint( para), max_threads);
+    }
+    catch( Message& m) { m.display(); return -1;}
+    return 0;
+}
@@ -0,0 +1,160 @@
+#include <iostream>
+#include <sstream>
+#include "file/read_input.h"
+#include "solver.h"
+
+using namespace std;
+using namespace spectral;
+
+//the factory solver must compute the same as the solver it wraps
+int main( int argc, char* argv[])
+{
+    vector<double> para;
+    try{ para = file::read_input( argc > 1 ? argv[1] : "input/default.in"); }
+    catch (Message& m) {  m.display(); return -1;}
+    Blueprint bp( para);
+    const Algorithmic& alg = bp.algorithmic();
+    cout << "Test whether the factory solver equals the DFT_DFT_Solver...\n";
+    std::unique_ptr<Solver> solver = make_solver( bp);
+    DFT_DFT_Solver<2> dft( bp);
+    Matrix<double, TL_NONE> ne( alg.ny, alg.nx, 0.), phi( ne);
+    Matrix<double, TL_DFT> ne_( alg.ny, alg.nx, 0.), phi_( ne_);
+    init_gaussian( ne, 0.5, 0.5, 0.1, 0.1, 0.5);
+    init_gaussian( ne_, 0.5, 0.5, 0.1, 0.1, 0.5);
+    std::vector< Matrix<double, TL_NONE> > v{ ne, phi};
+    std::array< Matrix<double, TL_DFT>, 2> arr{{ ne_, phi_}};
+    solver->init( v, TL_IONS);
+    dft.init( arr, TL_IONS);
+    solver->first_step(), solver->second_step(), solver->step( 5);
+    dft.first_step(), dft.second_step(), dft.step( 5);
+    cout << ( solver->copyField( TL_POTENTIAL) == dft.getField( TL_POTENTIAL).copy() ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    cout << "Test whether fields of the wrong size are rejected...\n";
+    {
+        std::vector< Matrix<double, TL_NONE> > w{ ne, Matrix<double, TL_NONE>( alg.ny, alg.nx/2, 0.)};
+        try{ make_solver( bp)->init( w, TL_IONS); cout << "TEST FAILED!\n";}
+        catch( Message& m){ m.display(); cout << "TEST PASSED!\n";}
+    }
+    cout << "Test whether set_physical equals a solver constructed with the new parameters...\n";
+    Blueprint bp2( bp);
+    bp2.physical().nu *= 2., bp2.physical().kappa += 0.0001, bp2.physical().tau[0] = 1.;
+    for( unsigned b=0; b<2; b++)
+    {
+        bp.boundary().bc_x = bp2.boundary().bc_x = ( b == 0) ? TL_PERIODIC : TL_DST10;
+        std::unique_ptr<Solver> changed = make_solver( bp), fresh = make_solver( bp2);
+        std::vector< Matrix<double, TL_NONE> > v1( v), v2( v);
+        changed->set_physical( bp2.physical());
+        changed->init( v1, TL_IONS), fresh->init( v2, TL_IONS);
+        changed->first_step(), changed->second_step(), changed->step( 3);
+        fresh->first_step(), fresh->second_step(), fresh->step( 3);
+        cout << ( changed->copyField( TL_POTENTIAL) == fresh->copyField( TL_POTENTIAL) ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether set_physical with the same parameters keeps the run...\n";
+    for( unsigned b=0; b<2; b++)
+    {
+        bp.boundary().bc_x = ( b == 0) ? TL_PERIODIC : TL_DST10;
+        std::unique_ptr<Solver> changed = make_solver( bp), fresh = make_solver( bp);
+        std::vector< Matrix<double, TL_NONE> > v1( v), v2( v);
+        changed->init( v1, TL_IONS), fresh->init( v2, TL_IONS);
+        changed->first_step(), changed->second_step(), changed->step( 3);
+        fresh->first_step(), fresh->second_step(), fresh->step( 3);
+        changed->set_physical( bp.physical());
+        changed->step( 3), fresh->step( 3);
+        std::vector<double> x = changed->copyField( TL_POTENTIAL), y = fresh->copyField( TL_POTENTIAL);
+        double diff = 0, max = 0;
+        for( unsigned i=0; i<x.size(); i++)
+            diff = std::max( diff, fabs( x[i] - y[i])), max = std::max( max, fabs( y[i]));
+        cout << "Relative difference "<<diff/max<<"\n";
+        cout << ( diff < 1e-12*max ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether resampling to a finer grid and back keeps the run...\n";
+    {
+        bp.boundary().bc_x = TL_PERIODIC;
+        Blueprint fine_bp( bp);
+        fine_bp.algorithmic().nx *= 2, fine_bp.algorithmic().ny *= 2, fine_bp.algorithmic().h /= 2.;
+        DFT_DFT_Solver<2> coarse( bp), fine( fine_bp), back( bp);
+        std::array< Matrix<double, TL_DFT>, 2> a{{ ne_, phi_}};
+        coarse.init( a, TL_IONS);
+        coarse.first_step(), coarse.second_step(), coarse.step( 3);
+        fine.resample( coarse);
+        back.resample( fine);
+        const Matrix<double, TL_DFT>& x = back.getField( TL_ELECTRONS), &y = coarse.getField( TL_ELECTRONS);
+        double diff = 0, max = 0;
+        for( size_t i=0; i<alg.ny; i++)
+            for( size_t j=0; j<alg.nx; j++)
+                diff = std::max( diff, fabs( x(i,j) - y(i,j))), max = std::max( max, fabs( y(i,j)));
+        cout << "Relative difference "<<diff/max<<" (top shell "<<coarse.top_shell()<<")\n";
+        fine.step( 3);
+        cout << ( diff < 1e-10*max && fine.top_shell() < 1e-2 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether a checkpoint with a different history layout is rejected...\n";
+    for( unsigned c=0; c<2; c++)
+    {
+        Blueprint other( bp);
+        other.enable( c == 0 ? TL_ETDRK : TL_FLOAT_HISTORY);
+        DFT_DFT_Solver<2> written( other), read( bp);
+        std::array< Matrix<double, TL_DFT>, 2> a{{ ne_, phi_}};
+        written.init( a, TL_IONS);
+        written.first_step(), written.second_step();
+        stringstream ss( ios::in|ios::out|ios::binary);
+        written.checkpoint( ss, 1.);
+        try{ read.restart( ss); cout << "TEST FAILED!\n";}
+        catch( Message& m){ m.display(); cout << "TEST PASSED!\n";}
+    }
+    cout << "Test whether a checkpoint written before second_step() is rejected...\n";
+    for( unsigned c=0; c<2; c++)
+    {
+        DFT_DFT_Solver<2> written( bp), read( bp);
+        std::array< Matrix<double, TL_DFT>, 2> a{{ ne_, phi_}};
+        written.init( a, TL_IONS);
+        if( c == 1) written.first_step();
+        stringstream ss( ios::in|ios::out|ios::binary);
+        written.checkpoint( ss, 1.);
+        try{ read.restart( ss); cout << "TEST FAILED!\n";}
+        catch( Message& m){ m.display(); cout << "TEST PASSED!\n";}
+    }
+    cout << "Test whether step() and step( N) continue a CFL controlled run...\n";
+    {
+        bp.boundary().bc_x = TL_PERIODIC;
+        Blueprint adaptive( bp);
+        adaptive.enable( TL_ADAPTIVE_DT);
+        //with dt_max below dt and a large Courant number the first call changes dt to dt_max for good
+        const double cfl = 1e10, dt_max = 0.7*alg.dt;
+        DFT_DFT_Solver<2> cfl_only( adaptive), mixed( adaptive), mixed_n( adaptive);
+        std::array< Matrix<double, TL_DFT>, 2> a1{{ ne_, phi_}}, a2( a1), a3( a1);
+        cfl_only.init( a1, TL_IONS), mixed.init( a2, TL_IONS), mixed_n.init( a3, TL_IONS);
+        cfl_only.first_step(), cfl_only.second_step();
+        mixed.first_step(), mixed.second_step();
+        mixed_n.first_step(), mixed_n.second_step();
+        double dt = 0;
+        for( unsigned s=0; s<6; s++)
+            dt = cfl_only.step( cfl, dt_max);
+        mixed.step( cfl, dt_max);
+        for( unsigned s=1; s<6; s++)
+            mixed.step();
+        mixed_n.step( cfl, dt_max), mixed_n.step( 5);
+        cout << "Timestep "<<dt<<"\n";
+        const std::vector<double> x = cfl_only.getField( TL_POTENTIAL).copy();
+        cout << ( dt == dt_max && mixed.getField( TL_POTENTIAL).copy() == x && mixed_n.getField( TL_POTENTIAL).copy() == x ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether the potential of ions without gyro-average is the electron potential...\n";
+    for( unsigned t=0; t<2; t++)
+    {
+        bp.boundary().bc_x = TL_PERIODIC;
+        Blueprint cold( bp);
+        cold.physical().tau[0] = 0;
+        if( t == 1) cold.enable( TL_TASK_GRAPH);
+        DFT_DFT_Solver<2> solver( cold);
+        std::array< Matrix<double, TL_DFT>, 2> a{{ ne_, phi_}};
+        solver.init( a, TL_IONS);
+        solver.first_step(), solver.second_step(), solver.step( 3);
+        const bool stepN = solver.getPotential()[1] == solver.getPotential()[0];
+        solver.step();
+        cout << ( stepN && solver.getPotential()[1] == solver.getPotential()[0] ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    }
+    cout << "Test whether the factory chooses the solver of the blueprint...\n";
+    bp.boundary().bc_x = TL_DST10;
+    std::unique_ptr<Solver> drt = make_solver( bp);
+    typedef SolverAdapter< DRT_DFT_Solver<2>, 2, TL_DRT_DFT> DRT;
+    cout << ( dynamic_cast< DRT*>( drt.get()) && drt->size() == 2 ? "TEST PASSED!\n" : "TEST FAILED!\n");
+    return 0;
+}